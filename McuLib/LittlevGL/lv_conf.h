@@ -35,6 +35,9 @@
 #ifndef LV_CONFIG_COLOR_16_SWAP
   #define LV_CONFIG_COLOR_16_SWAP        (0)
 #endif
+#ifndef LV_CONFIG_TICK_CUSTOM
+  #define LV_CONFIG_TICK_CUSTOM          (0)
+#endif
 
 /* Maximal horizontal and vertical resolution to support by the library.*/
 #define LV_HOR_RES_MAX          (LV_CONFIG_DISPLAY_WIDTH)
@@ -169,7 +172,7 @@ typedef void * lv_fs_drv_user_data_t;
 #endif
 
 /*1: Add a `user_data` to drivers and objects*/
-#define LV_USE_USER_DATA        0
+#define LV_USE_USER_DATA        1
 
 /*========================
  * Image decoder and cache
@@ -216,10 +219,10 @@ typedef void * lv_img_decoder_user_data_t;
 
 /* 1: use a custom tick source.
  * It removes the need to manually update the tick with `lv_tick_inc`) */
-#define LV_TICK_CUSTOM     0
+#define LV_TICK_CUSTOM     LV_CONFIG_TICK_CUSTOM
 #if LV_TICK_CUSTOM == 1
-#define LV_TICK_CUSTOM_INCLUDE  "something.h"       /*Header for the sys time function*/
-#define LV_TICK_CUSTOM_SYS_TIME_EXPR (millis())     /*Expression evaluating to current systime in ms*/
+#define LV_TICK_CUSTOM_INCLUDE  "McuRTOS.h"         /*Header for the sys time function*/
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR ((uint32_t)(((uint64_t)xTaskGetTickCount()*1000U)/configTICK_RATE_HZ)) /*Expression evaluating to current systime in ms*/
 #endif   /*LV_TICK_CUSTOM*/
 
 typedef void * lv_disp_drv_user_data_t;             /*Type of user data in the display driver*/
@@ -333,7 +336,7 @@ typedef void * lv_font_user_data_t;
  *==================*/
 
 /*Declare the type of the user data of object (can be e.g. `void *`, `int`, `struct`)*/
-typedef void * lv_obj_user_data_t;
+typedef uint16_t lv_obj_user_data_t; /* packed index of a control, see GUI_EQ_CTRL() in gui.c */
 
 /*1: enable `lv_obj_realaign()` based on `lv_obj_align()` parameters*/
 #define LV_USE_OBJ_REALIGN          1
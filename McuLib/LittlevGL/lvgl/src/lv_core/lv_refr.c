@@ -34,6 +34,8 @@
  *  STATIC PROTOTYPES
  **********************/
 static void lv_refr_join_area(void);
+static uint32_t lv_refr_area_cost(const lv_area_t * area_p);
+static bool lv_refr_join_is_better(const lv_area_t * a1, const lv_area_t * a2, const lv_area_t * joined);
 static void lv_refr_areas(void);
 static void lv_refr_area(const lv_area_t * area_p);
 static void lv_refr_area_part(const lv_area_t * area_p);
@@ -131,6 +133,11 @@ void lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
             lv_area_copy(&disp->inv_areas[disp->inv_p], &scr_area);
         }
         disp->inv_p++;
+
+        /*Wake up the refresh task if it was stopped because there was nothing to redraw*/
+        if(disp->refr_task && disp->refr_task->prio == LV_TASK_PRIO_OFF) {
+            lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);
+        }
     }
 }
 
@@ -183,8 +190,9 @@ void lv_disp_refr_task(lv_task_t * task)
             /* With true double buffering the flushing should be only the address change of the
              * current frame buffer. Wait until the address change is ready and copy the changed
              * content to the other frame buffer (new active VDB) to keep the buffers synchronized*/
-            while(vdb->flushing)
-                ;
+            while(vdb->flushing) {
+                if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
+            }
 
             uint8_t * buf_act = (uint8_t *)vdb->buf_act;
             uint8_t * buf_ina = (uint8_t *)vdb->buf_act == vdb->buf1 ? vdb->buf2 : vdb->buf1;
@@ -219,6 +227,9 @@ void lv_disp_refr_task(lv_task_t * task)
 
     lv_draw_free_buf();
 
+    /*Nothing is left to redraw: stop the task until `lv_inv_area` wakes it up again*/
+    if(disp_refr->inv_p == 0) lv_task_set_prio(task, LV_TASK_PRIO_OFF);
+
     LV_LOG_TRACE("lv_refr_task: ready");
 }
 
@@ -244,16 +255,10 @@ static void lv_refr_join_area(void)
                 continue;
             }
 
-            /*Check if the areas are on each other*/
-            if(lv_area_is_on(&disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from]) == false) {
-                continue;
-            }
-
             lv_area_join(&joined_area, &disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from]);
 
-            /*Join two area only if the joined area size is smaller*/
-            if(lv_area_get_size(&joined_area) < (lv_area_get_size(&disp_refr->inv_areas[join_in]) +
-                                                 lv_area_get_size(&disp_refr->inv_areas[join_from]))) {
+            /*Join two area only if the joined area is cheaper to refresh*/
+            if(lv_refr_join_is_better(&disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from], &joined_area)) {
                 lv_area_copy(&disp_refr->inv_areas[join_in], &joined_area);
 
                 /*Mark 'join_form' is joined into 'join_in'*/
@@ -263,6 +268,49 @@ static void lv_refr_join_area(void)
     }
 }
 
+/**
+ * Decide if two areas should be joined
+ * @param a1 pointer to the first area
+ * @param a2 pointer to the second area
+ * @param joined pointer to the area covering both
+ * @return true: refresh 'joined' instead of 'a1' and 'a2'
+ */
+static bool lv_refr_join_is_better(const lv_area_t * a1, const lv_area_t * a2, const lv_area_t * joined)
+{
+    lv_disp_drv_t * drv = &disp_refr->driver;
+
+    if(drv->join_cb) return drv->join_cb(drv, a1, a2, joined);
+
+    /*Without a cost model join only the areas which are on each other*/
+    if(drv->flush_cost == 0 && drv->px_cost == 0) {
+        if(lv_area_is_on(a1, a2) == false) return false;
+        return lv_area_get_size(joined) < lv_area_get_size(a1) + lv_area_get_size(a2);
+    }
+
+    return lv_refr_area_cost(joined) < lv_refr_area_cost(a1) + lv_refr_area_cost(a2);
+}
+
+/**
+ * Estimate the cost to flush an area: it's flushed in bands of the VDB size (see `lv_refr_area`)
+ * @param area_p pointer to an area
+ * @return cost in the unit of `flush_cost` and `px_cost`
+ */
+static uint32_t lv_refr_area_cost(const lv_area_t * area_p)
+{
+    lv_disp_drv_t * drv = &disp_refr->driver;
+    uint32_t px         = lv_area_get_size(area_p);
+    uint32_t flush_num  = 1;
+
+    if(lv_disp_is_true_double_buf(disp_refr) == false) {
+        lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
+        uint32_t max_row    = vdb->size / lv_area_get_width(area_p);
+        if(max_row == 0) max_row = 1;
+        flush_num = (lv_area_get_height(area_p) + max_row - 1) / max_row;
+    }
+
+    return flush_num * drv->flush_cost + px * drv->px_cost;
+}
+
 /**
  * Refresh the joined areas
  */
@@ -379,12 +427,15 @@ static void lv_refr_area_part(const lv_area_t * area_p)
     /*In non double buffered mode, before rendering the next part wait until the previous image is
      * flushed*/
     if(lv_disp_is_double_buf(disp_refr) == false) {
-        while(vdb->flushing)
-            ;
+        while(vdb->flushing) {
+            if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
+        }
     }
 
     lv_obj_t * top_p;
 
+    vdb->fill_pending = 0;
+
     /*Get the new mask from the original area and the act. VDB
      It will be a part of 'area_p'*/
     lv_area_t start_mask;
@@ -564,15 +615,22 @@ static void lv_refr_vdb_flush(void)
     /*In double buffered mode wait until the other buffer is flushed before flushing the current
      * one*/
     if(lv_disp_is_double_buf(disp_refr)) {
-        while(vdb->flushing)
-            ;
+        while(vdb->flushing) {
+            if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
+        }
     }
 
     vdb->flushing = 1;
 
     /*Flush the rendered content to the display*/
     lv_disp_t * disp = lv_refr_get_disp_refreshing();
-    if(disp->driver.flush_cb) disp->driver.flush_cb(&disp->driver, &vdb->area, vdb->buf_act);
+    if(vdb->fill_pending && disp->driver.fill_cb) {
+        /*Only a fill was drawn: let the driver fill the area, the buffer was not written*/
+        vdb->fill_pending = 0;
+        disp->driver.fill_cb(&disp->driver, &vdb->area, vdb->fill_color);
+    } else if(disp->driver.flush_cb) {
+        disp->driver.flush_cb(&disp->driver, &vdb->area, vdb->buf_act);
+    }
 
     if(vdb->buf1 && vdb->buf2) {
         if(vdb->buf_act == vdb->buf1)
@@ -19,6 +19,8 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+/*Priority of the display refresh task while there are invalid areas*/
+#define LV_REFR_TASK_PRIO LV_TASK_PRIO_MID
 
 /**********************
  *      TYPEDEFS
@@ -42,6 +42,7 @@
  *  STATIC PROTOTYPES
  **********************/
 static void sw_mem_blend(lv_color_t * dest, const lv_color_t * src, uint32_t length, lv_opa_t opa);
+static void vdb_apply_fill(lv_disp_buf_t * vdb);
 static void sw_color_fill(lv_color_t * mem, lv_coord_t mem_width, const lv_area_t * fill_area, lv_color_t color,
                           lv_opa_t opa);
 
@@ -84,6 +85,8 @@ void lv_draw_px(lv_coord_t x, lv_coord_t y, const lv_area_t * mask_p, lv_color_t
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
     uint32_t vdb_width  = lv_area_get_width(&vdb->area);
 
+    vdb_apply_fill(vdb);
+
     /*Make the coordinates relative to VDB*/
     x -= vdb->area.x1;
     y -= vdb->area.y1;
@@ -141,6 +144,17 @@ void lv_draw_fill(const lv_area_t * cords_p, const lv_area_t * mask_p, lv_color_
     lv_disp_t * disp    = lv_refr_get_disp_refreshing();
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
 
+    /*An opaque fill of the whole VDB doesn't need to be rendered if the driver can fill the display directly.
+     *It's only noted and written to the VDB if something else is drawn on it.*/
+    if(opa == LV_OPA_COVER && disp->driver.fill_cb && disp->driver.set_px_cb == NULL &&
+       lv_disp_is_true_double_buf(disp) == false && res_a.x1 == vdb->area.x1 && res_a.y1 == vdb->area.y1 &&
+       res_a.x2 == vdb->area.x2 && res_a.y2 == vdb->area.y2) {
+        vdb->fill_pending = 1;
+        vdb->fill_color   = color;
+        return;
+    }
+    vdb_apply_fill(vdb);
+
     lv_area_t vdb_rel_a; /*Stores relative coordinates on vdb*/
     vdb_rel_a.x1 = res_a.x1 - vdb->area.x1;
     vdb_rel_a.y1 = res_a.y1 - vdb->area.y1;
@@ -289,6 +303,8 @@ void lv_draw_letter(const lv_point_t * pos_p, const lv_area_t * mask_p, const lv
     lv_disp_t * disp    = lv_refr_get_disp_refreshing();
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
 
+    vdb_apply_fill(vdb);
+
     lv_coord_t vdb_width     = lv_area_get_width(&vdb->area);
     lv_color_t * vdb_buf_tmp = vdb->buf_act;
     lv_coord_t col, row;
@@ -416,6 +432,8 @@ void lv_draw_map(const lv_area_t * cords_p, const lv_area_t * mask_p, const uint
     lv_disp_t * disp    = lv_refr_get_disp_refreshing();
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
 
+    vdb_apply_fill(vdb);
+
     /*Stores coordinates relative to the current VDB*/
     masked_a.x1 = masked_a.x1 - vdb->area.x1;
     masked_a.y1 = masked_a.y1 - vdb->area.y1;
@@ -576,6 +594,24 @@ static void sw_mem_blend(lv_color_t * dest, const lv_color_t * src, uint32_t len
     }
 }
 
+/**
+ * Write a pending fill (see `lv_draw_fill`) to the VDB before something else is drawn on it
+ * @param vdb pointer to its VDB
+ */
+static void vdb_apply_fill(lv_disp_buf_t * vdb)
+{
+    if(vdb->fill_pending == 0) return;
+
+    lv_area_t vdb_rel_a;
+    vdb_rel_a.x1 = 0;
+    vdb_rel_a.y1 = 0;
+    vdb_rel_a.x2 = lv_area_get_width(&vdb->area) - 1;
+    vdb_rel_a.y2 = lv_area_get_height(&vdb->area) - 1;
+
+    vdb->fill_pending = 0;
+    sw_color_fill(vdb->buf_act, lv_area_get_width(&vdb->area), &vdb_rel_a, vdb->fill_color, LV_OPA_COVER);
+}
+
 /**
  * Fill an area with a color
  * @param mem a memory address. Considered to a rectangular window according to 'mem_area'
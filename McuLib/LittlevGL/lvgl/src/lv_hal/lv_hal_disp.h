@@ -54,6 +54,8 @@ typedef struct
     uint32_t size; /*In pixel count*/
     lv_area_t area;
     volatile uint32_t flushing : 1;
+    uint8_t fill_pending; /*The whole area is filled with `fill_color` but it's not written to the buffer yet*/
+    lv_color_t fill_color;
 } lv_disp_buf_t;
 
 /**
@@ -84,6 +86,20 @@ typedef struct _disp_drv_t
      * called when finished */
     void (*flush_cb)(struct _disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
 
+    /** OPTIONAL: Fill an area of the display with a color. Used instead of `flush_cb` if the buffer contains only
+     * an opaque fill, so it doesn't need to be rasterized. 'lv_disp_flush_ready()' has to be called when finished */
+    void (*fill_cb)(struct _disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t color);
+
+    /** OPTIONAL: Decide if two invalidated areas should be refreshed as one ('joined' covers both).
+     * Return true to join them. If not set the areas are joined according to `flush_cost` and `px_cost`*/
+    bool (*join_cb)(struct _disp_drv_t * disp_drv, const lv_area_t * a1, const lv_area_t * a2,
+                    const lv_area_t * joined);
+
+    /** Cost model for joining the invalidated areas, in any unit (e.g. CPU cycles): fixed cost of a `flush_cb` call
+     * and cost of one pixel. With both 0 only overlapping areas are joined if it reduces the number of pixels*/
+    uint32_t flush_cost;
+    uint32_t px_cost;
+
     /** OPTIONAL: Extend the invalidated areas to match with the display drivers requirements
      * E.g. round `y` to, 8, 16 ..) on a monochrome display*/
     void (*rounder_cb)(struct _disp_drv_t * disp_drv, lv_area_t * area);
@@ -98,6 +114,10 @@ typedef struct _disp_drv_t
      * number of flushed pixels */
     void (*monitor_cb)(struct _disp_drv_t * disp_drv, uint32_t time, uint32_t px);
 
+    /** OPTIONAL: Called periodically while LittlevGL waits for the flushing to be finished
+     * E.g. to measure the waiting time or to block the task until `lv_disp_flush_ready()` gets called */
+    void (*wait_cb)(struct _disp_drv_t * disp_drv);
+
 #if LV_USE_GPU
     /** OPTIONAL: Blend two memories using opacity (GPU only)*/
     void (*gpu_blend_cb)(struct _disp_drv_t * disp_drv, lv_color_t * dest, const lv_color_t * src, uint32_t length,
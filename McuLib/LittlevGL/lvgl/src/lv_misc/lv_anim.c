@@ -41,6 +41,7 @@ static bool anim_ready_handler(lv_anim_t * a);
  **********************/
 static uint32_t last_task_run;
 static bool anim_list_changed;
+static lv_task_t * anim_task_p;
 
 /**********************
  *      MACROS
@@ -57,7 +58,7 @@ void lv_anim_core_init(void)
 {
     lv_ll_init(&LV_GC_ROOT(_lv_anim_ll), sizeof(lv_anim_t));
     last_task_run = lv_tick_get();
-    lv_task_create(anim_task, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_MID, NULL);
+    anim_task_p = lv_task_create(anim_task, LV_DISP_DEF_REFR_PERIOD, LV_TASK_PRIO_OFF, NULL);
 }
 
 /**
@@ -99,6 +100,12 @@ void lv_anim_create(lv_anim_t * a)
     /*Set the start value*/
     if(new_anim->exec_cb) new_anim->exec_cb(new_anim->var, new_anim->start);
 
+    /*Resume the animation task if it was stopped because there was nothing to animate*/
+    if(anim_task_p && anim_task_p->prio == LV_TASK_PRIO_OFF) {
+        last_task_run = lv_tick_get();
+        lv_task_set_prio(anim_task_p, LV_TASK_PRIO_MID);
+    }
+
     /* Creating an animation changed the linked list.
      * It's important if it happens in a ready callback. (see `anim_task`)*/
     anim_list_changed = true;
@@ -423,6 +430,9 @@ static void anim_task(lv_task_t * param)
     }
 
     last_task_run = lv_tick_get();
+
+    /*Stop the task until the next animation is created*/
+    if(lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll)) == NULL) lv_task_set_prio(param, LV_TASK_PRIO_OFF);
 }
 
 /**
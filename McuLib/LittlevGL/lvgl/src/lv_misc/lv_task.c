@@ -61,14 +61,16 @@ void lv_task_core_init(void)
 
 /**
  * Call it  periodically to handle lv_tasks.
+ * @return time until the next task is due [ms], 0 if a task is already due
+ *         or `LV_NO_TASK_READY` if every task is stopped
  */
-LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
+LV_ATTRIBUTE_TASK_HANDLER uint32_t lv_task_handler(void)
 {
     LV_LOG_TRACE("lv_task_handler started");
 
     /*Avoid concurrent running of the task handler*/
     static bool task_handler_mutex = false;
-    if(task_handler_mutex) return;
+    if(task_handler_mutex) return 0;
     task_handler_mutex = true;
 
     static uint32_t idle_period_start = 0;
@@ -77,7 +79,7 @@ LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
 
     if(lv_task_run == false) {
         task_handler_mutex = false; /*Release mutex*/
-        return;
+        return LV_NO_TASK_READY;
     }
 
     handler_start = lv_tick_get();
@@ -153,9 +155,27 @@ LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
         idle_period_start = lv_tick_get();
     }
 
+    /*Find the earliest deadline among the running tasks so the caller can sleep until then*/
+    uint32_t time_till_next = LV_NO_TASK_READY;
+    lv_task_t * task;
+    LV_LL_READ(LV_GC_ROOT(_lv_task_ll), task)
+    {
+        /*The tasks are ordered by priority so only stopped tasks follow*/
+        if(task->prio == LV_TASK_PRIO_OFF) break;
+
+        uint32_t elp = lv_tick_elaps(task->last_run);
+        if(elp >= task->period) {
+            time_till_next = 0;
+            break;
+        }
+        if(task->period - elp < time_till_next) time_till_next = task->period - elp;
+    }
+
     task_handler_mutex = false; /*Release the mutex*/
 
     LV_LOG_TRACE("lv_task_handler ready");
+
+    return time_till_next;
 }
 /**
  * Create an "empty" task. It needs to initialzed with at least
@@ -31,6 +31,9 @@ extern "C" {
 #ifndef LV_ATTRIBUTE_TASK_HANDLER
 #define LV_ATTRIBUTE_TASK_HANDLER
 #endif
+
+/*Returned by `lv_task_handler` if no task will become ready on its own*/
+#define LV_NO_TASK_READY 0xFFFFFFFF
 /**********************
  *      TYPEDEFS
  **********************/
@@ -84,8 +87,10 @@ void lv_task_core_init(void);
 
 /**
  * Call it  periodically to handle lv_tasks.
+ * @return time until the next task is due [ms], 0 if a task is already due
+ *         or `LV_NO_TASK_READY` if every task is stopped
  */
-LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void);
+LV_ATTRIBUTE_TASK_HANDLER uint32_t lv_task_handler(void);
 
 //! @endcond
 
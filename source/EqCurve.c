@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Frequency response of the EQ, drawn from the coefficients of the biquad cascade in EqDsp. The response of each band
+ * is kept per point in dB, so a gain change evaluates only the band which changed: with the table of cos and sin at
+ * each point this is a few multiply-adds, a division and a logarithm per point. The curve is drawn as one column per
+ * point by the design function of a plain object, and an update invalidates only runs of columns which changed.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_EQ_CURVE
+#include "EqCurve.h"
+#include "EqDsp.h"
+#include "lv.h"
+#include <math.h>
+#include <string.h>
+
+#define EQCURVE_MIN_HZ     (20.0f)
+#define EQCURVE_MAX_HZ     (20000.0f)
+
+typedef struct {
+  float cos1, sin1; /* of w, the frequency of the point in radians per sample */
+  float cos2, sin2; /* of 2w */
+} EqCurve_Point_t;
+
+static EqCurve_Point_t points[EQCURVE_CONFIG_NOF_POINTS]; /* computed once */
+static bool pointsValid;
+
+static struct {
+  lv_obj_t *obj;
+  lv_design_cb_t ancestorDesign;
+  lv_coord_t colWidth; /* pixels per point */
+  lv_coord_t zeroY; /* row of 0 dB */
+  int32_t coeffs[EQDSP_NOF_COEFFS]; /* evaluated, compared with the ones of EqDsp */
+  float bandDb[EQDSP_NOF_BANDS][EQCURVE_CONFIG_NOF_POINTS]; /* response of each band */
+  lv_coord_t y[EQCURVE_CONFIG_NOF_POINTS]; /* row of each point, as drawn */
+} curve;
+
+#if PL_CONFIG_USE_BENCH
+static GUI_EqCurve_Stats_t stats;
+#endif
+
+static lv_style_t lineStyle, gridStyle;
+
+static void GUI_EqCurve_InitPoints(void) {
+  float ratio = powf(EQCURVE_MAX_HZ/EQCURVE_MIN_HZ, 1.0f/(EQCURVE_CONFIG_NOF_POINTS-1));
+  float hz = EQCURVE_MIN_HZ, w;
+
+  for(int i=0; i<EQCURVE_CONFIG_NOF_POINTS; i++) {
+    w = 2.0f*3.14159265f*hz/EQDSP_CONFIG_SAMPLE_RATE;
+    points[i].cos1 = cosf(w);
+    points[i].sin1 = sinf(w);
+    points[i].cos2 = cosf(2.0f*w);
+    points[i].sin2 = sinf(2.0f*w);
+    hz *= ratio;
+  }
+  pointsValid = true;
+}
+
+static void GUI_EqCurve_EvalBand(int band, const int32_t *c) {
+  /* |H(e^jw)|^2 of b0+b1*z^-1+b2*z^-2 over 1-a1*z^-1-a2*z^-2, with a1 and a2 as stored for CMSIS-DSP */
+  const float scale = (float)(1<<EQDSP_POST_SHIFT)/2147483648.0f;
+  float b0 = c[0]*scale, b1 = c[1]*scale, b2 = c[2]*scale, a1 = c[3]*scale, a2 = c[4]*scale;
+  float nr, ni, dr, di;
+  const EqCurve_Point_t *p = points;
+
+  for(int i=0; i<EQCURVE_CONFIG_NOF_POINTS; i++, p++) {
+    nr = b0+b1*p->cos1+b2*p->cos2;
+    ni = b1*p->sin1+b2*p->sin2;
+    dr = 1.0f-a1*p->cos1-a2*p->cos2;
+    di = a1*p->sin1+a2*p->sin2;
+    curve.bandDb[band][i] = 10.0f*log10f((nr*nr+ni*ni)/(dr*dr+di*di));
+  }
+}
+
+static lv_coord_t GUI_EqCurve_DbToRow(float db) {
+  int32_t row = curve.zeroY-(int32_t)lroundf(db*curve.zeroY/EQCURVE_CONFIG_RANGE_DB);
+
+  if (row<0) {
+    return 0;
+  } else if (row>2*curve.zeroY) {
+    return 2*curve.zeroY;
+  }
+  return (lv_coord_t)row;
+}
+
+static void GUI_EqCurve_GetRows(lv_coord_t *rows) {
+  float db;
+
+  for(int i=0; i<EQCURVE_CONFIG_NOF_POINTS; i++) {
+    db = 0.0f;
+    for(int b=0; b<EQDSP_NOF_BANDS; b++) {
+      db += curve.bandDb[b][i]; /* the cascade multiplies the responses */
+    }
+    rows[i] = GUI_EqCurve_DbToRow(db);
+  }
+}
+
+static void GUI_EqCurve_GetColumnArea(int i, lv_coord_t y0, lv_coord_t y1, lv_area_t *area) {
+  /* column of point i, from row y0 to row y1, the line is 2 pixels thick */
+  lv_obj_get_coords(curve.obj, area);
+  area->x1 += i*curve.colWidth;
+  area->x2 = area->x1+curve.colWidth-1;
+  area->y2 = area->y1+(y0>y1 ? y0 : y1)+1;
+  area->y1 += y0<y1 ? y0 : y1;
+}
+
+static bool GUI_EqCurve_Design(lv_obj_t *obj, const lv_area_t *mask, lv_design_mode_t mode) {
+  lv_area_t coords, area;
+  lv_opa_t opa;
+  int first, last;
+
+  if (mode!=LV_DESIGN_DRAW_MAIN) {
+    return curve.ancestorDesign(obj, mask, mode);
+  }
+  (void)curve.ancestorDesign(obj, mask, mode); /* background */
+  lv_obj_get_coords(obj, &coords);
+  opa = lv_obj_get_opa_scale(obj);
+  area = coords;
+  area.y1 += curve.zeroY;
+  area.y2 = area.y1;
+  lv_draw_rect(&area, mask, &gridStyle, opa); /* 0 dB */
+  /* only the columns inside the mask, each connects the previous point with its own */
+  first = (mask->x1-coords.x1)/curve.colWidth;
+  last = (mask->x2-coords.x1)/curve.colWidth;
+  if (first<0) {
+    first = 0;
+  }
+  if (last>=EQCURVE_CONFIG_NOF_POINTS) {
+    last = EQCURVE_CONFIG_NOF_POINTS-1;
+  }
+  for(int i=first; i<=last; i++) {
+    GUI_EqCurve_GetColumnArea(i, curve.y[i>0 ? i-1 : 0], curve.y[i], &area);
+    lv_draw_rect(&area, mask, &lineStyle, opa);
+  }
+  return true;
+}
+
+static void GUI_EqCurve_Invalidate(int first, int last, const lv_coord_t *newY) {
+  /* points first..last changed: their columns and the one after, spanning the old and new rows of the neighbours */
+  lv_coord_t top = LV_COORD_MAX, bottom = 0;
+  lv_area_t area;
+
+  if (last<EQCURVE_CONFIG_NOF_POINTS-1) {
+    last++;
+  }
+  for(int i=(first>0 ? first-1 : 0); i<=last; i++) {
+    top = LV_MATH_MIN(top, LV_MATH_MIN(curve.y[i], newY[i]));
+    bottom = LV_MATH_MAX(bottom, LV_MATH_MAX(curve.y[i], newY[i]));
+  }
+  GUI_EqCurve_GetColumnArea(first, top, bottom, &area);
+  area.x2 += (last-first)*curve.colWidth;
+  lv_inv_area(lv_obj_get_disp(curve.obj), &area);
+#if PL_CONFIG_USE_BENCH
+  stats.nofAreas++;
+  stats.px += lv_area_get_size(&area);
+#endif
+}
+
+void GUI_EqCurve_Update(void) {
+  int32_t coeffs[EQDSP_NOF_COEFFS];
+  lv_coord_t newY[EQCURVE_CONFIG_NOF_POINTS];
+  int nofBands = 0, nofRuns = 0, first = -1, last = 0;
+#if PL_CONFIG_USE_BENCH
+  uint32_t ts = LV_GetTimestamp(), time;
+#endif
+
+  if (curve.obj==NULL) {
+    return;
+  }
+  EqDsp_GetCoeffs(coeffs);
+  for(int b=0; b<EQDSP_NOF_BANDS; b++) {
+    if (memcmp(&coeffs[5*b], &curve.coeffs[5*b], 5*sizeof(coeffs[0]))!=0) {
+      GUI_EqCurve_EvalBand(b, &coeffs[5*b]);
+      nofBands++;
+    }
+  }
+  if (nofBands==0) {
+    return; /* no change */
+  }
+  memcpy(curve.coeffs, coeffs, sizeof(curve.coeffs));
+  GUI_EqCurve_GetRows(newY);
+#if PL_CONFIG_USE_BENCH
+  time = LV_GetTimestamp()-ts;
+  stats.nofUpdates++;
+  stats.nofBands += nofBands;
+  stats.evalSum += time;
+  if (time>stats.evalMax) {
+    stats.evalMax = time;
+  }
+#endif
+  /* runs of changed points, a gap of one point does not split a run because the columns overlap anyway */
+  for(int i=0; i<EQCURVE_CONFIG_NOF_POINTS; i++) {
+    if (newY[i]==curve.y[i]) {
+      continue;
+    }
+    if (first<0) {
+      first = i;
+    } else if (i>last+2 && nofRuns<EQCURVE_CONFIG_MAX_AREAS-1) {
+      GUI_EqCurve_Invalidate(first, last, newY);
+      nofRuns++;
+      first = i;
+    }
+    last = i;
+  }
+  if (first>=0) {
+    GUI_EqCurve_Invalidate(first, last, newY);
+  }
+  memcpy(curve.y, newY, sizeof(curve.y));
+}
+
+#if PL_CONFIG_USE_BENCH
+void GUI_EqCurve_GetStats(GUI_EqCurve_Stats_t *s) {
+  *s = stats;
+}
+
+void GUI_EqCurve_ResetStats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
+#endif
+
+lv_obj_t *GUI_EqCurve_Create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h) {
+  if (!pointsValid) {
+    GUI_EqCurve_InitPoints();
+  }
+  lv_style_copy(&gridStyle, &lv_style_plain);
+  gridStyle.body.main_color = LV_COLOR_SILVER;
+  gridStyle.body.grad_color = LV_COLOR_SILVER;
+  lv_style_copy(&lineStyle, &lv_style_plain);
+  lineStyle.body.main_color = LV_COLOR_BLUE;
+  lineStyle.body.grad_color = LV_COLOR_BLUE;
+
+  curve.obj = lv_obj_create(parent, NULL);
+  lv_obj_set_style(curve.obj, &lv_style_plain);
+  lv_obj_set_click(curve.obj, false);
+  lv_obj_set_size(curve.obj, w, h);
+  curve.ancestorDesign = lv_obj_get_design_cb(curve.obj);
+  lv_obj_set_design_cb(curve.obj, GUI_EqCurve_Design);
+  curve.colWidth = w/EQCURVE_CONFIG_NOF_POINTS;
+  if (curve.colWidth<1) {
+    curve.colWidth = 1;
+  }
+  curve.zeroY = (h-2)/2; /* rows 0..h-2, the line is 2 pixels thick */
+
+  /* all bands, the object is drawn completely anyway */
+  EqDsp_GetCoeffs(curve.coeffs);
+  for(int b=0; b<EQDSP_NOF_BANDS; b++) {
+    GUI_EqCurve_EvalBand(b, &curve.coeffs[5*b]);
+  }
+  GUI_EqCurve_GetRows(curve.y);
+  return curve.obj;
+}
+
+#endif /* PL_CONFIG_USE_EQ_CURVE */
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef EQCURVE_H_
+#define EQCURVE_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_EQ_CURVE
+#include "LittlevGL/lvgl/lvgl.h"
+#include <stdint.h>
+
+#ifndef EQCURVE_CONFIG_NOF_POINTS
+  #define EQCURVE_CONFIG_NOF_POINTS     (120)
+#endif
+  /*!< number of log spaced frequencies from 20 Hz to 20 kHz where the response is evaluated, one column each */
+
+#ifndef EQCURVE_CONFIG_RANGE_DB
+  #define EQCURVE_CONFIG_RANGE_DB       (12)
+#endif
+  /*!< gain at the top of the widget, the bottom is the negative of it */
+
+#ifndef EQCURVE_CONFIG_MAX_AREAS
+  #define EQCURVE_CONFIG_MAX_AREAS      (8)
+#endif
+  /*!< runs of changed columns invalidated separately, more get merged into the last one */
+
+/* creates the response curve widget, the width should be a multiple of EQCURVE_CONFIG_NOF_POINTS */
+lv_obj_t *GUI_EqCurve_Create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h);
+
+/* evaluates the bands whose coefficients changed in the EQ and invalidates the columns whose value changed */
+void GUI_EqCurve_Update(void);
+
+#if PL_CONFIG_USE_BENCH
+typedef struct {
+  uint32_t nofUpdates; /* calls of GUI_EqCurve_Update() with a changed band */
+  uint32_t nofBands; /* bands evaluated */
+  uint32_t evalSum, evalMax; /* evaluation time, in LV_GetTimestamp() units */
+  uint32_t nofAreas; /* areas invalidated */
+  uint32_t px; /* pixels invalidated */
+} GUI_EqCurve_Stats_t;
+
+void GUI_EqCurve_GetStats(GUI_EqCurve_Stats_t *stats);
+void GUI_EqCurve_ResetStats(void);
+#endif
+
+#endif /* PL_CONFIG_USE_EQ_CURVE */
+
+#endif /* EQCURVE_H_ */
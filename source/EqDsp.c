@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Model of the 5-band equaliser: the Q31 coefficients of a cascade of biquads (RBJ audio EQ cookbook) at the band
+ * centres of the GUI, in the direct form I layout of CMSIS-DSP. The coefficients are computed in the context of the
+ * caller only when a gain changes. The project has no audio path which filters with them, they are read with
+ * EqDsp_GetCoeffs().
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_EQ_DSP
+#include "EqDsp.h"
+#include "McuRTOS.h"
+#include <math.h>
+#include <string.h>
+
+typedef enum {
+  EQDSP_LOW_SHELF,
+  EQDSP_PEAKING,
+  EQDSP_HIGH_SHELF,
+} EqDsp_FilterType_e;
+
+static const struct {
+  EqDsp_FilterType_e type;
+  float freq; /* centre or corner frequency in Hz */
+} bands[EQDSP_NOF_BANDS] = {
+  {EQDSP_LOW_SHELF, 100.0f},
+  {EQDSP_PEAKING, 300.0f},
+  {EQDSP_PEAKING, 875.0f},
+  {EQDSP_PEAKING, 2400.0f},
+  {EQDSP_HIGH_SHELF, 6900.0f},
+};
+
+static struct { /* written with EqDsp_SetGain() and EqDsp_SetEnabled() */
+  int8_t gainDb[EQDSP_NOF_BANDS];
+  bool enabled;
+  int32_t coeffs[EQDSP_NOF_COEFFS]; /* for the current gains */
+} ctrl;
+
+static int32_t EqDsp_ToQ31(float val) {
+  float q = val*(2147483648.0f/(1<<EQDSP_POST_SHIFT));
+
+  if (q>=2147483647.0f) {
+    return INT32_MAX;
+  } else if (q<=-2147483648.0f) {
+    return INT32_MIN;
+  }
+  return (int32_t)lroundf(q);
+}
+
+void EqDsp_ComputeCoeffs(const int8_t gainDb[EQDSP_NOF_BANDS], int32_t coeffs[EQDSP_NOF_COEFFS]) {
+  float A, w0, cosw, alpha, sqrtA, b0, b1, b2, a0, a1, a2;
+
+  for(int i=0; i<EQDSP_NOF_BANDS; i++) {
+    A = powf(10.0f, gainDb[i]/40.0f);
+    w0 = 2.0f*3.14159265f*bands[i].freq/EQDSP_CONFIG_SAMPLE_RATE;
+    cosw = cosf(w0);
+    switch(bands[i].type) {
+      case EQDSP_LOW_SHELF: /* shelf slope 1 */
+        alpha = sinf(w0)/2.0f*sqrtf(2.0f);
+        sqrtA = sqrtf(A);
+        b0 = A*((A+1.0f)-(A-1.0f)*cosw+2.0f*sqrtA*alpha);
+        b1 = 2.0f*A*((A-1.0f)-(A+1.0f)*cosw);
+        b2 = A*((A+1.0f)-(A-1.0f)*cosw-2.0f*sqrtA*alpha);
+        a0 = (A+1.0f)+(A-1.0f)*cosw+2.0f*sqrtA*alpha;
+        a1 = -2.0f*((A-1.0f)+(A+1.0f)*cosw);
+        a2 = (A+1.0f)+(A-1.0f)*cosw-2.0f*sqrtA*alpha;
+        break;
+      case EQDSP_HIGH_SHELF:
+        alpha = sinf(w0)/2.0f*sqrtf(2.0f);
+        sqrtA = sqrtf(A);
+        b0 = A*((A+1.0f)+(A-1.0f)*cosw+2.0f*sqrtA*alpha);
+        b1 = -2.0f*A*((A-1.0f)+(A+1.0f)*cosw);
+        b2 = A*((A+1.0f)+(A-1.0f)*cosw-2.0f*sqrtA*alpha);
+        a0 = (A+1.0f)-(A-1.0f)*cosw+2.0f*sqrtA*alpha;
+        a1 = 2.0f*((A-1.0f)-(A+1.0f)*cosw);
+        a2 = (A+1.0f)-(A-1.0f)*cosw-2.0f*sqrtA*alpha;
+        break;
+      case EQDSP_PEAKING:
+      default:
+        alpha = sinf(w0)/(2.0f*EQDSP_CONFIG_Q);
+        b0 = 1.0f+alpha*A;
+        b1 = -2.0f*cosw;
+        b2 = 1.0f-alpha*A;
+        a0 = 1.0f+alpha/A;
+        a1 = -2.0f*cosw;
+        a2 = 1.0f-alpha/A;
+        break;
+    }
+    coeffs[5*i+0] = EqDsp_ToQ31(b0/a0);
+    coeffs[5*i+1] = EqDsp_ToQ31(b1/a0);
+    coeffs[5*i+2] = EqDsp_ToQ31(b2/a0);
+    coeffs[5*i+3] = EqDsp_ToQ31(-a1/a0); /* CMSIS-DSP adds the feedback terms */
+    coeffs[5*i+4] = EqDsp_ToQ31(-a2/a0);
+  }
+}
+
+static void EqDsp_Update(void) {
+  int8_t gainDb[EQDSP_NOF_BANDS];
+  int32_t coeffs[EQDSP_NOF_COEFFS];
+
+  for(int i=0; i<EQDSP_NOF_BANDS; i++) {
+    gainDb[i] = ctrl.enabled ? ctrl.gainDb[i] : 0;
+  }
+  EqDsp_ComputeCoeffs(gainDb, coeffs);
+  taskENTER_CRITICAL();
+  memcpy(ctrl.coeffs, coeffs, sizeof(ctrl.coeffs));
+  taskEXIT_CRITICAL();
+}
+
+void EqDsp_SetGain(uint8_t band, int8_t gainDb) {
+  if (band>=EQDSP_NOF_BANDS || ctrl.gainDb[band]==gainDb) {
+    return;
+  }
+  ctrl.gainDb[band] = gainDb;
+  if (ctrl.enabled) {
+    EqDsp_Update();
+  }
+}
+
+void EqDsp_SetEnabled(bool enabled) {
+  if (ctrl.enabled!=enabled) {
+    ctrl.enabled = enabled;
+    EqDsp_Update();
+  }
+}
+
+void EqDsp_GetCoeffs(int32_t coeffs[EQDSP_NOF_COEFFS]) {
+  taskENTER_CRITICAL();
+  memcpy(coeffs, ctrl.coeffs, sizeof(ctrl.coeffs));
+  taskEXIT_CRITICAL();
+}
+
+void EqDsp_Deinit(void) {
+  /* nothing to do */
+}
+
+void EqDsp_Init(void) {
+  memset(&ctrl, 0, sizeof(ctrl)); /* disabled, all bands at 0 dB as the GUI at power-up */
+  EqDsp_ComputeCoeffs(ctrl.gainDb, ctrl.coeffs);
+}
+
+#endif /* PL_CONFIG_USE_EQ_DSP */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef EQDSP_H_
+#define EQDSP_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_EQ_DSP
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef EQDSP_CONFIG_SAMPLE_RATE
+  #define EQDSP_CONFIG_SAMPLE_RATE      (48000)
+#endif
+  /*!< audio sample rate in Hz */
+
+#ifndef EQDSP_CONFIG_Q
+  #define EQDSP_CONFIG_Q                (1.0f)
+#endif
+  /*!< quality factor of the peaking bands, the band centres are about 1.5 octaves apart */
+
+#define EQDSP_NOF_BANDS        (5) /* low shelf at 100 Hz, peaking at 300 Hz, 875 Hz and 2.4 kHz, high shelf at 6.9 kHz */
+#define EQDSP_NOF_COEFFS       (5*EQDSP_NOF_BANDS) /* {b0, b1, b2, a1, a2} per band, a1 and a2 negated as in CMSIS-DSP */
+#define EQDSP_POST_SHIFT       (2) /* coefficients are stored divided by 4, for shelf gains and a1 up to 4 */
+
+/* computes the Q31 coefficients of the cascade for the band gains in dB */
+void EqDsp_ComputeCoeffs(const int8_t gainDb[EQDSP_NOF_BANDS], int32_t coeffs[EQDSP_NOF_COEFFS]);
+
+/* called from the GUI: the coefficients get computed here */
+void EqDsp_SetGain(uint8_t band, int8_t gainDb);
+void EqDsp_SetEnabled(bool enabled); /* disabled: all bands at 0 dB */
+
+/* copies the coefficients of the last EqDsp_SetGain() or EqDsp_SetEnabled() */
+void EqDsp_GetCoeffs(int32_t coeffs[EQDSP_NOF_COEFFS]);
+
+void EqDsp_Deinit(void);
+void EqDsp_Init(void);
+
+#endif /* PL_CONFIG_USE_EQ_DSP */
+
+#endif /* EQDSP_H_ */
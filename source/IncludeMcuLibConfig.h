@@ -23,12 +23,13 @@
 #define configENABLE_TRUSTZONE                (0)
 #define configENABLE_FPU                      (1) /* \todo */
 #define configENABLE_MPU                      (0) /* \todo */
+#define configUSE_TICKLESS_IDLE               (1) /* GUI task sleeps until the next LVGL deadline, see GUI_Task() */
 
 /* ------------------- I2C ---------------------------*/
-#define CONFIG_USE_HW_I2C                             (0) /* if using HW I2C, otherwise use software bit banging */
+#define CONFIG_USE_HW_I2C                             (1) /* if using HW I2C (FLEXCOMM4, see i2clib.c), otherwise use software bit banging */
 #define McuGenericI2C_CONFIG_USE_ON_ERROR_EVENT       (0)
 #define McuGenericI2C_CONFIG_USE_ON_REQUEST_BUS_EVENT (0)
-#define McuGenericI2C_CONFIG_USE_MUTEX                (0 && McuLib_CONFIG_SDK_USE_FREERTOS)
+#define McuGenericI2C_CONFIG_USE_MUTEX                (CONFIG_USE_HW_I2C && McuLib_CONFIG_SDK_USE_FREERTOS) /* tasks block during HW transfers: RequestBus()/ReleaseBus() keep the others out */
 
 /* I2C pins */
 #define I2CLIB_SCL_GPIO         GPIO
@@ -83,7 +84,13 @@
 #define LV_CONFIG_DISPLAY_HEIGHT       (320)
 #define LV_CONFIG_COLOR_DEPTH          (16)
 #define LV_CONFIG_DPI                  (50)
-#define LV_CONFIG_COLOR_16_SWAP        (1)
+#define LV_CONFIG_COLOR_16_SWAP        (0) /* ILI9341 pixels are sent as 16bit SPI frames, see MCUILI9341_CONFIG_PIXEL_FRAME16 */
+/* draw buffers in lv.c: 2 x 240 x 10 x 2 bytes, statically allocated (not from the RTOS heap) */
+#define LV_CONFIG_DRAW_BUF_LINES       (10)
+#define LV_CONFIG_DRAW_BUF_DOUBLE      (1)
+#define LV_CONFIG_USE_FRAME_STATS      (1)
+#define LV_CONFIG_USE_HW_FILL          (1)
+#define LV_CONFIG_TICK_CUSTOM          (1) /* lv_tick_get() is derived from the FreeRTOS tick count */
 
 /* -------------------------------------------------*/
 /* FT6206 capacitive touch controller */
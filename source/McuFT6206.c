@@ -8,6 +8,11 @@
 #include "McuFT6206.h"
 #include "McuGenericI2C.h"
 #include "McuUtility.h"
+#if MCUFT6206_CONFIG_USE_INT
+  #include "McuRTOS.h"
+  #include "fsl_common.h"
+  #include "fsl_iocon.h"
+#endif
 
 #define MCUFT62XX_I2C_ADDR          0x38
 #define MCUFT62XX_G_FT5201ID        0xA8
@@ -26,6 +31,9 @@
 #define MCUFT62XX_REG_FIRMVERS      0xA6
 #define MCUFT62XX_REG_CHIPID        0xA3
 #define MCUFT62XX_REG_VENDID        0xA8
+#define MCUFT62XX_REG_G_MODE        0xA4 /* 0: INT low while touched, 1: INT pulse per report */
+#define MCUFT62XX_REG_P2_YL         0x0C /* last register with touch coordinates */
+#define MCUFT62XX_POINT_REG_SIZE    6    /* XH, XL, YH, YL, weight, misc */
 
 uint8_t McuFT6206_ReadVendorID(uint8_t *id) {
   return McuGenericI2C_ReadByteAddress8(MCUFT62XX_I2C_ADDR, MCUFT62XX_REG_VENDID, id);
@@ -66,47 +74,88 @@ uint8_t McuFT6206_ReadNofTouches(uint8_t *nof) {
   return ERR_OK;
 }
 
-static struct {
-  uint8_t touches;
-  uint16_t touchX[2], touchY[2], touchID[2];
-} McuFT6206_Data;
-
-uint8_t McuFT6206_ReadPoint(uint8_t n, McuFT6206_TouchPoint *point) {
-  uint8_t data[16];
-  uint8_t addr = MCUFT62XX_REG_DATA_START;
+uint8_t McuFT6206_ReadTouchData(McuFT6206_TouchData *data) {
+  /* TD_STATUS (0x02) is followed by the registers of touch 1 (0x03..0x08) and touch 2 (0x09..0x0E) */
+  uint8_t buf[MCUFT62XX_REG_P2_YL-MCUFT62XX_REG_NUMTOUCHES+1];
+  uint8_t addr = MCUFT62XX_REG_NUMTOUCHES;
   uint8_t i, res;
 
-  res = McuGenericI2C_ReadAddress(MCUFT62XX_I2C_ADDR, &addr, sizeof(addr), data, sizeof(data));
+  res = McuGenericI2C_ReadAddress(MCUFT62XX_I2C_ADDR, &addr, sizeof(addr), buf, sizeof(buf));
   if (res!=ERR_OK) {
+    data->nofTouches = 0;
     return res;
   }
-  McuFT6206_Data.touches = data[2];
-  if (McuFT6206_Data.touches>2) { /* error case */
-    McuFT6206_Data.touches = 0;
+  data->nofTouches = buf[0]&0x0F;
+  if (data->nofTouches>2) { /* error case */
+    data->nofTouches = 0;
   }
+  for (i=0; i<data->nofTouches; i++) {
+    const uint8_t *p = &buf[1+i*MCUFT62XX_POINT_REG_SIZE]; /* XH, XL, YH, YL */
 
-  for (i=0; i<2; i++) {
-    McuFT6206_Data.touchX[i] = data[0x03 + i*6]&0x0F;
-    McuFT6206_Data.touchX[i] <<= 8;
-    McuFT6206_Data.touchX[i] |= data[0x04 + i*6];
-    McuFT6206_Data.touchY[i] = data[0x05 + i*6]&0x0F;
-    McuFT6206_Data.touchY[i] <<= 8;
-    McuFT6206_Data.touchY[i] |= data[0x06 + i*6];
-    McuFT6206_Data.touchID[i] = data[0x05 + i*6]>>4;
+    data->point[i].event = p[0]>>6;
+    data->point[i].x = ((p[0]&0x0F)<<8) | p[1];
+    data->point[i].id = p[2]>>4;
+    data->point[i].y = ((p[2]&0x0F)<<8) | p[3];
   }
+  return ERR_OK;
+}
+
+uint8_t McuFT6206_ReadPoint(uint8_t n, McuFT6206_TouchPoint *point) {
+  McuFT6206_TouchData data;
+  uint8_t res;
 
-  if (McuFT6206_Data.touches==0 || McuFT6206_Data.touches>1) {
+  res = McuFT6206_ReadTouchData(&data);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  if (n>=data.nofTouches) {
     point->x = 0;
     point->y = 0;
     point->z = 0;
   } else {
-    point->x = McuFT6206_Data.touchX[n];
-    point->y = McuFT6206_Data.touchY[n];
+    point->x = data.point[n].x;
+    point->y = data.point[n].y;
     point->z = 1;
   }
   return ERR_OK;
 }
 
+#if MCUFT6206_CONFIG_USE_INT
+static McuFT6206_IntCallback intCallback = NULL;
+
+void MCUFT6206_INT_IRQHandler(void) {
+  /* The INT line is level sensitive and stays low while a finger is on the panel.
+   * Mask it here, it gets unmasked with McuFT6206_EnableInterrupt() after the touch data has been read. */
+  PINT->CIENR = 1U<<MCUFT6206_INT_PINT_CHANNEL;
+  if (intCallback!=NULL) {
+    intCallback();
+  }
+  __DSB();
+}
+
+void McuFT6206_SetIntCallback(McuFT6206_IntCallback callback) {
+  intCallback = callback;
+}
+
+void McuFT6206_EnableInterrupt(void) {
+  /* if a finger is still on the panel, the interrupt fires right away */
+  PINT->SIENR = 1U<<MCUFT6206_INT_PINT_CHANNEL;
+}
+
+static void McuFT6206_InitInterrupt(void) {
+  IOCON_PinMuxSet(IOCON, MCUFT6206_INT_PORT, MCUFT6206_INT_PIN, IOCON_FUNC0|IOCON_MODE_PULLUP|IOCON_DIGITAL_EN);
+  CLOCK_EnableClock(kCLOCK_InputMux);
+  CLOCK_EnableClock(kCLOCK_Pint);
+  INPUTMUX->PINTSEL[MCUFT6206_INT_PINT_CHANNEL] = INPUTMUX_PINTSEL_INTPIN(MCUFT6206_INT_PORT*32U+MCUFT6206_INT_PIN);
+  PINT->CIENR = 1U<<MCUFT6206_INT_PINT_CHANNEL;
+  PINT->ISEL |= 1U<<MCUFT6206_INT_PINT_CHANNEL; /* level sensitive */
+  PINT->CIENF = 1U<<MCUFT6206_INT_PINT_CHANNEL; /* active low */
+  NVIC_SetPriority(MCUFT6206_INT_IRQ, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+  NVIC_EnableIRQ(MCUFT6206_INT_IRQ);
+  PINT->SIENR = 1U<<MCUFT6206_INT_PINT_CHANNEL;
+}
+#endif /* MCUFT6206_CONFIG_USE_INT */
+
 #if MCUFT6206_CONFIG_PARSE_COMMAND_ENABLED
 static uint8_t PrintHelp(const McuShell_StdIOType *io) {
   McuShell_SendHelpStr((unsigned char*)"FT6206", (unsigned char*)"Group of FT6206 commands\r\n", io->stdOut);
@@ -191,6 +240,11 @@ uint8_t McuFT6206_ParseCommand(const unsigned char *cmd, bool *handled, const Mc
 
 
 void McuFT6206_Deinit(void) {
+#if MCUFT6206_CONFIG_USE_INT
+  NVIC_DisableIRQ(MCUFT6206_INT_IRQ);
+  PINT->CIENR = 1U<<MCUFT6206_INT_PINT_CHANNEL;
+  intCallback = NULL;
+#endif
 }
 
 void McuFT6206_Init(void) {
@@ -202,6 +256,14 @@ void McuFT6206_Init(void) {
       /* failed initializing driver */
     }
   }
+#if MCUFT6206_CONFIG_USE_INT
+  if (McuGenericI2C_WriteByteAddress8(MCUFT62XX_I2C_ADDR, MCUFT62XX_REG_G_MODE, 0)!=ERR_OK) {
+    for(;;) {
+      /* failed initializing driver */
+    }
+  }
+  McuFT6206_InitInterrupt();
+#endif
 }
 
 
@@ -22,6 +22,21 @@ typedef struct {
   int16_t x, y, z;
 } McuFT6206_TouchPoint;
 
+/* event flag of a touch point */
+#define MCUFT6206_EVENT_PRESS_DOWN  0
+#define MCUFT6206_EVENT_LIFT_UP     1
+#define MCUFT6206_EVENT_CONTACT     2
+#define MCUFT6206_EVENT_NONE        3
+
+typedef struct {
+  uint8_t nofTouches; /* 0, 1 or 2 */
+  struct {
+    uint16_t x, y;
+    uint8_t id; /* touch ID, stays the same while the finger is down */
+    uint8_t event; /* MCUFT6206_EVENT_* */
+  } point[2]; /* only the first nofTouches entries are valid */
+} McuFT6206_TouchData;
+
 /* hardware vendor and chip IDs */
 #define MCUFT62XX_VENDID            0x11
 #define MCUFT6206_CHIPID            0x06
@@ -44,6 +59,19 @@ uint8_t McuFT6206_ReadNofTouches(uint8_t *nof);
 
 uint8_t McuFT6206_ReadPoint(uint8_t n, McuFT6206_TouchPoint *point);
 
+/* reads the number of touches and both touch points in a single I2C transaction */
+uint8_t McuFT6206_ReadTouchData(McuFT6206_TouchData *data);
+
+#if MCUFT6206_CONFIG_USE_INT
+  typedef void (*McuFT6206_IntCallback)(void);
+
+  /* callback is called from the pin interrupt, with the pin interrupt masked */
+  void McuFT6206_SetIntCallback(McuFT6206_IntCallback callback);
+
+  /* unmasks the pin interrupt, to be called after the touch data has been read: fires again right away while a finger is down */
+  void McuFT6206_EnableInterrupt(void);
+#endif
+
 void McuFT6206_Deinit(void);
 void McuFT6206_Init(void);
 
@@ -17,4 +17,18 @@
 #endif
   /*! Default touch screen threshold */
 
+#include "platform.h"
+
+#ifndef MCUFT6206_CONFIG_USE_INT
+  #define MCUFT6206_CONFIG_USE_INT                  (1 && PL_CONFIG_USE_FT6206)
+#endif
+  /*!< 1: the INT line of the controller raises a pin interrupt while touched, no polling needed while released. 0: the controller has to be polled */
+
+/* INT: IRQ pad of the shield (active low, held low while touched), wired to PIO1_9 */
+#define MCUFT6206_INT_PORT          1U
+#define MCUFT6206_INT_PIN           9U
+#define MCUFT6206_INT_PINT_CHANNEL  2U /* PINT channel 0 and 1 are used by the board push buttons */
+#define MCUFT6206_INT_IRQ           PIN_INT2_IRQn
+#define MCUFT6206_INT_IRQHandler    PIN_INT2_IRQHandler
+
 #endif /* MCUFT6206CONFIG_H_ */
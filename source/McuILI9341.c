@@ -81,12 +81,27 @@
 
 #define SET_CMD_MODE()      McuGPIO_SetLow(McuILI9341_DCPin)
 #define SET_DATA_MODE()     McuGPIO_SetHigh(McuILI9341_DCPin)
-#define SELECT_DISPLAY()    McuGPIO_SetLow(McuILI9341_CSPin)
-#define DESELECT_DISPLAY()  McuGPIO_SetHigh(McuILI9341_CSPin);
+/* the bus is reserved while the display is selected, the chip select is driven by the bus arbiter in McuSPI.c */
+#define SELECT_DISPLAY()    McuSPI_Select(McuSPI_ClientLCD)
+#define DESELECT_DISPLAY()  McuSPI_Deselect(McuSPI_ClientLCD)
 
 static McuGPIO_Handle_t McuILI9341_CSPin;
 static McuGPIO_Handle_t McuILI9341_DCPin;
 
+static void McuILI9341_SetCS(bool active) {
+  /* CS is LOW active. Gets called from the DMA interrupt too */
+  McuGPIO_SetValue(McuILI9341_CSPin, !active);
+}
+
+static void McuILI9341_SetDC(bool high) {
+  /* DC: LOW: command, HIGH: data */
+  McuGPIO_SetValue(McuILI9341_DCPin, high);
+}
+
+#define CMD_SEGMENT(cmd)          {.dcHigh=false, .frame16=false, .data=(cmd), .nofBytes=1}
+#define DATA_SEGMENT(buf, size)   {.dcHigh=true, .frame16=false, .data=(buf), .nofBytes=(size)}
+#define PIXEL_SEGMENT(px, nofPx)  {.dcHigh=true, .frame16=MCUILI9341_CONFIG_PIXEL_FRAME16, .data=(const uint8_t*)(px), .nofBytes=2*(nofPx)}
+
 /* Initialization sequence for Adafruit ILI9341 driver, see https://github.com/adafruit/Adafruit_ILI9341/blob/master/Adafruit_ILI9341.cpp */
 static const uint8_t initlist[] = {
   0xEF, 3, 0x03, 0x80, 0x02,
@@ -123,15 +138,12 @@ static uint8_t McuILI9341_Write8Cmd(uint8_t cmd) {
 }
 
 uint8_t McuILI9341_WriteCommandArgs(uint8_t cmd, uint8_t *args, uint8_t nofArgs) {
-   uint8_t res;
-
-   res = McuILI9341_Write8Cmd(cmd);
-   if (res!=ERR_OK) {
-     return res;
-   }
-   SET_DATA_MODE(); /* go back to data mode */
-   MCUSPI_WriteBytes(McuSPI_ConfigLCD, args, nofArgs);
-   return ERR_OK;
+  McuSPI_Segment_t segments[] = {
+    CMD_SEGMENT(&cmd),
+    DATA_SEGMENT(args, nofArgs),
+  };
+
+  return McuSPI_WriteSegments(McuSPI_ConfigLCD, segments, nofArgs==0?1:2, McuILI9341_SetDC); /* leaves DC in data mode */
 }
 
 uint8_t McuILI9341_SoftReset(void) {
@@ -195,67 +207,136 @@ uint8_t McuILI9341_GetDisplayIdentification(uint8_t *manufacurer, uint8_t *drive
   return res;
 }
 
+/* fills in the transaction to set the window and start writing to the display RAM */
+static void McuILI9341_FillWindowSegments(McuSPI_Segment_t *segments, uint8_t *buf, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+  static const uint8_t cmds[] = {MCUILI9341_CASET, MCUILI9341_PASET, MCUILI9341_RAMWR};
+
+  buf[0] = x0>>8; buf[1] = x0; /* XSTART */
+  buf[2] = x1>>8; buf[3] = x1; /* XEND */
+  buf[4] = y0>>8; buf[5] = y0; /* YSTART */
+  buf[6] = y1>>8; buf[7] = y1; /* YEND */
+  segments[0] = (McuSPI_Segment_t)CMD_SEGMENT(&cmds[0]); /* column address set */
+  segments[1] = (McuSPI_Segment_t)DATA_SEGMENT(&buf[0], 4);
+  segments[2] = (McuSPI_Segment_t)CMD_SEGMENT(&cmds[1]); /* row address set */
+  segments[3] = (McuSPI_Segment_t)DATA_SEGMENT(&buf[4], 4);
+  segments[4] = (McuSPI_Segment_t)CMD_SEGMENT(&cmds[2]); /* write to RAM */
+}
+
+#define WINDOW_NOF_SEGMENTS   (5)
+#define WINDOW_BUF_SIZE       (8)
+
 uint8_t McuILI9341_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+  McuSPI_Segment_t segments[WINDOW_NOF_SEGMENTS];
+  uint8_t buf[WINDOW_BUF_SIZE];
+  uint8_t res;
+
+  McuILI9341_FillWindowSegments(segments, buf, x0, y0, x1, y1);
   SELECT_DISPLAY();
+  res = McuSPI_WriteSegments(McuSPI_ConfigLCD, segments, WINDOW_NOF_SEGMENTS, McuILI9341_SetDC);
+  DESELECT_DISPLAY();
+  return res;
+}
 
-  SET_CMD_MODE();
-  McuSPI_WriteByte(McuSPI_ConfigLCD, MCUILI9341_CASET);
-  SET_DATA_MODE();
-  McuSPI_WriteByte(McuSPI_ConfigLCD, x0 >> 8);
-  McuSPI_WriteByte(McuSPI_ConfigLCD, x0 & 0xFF);         // XSTART
-  McuSPI_WriteByte(McuSPI_ConfigLCD, x1 >> 8);
-  McuSPI_WriteByte(McuSPI_ConfigLCD, x1 & 0xFF);         // XEND
+uint8_t McuILI9341_WritePixelData(uint16_t *pixels, size_t nofPixels) {
+  McuSPI_Segment_t segment = PIXEL_SEGMENT(pixels, nofPixels);
+  uint8_t res;
 
-  SET_CMD_MODE();
-  McuSPI_WriteByte(McuSPI_ConfigLCD, MCUILI9341_PASET); // Row addr set
-  SET_DATA_MODE();
-  McuSPI_WriteByte(McuSPI_ConfigLCD, y0 >> 8);
-  McuSPI_WriteByte(McuSPI_ConfigLCD, y0);                // YSTART
-  McuSPI_WriteByte(McuSPI_ConfigLCD, y1 >> 8);
-  McuSPI_WriteByte(McuSPI_ConfigLCD, y1);                // YEND
+  SELECT_DISPLAY();
+  res = McuSPI_WriteSegments(McuSPI_ConfigLCD, &segment, 1, McuILI9341_SetDC);
+  DESELECT_DISPLAY();
+  return res;
+}
 
-  SET_CMD_MODE();
-  McuSPI_WriteByte(McuSPI_ConfigLCD, MCUILI9341_RAMWR); // write to RAM}
+static McuILI9341_DoneCallback asyncDoneCallback; /* user callback for the ongoing asynchronous pixel write */
 
-  DESELECT_DISPLAY();
+static void McuILI9341_AsyncDone(void *param) {
+  /* called from the DMA interrupt, after the chip select has been deasserted */
+  if (asyncDoneCallback!=NULL) {
+    asyncDoneCallback(param);
+  }
+}
 
+static uint8_t McuILI9341_WriteSegmentsAsync(const McuSPI_Segment_t *segments, size_t nofSegments, McuILI9341_DoneCallback done, void *param) {
+  uint8_t res;
+
+  SELECT_DISPLAY();
+  asyncDoneCallback = done;
+  res = McuSPI_WriteSegmentsAsync(McuSPI_ConfigLCD, segments, nofSegments, McuILI9341_SetDC, McuILI9341_AsyncDone, param);
+  if (res!=ERR_OK) {
+    DESELECT_DISPLAY();
+    return res;
+  }
+  DESELECT_DISPLAY(); /* chip select gets deasserted at the end of the transfer */
   return ERR_OK;
 }
 
-uint8_t McuILI9341_WritePixelData(uint16_t *pixels, size_t nofPixels) {
+uint8_t McuILI9341_WritePixelDataAsync(uint16_t *pixels, size_t nofPixels, McuILI9341_DoneCallback done, void *param) {
+  McuSPI_Segment_t segment = PIXEL_SEGMENT(pixels, nofPixels);
+
+  return McuILI9341_WriteSegmentsAsync(&segment, 1, done, param);
+}
+
+uint8_t McuILI9341_WriteWindowPixelDataAsync(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t *pixels, McuILI9341_DoneCallback done, void *param) {
+  McuSPI_Segment_t segments[WINDOW_NOF_SEGMENTS+1];
+  uint8_t buf[WINDOW_BUF_SIZE];
+
+  McuILI9341_FillWindowSegments(segments, buf, x0, y0, x1, y1);
+  segments[WINDOW_NOF_SEGMENTS] = (McuSPI_Segment_t)PIXEL_SEGMENT(pixels, (x1-x0+1)*(y1-y0+1));
+  return McuILI9341_WriteSegmentsAsync(segments, WINDOW_NOF_SEGMENTS+1, done, param);
+}
+
+uint8_t McuILI9341_FillWindowAsync(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color, McuILI9341_DoneCallback done, void *param) {
+  McuSPI_Segment_t segments[WINDOW_NOF_SEGMENTS];
+  uint8_t buf[WINDOW_BUF_SIZE];
+  uint8_t res;
+
+  McuILI9341_FillWindowSegments(segments, buf, x0, y0, x1, y1);
   SELECT_DISPLAY();
-  SET_DATA_MODE();
-  MCUSPI_WriteBytes(McuSPI_ConfigLCD, (uint8_t*)pixels, 2*nofPixels);
-  DESELECT_DISPLAY();
+  asyncDoneCallback = done;
+  res = McuSPI_WriteSegments(McuSPI_ConfigLCD, segments, WINDOW_NOF_SEGMENTS, McuILI9341_SetDC);
+  if (res==ERR_OK) {
+    SET_DATA_MODE();
+    /* 16bit frames are sent MSB first, so no byte swap is needed */
+    res = McuSPI_WriteRepeated16Async(McuSPI_ConfigLCD, color, (x1-x0+1)*(y1-y0+1), McuILI9341_AsyncDone, param);
+  }
+  if (res!=ERR_OK) {
+    DESELECT_DISPLAY();
+    return res;
+  }
+  DESELECT_DISPLAY(); /* chip select gets deasserted at the end of the transfer */
   return ERR_OK;
 }
 
 uint8_t McuILI9341_DrawPixel(uint16_t x, uint16_t y, uint16_t color) {
-#if McuLib_CONFIG_CPU_IS_LITTLE_ENDIAN
-  /*! \todo: should change endianess in Interface control (0xF6)? */
-  color = (color>>8)|(color<<8); /* swap */
-#endif
-  McuILI9341_SetWindow(x, y, x, y);
+  McuSPI_Segment_t segments[WINDOW_NOF_SEGMENTS+1];
+  uint8_t buf[WINDOW_BUF_SIZE];
+  uint8_t res;
+
+  McuILI9341_FillWindowSegments(segments, buf, x, y, x, y);
+  segments[WINDOW_NOF_SEGMENTS] = (McuSPI_Segment_t){.dcHigh=true, .frame16=true, .data=(const uint8_t*)&color, .nofBytes=2}; /* RGB565, MSB first */
   SELECT_DISPLAY();
-  SET_DATA_MODE();
-  MCUSPI_WriteBytes(McuSPI_ConfigLCD, (uint8_t*)&color, 2);
+  res = McuSPI_WriteSegments(McuSPI_ConfigLCD, segments, WINDOW_NOF_SEGMENTS+1, McuILI9341_SetDC);
   DESELECT_DISPLAY();
-  return ERR_OK;
+  return res;
 }
 
 uint8_t McuILI9341_DrawBox(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
-#if McuLib_CONFIG_CPU_IS_LITTLE_ENDIAN
-  /*! \todo: should change endianess in Interface control (0xF6)? */
-  color = (color>>8)|(color<<8); /* swap */
-#endif
-  McuILI9341_SetWindow(x, y, x+w-1, y+h-1);
+  McuSPI_Segment_t segments[WINDOW_NOF_SEGMENTS];
+  uint8_t buf[WINDOW_BUF_SIZE];
+  uint8_t res;
+
+  if (w==0 || h==0) {
+    return ERR_OK;
+  }
+  McuILI9341_FillWindowSegments(segments, buf, x, y, x+w-1, y+h-1);
   SELECT_DISPLAY();
-  SET_DATA_MODE();
-  for(int i=0; i<w*h; i++) {
-    MCUSPI_WriteBytes(McuSPI_ConfigLCD, (uint8_t*)&color, 2);
+  res = McuSPI_WriteSegments(McuSPI_ConfigLCD, segments, WINDOW_NOF_SEGMENTS, McuILI9341_SetDC);
+  if (res==ERR_OK) {
+    SET_DATA_MODE();
+    McuSPI_WriteRepeated16(McuSPI_ConfigLCD, color, (size_t)w*h); /* one FIFO entry per pixel, MSB first */
   }
   DESELECT_DISPLAY();
-  return ERR_OK;
+  return res;
 }
 
 uint8_t McuILI9341_ClearDisplay(uint16_t color) {
@@ -354,6 +435,7 @@ void McuILI9341_Init(void) {
   config.hw.port = MCUILI9341_CS_PORT;
   config.hw.gpio = MCUILI9341_CS_GPIO;
   McuILI9341_CSPin = McuGPIO_InitGPIO(&config);
+  McuSPI_SetClientChipSelect(McuSPI_ClientLCD, McuILI9341_SetCS);
 
   /* initialize DC: LOW: command, HIGH: Data */
   config.hw.pin = MCUILI9341_DC_PIN;
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "McuILI9341config.h"
 
 #if MCUILI9341_CONFIG_PARSE_COMMAND_ENABLED
@@ -46,8 +47,20 @@ uint8_t McuILI9341_ClearDisplay(uint16_t color);
 
 uint8_t McuILI9341_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
+/* pixels are RGB565 values, see MCUILI9341_CONFIG_PIXEL_FRAME16 for the byte order in memory */
 uint8_t McuILI9341_WritePixelData(uint16_t *pixels, size_t nofPixels);
 
+typedef void (*McuILI9341_DoneCallback)(void *param); /* called from interrupt context if the transfer is done with DMA */
+
+/* starts writing the pixels into the window set with McuILI9341_SetWindow() and returns immediately. 'pixels' must stay valid until 'done' gets called */
+uint8_t McuILI9341_WritePixelDataAsync(uint16_t *pixels, size_t nofPixels, McuILI9341_DoneCallback done, void *param);
+
+/* sets the window and writes its pixels in one bus transaction, the pixel data gets written asynchronously */
+uint8_t McuILI9341_WriteWindowPixelDataAsync(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t *pixels, McuILI9341_DoneCallback done, void *param);
+
+/* fills the window with a color without a pixel buffer: the same color gets repeated on the bus, with DMA in the background */
+uint8_t McuILI9341_FillWindowAsync(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color, McuILI9341_DoneCallback done, void *param);
+
 uint8_t McuILI9341_DrawPixel(uint16_t x, uint16_t y, uint16_t color); /* does set a window and writes pixel */
 
 uint8_t McuILI9341_DrawBox(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
@@ -13,4 +13,9 @@
 #endif
   /*!< 1: command line parser enabled. 0: command line parser disabled */
 
+#ifndef MCUILI9341_CONFIG_PIXEL_FRAME16
+  #define MCUILI9341_CONFIG_PIXEL_FRAME16            (1)
+#endif
+  /*!< 1: pixel data is native RGB565 (uint16_t), written as 16bit SPI frames. 0: pixel data is written as bytes, so it has to be big endian in memory (e.g. LV_COLOR_16_SWAP) */
+
 #endif /* MCUILI9341CONFIG_H_ */
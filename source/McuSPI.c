@@ -8,13 +8,18 @@
 #include "platform.h"
 #include "McuSPIconfig.h"
 #include "McuSPI.h"
+#include "McuLib.h"
+#include "McuRTOS.h"
+#include "McuArmTools.h"
 #include "fsl_spi.h"
-#if MCUSPI_CONFIG_USE_MUTEX
-  #include "McuRTOS.h"
+#include <string.h>
+#if MCUSPI_CONFIG_PARSE_COMMAND_ENABLED
+  #include "McuShell.h"
+  #include "McuUtility.h"
 #endif
 
-#if MCUSPI_CONFIG_USE_MUTEX
-  static SemaphoreHandle_t mutex;
+#if MCUSPI_CONFIG_LCD_QUANTUM%2!=0
+  #error "display pixels can be sent as two 8bit frames: the quantum has to keep the pixel boundaries"
 #endif
 
 static spi_master_config_t configs[] = {
@@ -73,19 +78,268 @@ static spi_master_config_t configs[] = {
 #endif
 };
 
+#define MCUSPI_NOF_CONFIGS  (sizeof(configs)/sizeof(configs[0]))
+
+/* register contents after SPI_MasterInit() for each configuration, captured in McuSPI_Init() */
+typedef struct {
+  uint32_t cfg; /* CFG with ENABLE set: mode, polarity of the chip selects */
+  uint32_t div; /* DIV: baud rate divider */
+  uint32_t dly; /* DLY: pre/post/frame/transfer delays */
+  uint32_t fifoTrig; /* FIFOTRIG: watermarks */
+} McuSPI_RegImage_t;
+
+static McuSPI_RegImage_t regImages[MCUSPI_NOF_CONFIGS];
+
 static McuSPI_Config McuSPI_CurrentConfig = -1;
 
+static uint8_t McuSPI_WriteAsync(McuSPI_Config config, const uint8_t *data, size_t nofBytes, bool frame16, McuSPI_DoneCallback done, void *param);
+
+/* Bus arbiter: a task waits on the semaphore of its client, and the free bus is handed over to the waiting client with the
+ * highest priority. An asynchronous transfer keeps the bus until it is done, but after each quantum it gets suspended
+ * (chip select deasserted) if a client with higher priority is waiting, and resumed once that client has released the bus. */
+typedef struct {
+  const char *name;
+  uint8_t priority; /* higher value wins */
+  size_t quantum; /* number of frames of an asynchronous transfer before it can be suspended, 0: never suspended */
+  McuSPI_SetCSCallback setCS; /* NULL if the client has no chip select */
+  SemaphoreHandle_t grant; /* given to hand the bus over to a waiting task of the client */
+  uint8_t nofWaiting; /* number of tasks waiting for the bus */
+  bool selected; /* chip select is asserted, except while an asynchronous transfer is suspended */
+  bool deselectAtEnd; /* deassert the chip select at the end of the asynchronous transfer */
+  McuSPI_ClientStats_t stats;
+} McuSPI_ClientDesc_t;
+
+static McuSPI_ClientDesc_t clients[McuSPI_NofClients] = {
+  [McuSPI_ClientLCD]   = {.name="lcd",   .priority=MCUSPI_CONFIG_LCD_PRIORITY,   .quantum=MCUSPI_CONFIG_LCD_QUANTUM},
+  [McuSPI_ClientTouch] = {.name="touch", .priority=MCUSPI_CONFIG_TOUCH_PRIORITY, .quantum=MCUSPI_CONFIG_TOUCH_QUANTUM},
+};
+
+#define MCUSPI_NO_CLIENT  McuSPI_NofClients
+
+static struct {
+  McuSPI_Client owner; /* client owning the bus, MCUSPI_NO_CLIENT if the bus is free */
+  TaskHandle_t ownerTask; /* task which has requested the bus, NULL if only an asynchronous transfer keeps it */
+  unsigned int nesting; /* number of nested requests of the owner task */
+  uint32_t grantCycles; /* cycle counter when the owner got the bus */
+  TickType_t statsStartTicks; /* tick count at the last reset of the statistics */
+} arbiter;
+
+static McuSPI_Client McuSPI_ConfigClient(McuSPI_Config config) {
+  return config==McuSPI_ConfigLCD ? McuSPI_ClientLCD : McuSPI_ClientTouch;
+}
+
+static void McuSPI_SetCS(McuSPI_Client client, bool active) {
+  if (clients[client].setCS!=NULL) {
+    clients[client].setCS(active);
+  }
+}
+
+#if MCUSPI_CONFIG_USE_DMA
+#define MCUSPI_DMA_MAX_TRANSFER_COUNT  (1024) /* XFERCOUNT is 10 bits */
+
+/* channel descriptor as used by the LPC DMA controller (SRAM configuration table) */
+typedef struct {
+  volatile uint32_t xfercfg; /* reload configuration, only used for linked descriptors */
+  void *srcEndAddr; /* address of the last source element */
+  void *dstEndAddr; /* address of the last destination element */
+  void *linkToNextDesc;
+} McuSPI_DmaDescriptor_t;
+
+/* the configuration table needs to be aligned on a 512 byte boundary */
+static McuSPI_DmaDescriptor_t dmaDescriptorTable[FSL_FEATURE_DMA_NUMBER_OF_CHANNELS] __attribute__((aligned(512)));
+
+typedef enum {
+  McuSPI_DmaBytes,      /* 8bit frames from a byte buffer */
+  McuSPI_DmaHalfwords,  /* 16bit frames from a uint16_t buffer */
+  McuSPI_DmaRepeat,     /* 'fillWord' gets written to FIFOWR again and again */
+} McuSPI_DmaMode_e;
+
+static struct {
+  volatile bool busy; /* transfer ongoing or suspended */
+  bool suspended; /* bus has been handed over to a client with higher priority, see McuSPI_DmaSuspend() */
+  McuSPI_Client client; /* client of the transfer */
+  McuSPI_Config config; /* bus configuration, to resume the transfer */
+  McuSPI_DmaMode_e mode;
+  const uint8_t *data; /* next data to transfer */
+  size_t nofRemaining; /* number of frames to be transferred with DMA, without the last one */
+  uint32_t ctrl; /* FIFOWR control bits (upper 16 bits) */
+  uint32_t fillWord; /* FIFOWR value (control bits and 16bit frame) for a repeated write */
+  McuSPI_DoneCallback done; /* callback at the end of the transfer */
+  void *param; /* callback parameter */
+} dmaXfer;
+
+static void McuSPI_DmaResume(void);
+#endif /* MCUSPI_CONFIG_USE_DMA */
+
+static bool McuSPI_TransferRunning(void) {
+  /* an asynchronous transfer is using the bus */
+#if MCUSPI_CONFIG_USE_DMA
+  return dmaXfer.busy && !dmaXfer.suspended;
+#else
+  return false;
+#endif
+}
+
+static bool McuSPI_IsSuspended(McuSPI_Client client) {
+#if MCUSPI_CONFIG_USE_DMA
+  return dmaXfer.suspended && dmaXfer.client==client;
+#else
+  (void)client;
+  return false;
+#endif
+}
+
+/* Hands the free bus over to the waiting client with the highest priority, or resumes the suspended transfer.
+ * Returns the client whose grant semaphore has to be given, MCUSPI_NO_CLIENT otherwise.
+ * Called with the DMA interrupt masked or from the DMA interrupt. */
+static McuSPI_Client McuSPI_ArbiterNext(void) {
+  McuSPI_Client next = MCUSPI_NO_CLIENT;
+
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    /* requests of the client with the suspended transfer have to wait until it is done */
+    if (clients[i].nofWaiting>0 && !McuSPI_IsSuspended(i) && (next==MCUSPI_NO_CLIENT || clients[i].priority>clients[next].priority)) {
+      next = i;
+    }
+  }
+#if MCUSPI_CONFIG_USE_DMA
+  if (dmaXfer.suspended && (next==MCUSPI_NO_CLIENT || clients[dmaXfer.client].priority>=clients[next].priority)) {
+    McuSPI_DmaResume();
+    return MCUSPI_NO_CLIENT;
+  }
+#endif
+  if (next!=MCUSPI_NO_CLIENT) {
+    clients[next].nofWaiting--;
+    clients[next].stats.nofGrants++;
+    arbiter.owner = next;
+    arbiter.ownerTask = NULL; /* gets set by the task taking the grant */
+    arbiter.nesting = 0;
+    arbiter.grantCycles = McuArmTools_GetCycleCounter();
+  }
+  return next;
+}
+
+/* the owner gives up the bus: returns the client to be granted, see McuSPI_ArbiterNext() */
+static McuSPI_Client McuSPI_ArbiterFree(void) {
+  if (arbiter.owner==MCUSPI_NO_CLIENT) {
+    return MCUSPI_NO_CLIENT; /* bus is not owned, nothing to free or to grant */
+  }
+  clients[arbiter.owner].stats.busyCycles += McuArmTools_GetCycleCounter()-arbiter.grantCycles;
+  arbiter.owner = MCUSPI_NO_CLIENT;
+  arbiter.ownerTask = NULL;
+  arbiter.nesting = 0;
+  return McuSPI_ArbiterNext();
+}
+
+void McuSPI_SwitchConfigFull(McuSPI_Config newConfig) {
+  if (SPI_MasterInit(DEVICE_SPI_MASTER, &configs[newConfig], DEVICE_SPI_MASTER_CLK_FREQ)!=kStatus_Success) {
+    for(;;) {
+      /* error */
+    }
+  }
+  McuSPI_CurrentConfig = newConfig;
+}
+
 void McuSPI_SwitchConfig(McuSPI_Config newConfig) {
+  /* Instead of SPI_MasterInit() (divider calculation, FIFO reset) only the registers which differ between the configurations
+   * get written. The bus is idle here: the previous transfer has ended with the FIFO empty and MSTIDLE set. */
+  const McuSPI_RegImage_t *img;
+  spi_config_t *drvConfig;
+
   if (McuSPI_CurrentConfig!=newConfig) {
-    if (SPI_MasterInit(DEVICE_SPI_MASTER, &configs[newConfig], DEVICE_SPI_MASTER_CLK_FREQ)!=kStatus_Success) {
-      for(;;) {
-        /* error */
-      }
-    }
+    img = &regImages[newConfig];
+    DEVICE_SPI_MASTER->CFG = img->cfg&~SPI_CFG_ENABLE_MASK; /* mode must only be changed with the SPI disabled */
+    DEVICE_SPI_MASTER->DIV = img->div;
+    DEVICE_SPI_MASTER->DLY = img->dly;
+    DEVICE_SPI_MASTER->FIFOTRIG = img->fifoTrig;
+    DEVICE_SPI_MASTER->CFG = img->cfg;
+    /* frame length and chip select used by SPI_MasterTransferBlocking() */
+    drvConfig = (spi_config_t*)SPI_GetConfig(DEVICE_SPI_MASTER);
+    drvConfig->dataWidth = configs[newConfig].dataWidth;
+    drvConfig->sselNum = configs[newConfig].sselNum;
     McuSPI_CurrentConfig = newConfig;
   }
 }
 
+void McuSPI_SetClientChipSelect(McuSPI_Client client, McuSPI_SetCSCallback setCS) {
+  clients[client].setCS = setCS;
+}
+
+void McuSPI_RequestBus(McuSPI_Client client) {
+  McuSPI_ClientDesc_t *desc = &clients[client];
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  McuSPI_Client grant = MCUSPI_NO_CLIENT;
+  uint32_t start, wait;
+
+  taskENTER_CRITICAL();
+  if (arbiter.ownerTask==self) { /* nested request */
+    arbiter.nesting++;
+    taskEXIT_CRITICAL();
+    return;
+  }
+  start = McuArmTools_GetCycleCounter();
+  desc->nofWaiting++;
+  if (arbiter.owner==MCUSPI_NO_CLIENT) {
+    grant = McuSPI_ArbiterNext(); /* bus is free: the request gets granted right away */
+  }
+  taskEXIT_CRITICAL();
+  if (grant!=MCUSPI_NO_CLIENT) {
+    (void)xSemaphoreGive(clients[grant].grant);
+  }
+  (void)xSemaphoreTake(desc->grant, portMAX_DELAY);
+  wait = McuArmTools_GetCycleCounter()-start;
+  taskENTER_CRITICAL();
+  arbiter.ownerTask = self;
+  arbiter.nesting = 1;
+  desc->stats.waitCycles += wait;
+  if (wait>desc->stats.maxWaitCycles) {
+    desc->stats.maxWaitCycles = wait;
+  }
+  taskEXIT_CRITICAL();
+}
+
+static void McuSPI_Release(McuSPI_Client client, bool deselect) {
+  McuSPI_ClientDesc_t *desc = &clients[client];
+  McuSPI_Client grant = MCUSPI_NO_CLIENT;
+
+  taskENTER_CRITICAL();
+  if (deselect) {
+#if MCUSPI_CONFIG_USE_DMA
+    if (dmaXfer.busy && dmaXfer.client==client) {
+      desc->deselectAtEnd = true; /* see McuSPI_DmaFinish() */
+    } else
+#endif
+    {
+      desc->selected = false;
+      McuSPI_SetCS(client, false);
+    }
+  }
+  arbiter.nesting--;
+  if (arbiter.nesting==0) {
+    arbiter.ownerTask = NULL;
+    if (!McuSPI_TransferRunning()) { /* otherwise the transfer keeps the bus until it is done */
+      grant = McuSPI_ArbiterFree();
+    }
+  }
+  taskEXIT_CRITICAL();
+  if (grant!=MCUSPI_NO_CLIENT) {
+    (void)xSemaphoreGive(clients[grant].grant);
+  }
+}
+
+void McuSPI_ReleaseBus(McuSPI_Client client) {
+  McuSPI_Release(client, false);
+}
+
+void McuSPI_Select(McuSPI_Client client) {
+  McuSPI_RequestBus(client);
+  clients[client].selected = true;
+  McuSPI_SetCS(client, true);
+}
+
+void McuSPI_Deselect(McuSPI_Client client) {
+  McuSPI_Release(client, true);
+}
+
 void McuSPI_WriteByte(McuSPI_Config config, uint8_t data) {
   spi_transfer_t xfer = {0};
 
@@ -93,14 +347,10 @@ void McuSPI_WriteByte(McuSPI_Config config, uint8_t data) {
   xfer.rxData   = NULL;
   xfer.dataSize = 1;
   xfer.configFlags = kSPI_FrameAssert; /* required to get CLK low after transfer */
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-#endif
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
   McuSPI_SwitchConfig(config);
   SPI_MasterTransferBlocking(DEVICE_SPI_MASTER, &xfer);
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreGiveRecursive(mutex);
-#endif
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
 }
 
 void McuSPI_WriteReadByte(McuSPI_Config config, uint8_t write, uint8_t *read) {
@@ -112,14 +362,10 @@ void McuSPI_WriteReadByte(McuSPI_Config config, uint8_t write, uint8_t *read) {
   xfer.rxData   = read;
   xfer.dataSize = 1;
   xfer.configFlags = kSPI_FrameAssert; /* required to get CLK low after transfer */
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-#endif
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
   McuSPI_SwitchConfig(config);
   SPI_MasterTransferBlocking(DEVICE_SPI_MASTER, &xfer);
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreGiveRecursive(mutex);
-#endif
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
 }
 
 void McuSPI_ReadByte(McuSPI_Config config, uint8_t *data) {
@@ -133,21 +379,479 @@ void MCUSPI_WriteBytes(McuSPI_Config config, uint8_t *data, size_t nofBytes) {
   xfer.rxData   = NULL;
   xfer.dataSize = nofBytes;
   xfer.configFlags = kSPI_FrameAssert; /* required to get CLK low after transfer */
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-#endif
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
   McuSPI_SwitchConfig(config);
   SPI_MasterTransferBlocking(DEVICE_SPI_MASTER, &xfer);
-#if MCUSPI_CONFIG_USE_MUTEX
-  xSemaphoreGiveRecursive(mutex);
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+}
+
+static uint32_t McuSPI_FifoCtrl(McuSPI_Config config, bool frame16) {
+  /* control bits of FIFOWR: chip select, frame length and ignoring the received data */
+  return (SPI_DEASSERT_ALL & (~SPI_DEASSERTNUM_SSEL(configs[config].sselNum)))
+       | SPI_FIFOWR_LEN(frame16?kSPI_Data16Bits:configs[config].dataWidth)
+       | SPI_FIFOWR_RXIGNORE_MASK;
+}
+
+static void McuSPI_WriteFifo(McuSPI_Config config, const uint8_t *data, size_t nofBytes, bool frame16) {
+  /* writes the bytes (or 16bit values) directly into the FIFO, ignoring received data. Bus must be reserved and configured. */
+  uint32_t ctrl, frame;
+  size_t nofFrames;
+
+  ctrl = McuSPI_FifoCtrl(config, frame16);
+  nofFrames = frame16?nofBytes/2:nofBytes;
+  while(nofFrames>0) {
+    while((DEVICE_SPI_MASTER->FIFOSTAT&SPI_FIFOSTAT_TXNOTFULL_MASK)==0) {
+      /* wait for space in the FIFO */
+    }
+    if (frame16) {
+      frame = *(const uint16_t*)data;
+      data += 2;
+    } else {
+      frame = *data++;
+    }
+    nofFrames--;
+    DEVICE_SPI_MASTER->FIFOWR = ctrl | (nofFrames==0?SPI_FIFOWR_EOT_MASK:0) | frame;
+  }
+  while((DEVICE_SPI_MASTER->FIFOSTAT&SPI_FIFOSTAT_TXEMPTY_MASK)==0) {
+    /* wait until FIFO is empty */
+  }
+  while((DEVICE_SPI_MASTER->STAT&SPI_STAT_MSTIDLE_MASK)==0) {
+    /* wait until last bit has been shifted out */
+  }
+}
+
+void McuSPI_WriteRepeated16(McuSPI_Config config, uint16_t value, size_t nofRepeats) {
+  /* each FIFO entry is a 16bit frame, independent of the data width of the configuration */
+  uint32_t ctrl;
+
+  if (nofRepeats==0) {
+    return;
+  }
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
+  McuSPI_SwitchConfig(config);
+  /* clear tx/rx errors and empty FIFOs */
+  DEVICE_SPI_MASTER->FIFOCFG |= SPI_FIFOCFG_EMPTYTX_MASK | SPI_FIFOCFG_EMPTYRX_MASK;
+  DEVICE_SPI_MASTER->FIFOSTAT |= SPI_FIFOSTAT_TXERR_MASK | SPI_FIFOSTAT_RXERR_MASK;
+  ctrl = McuSPI_FifoCtrl(config, true) | value;
+  while(nofRepeats>0) {
+    while((DEVICE_SPI_MASTER->FIFOSTAT&SPI_FIFOSTAT_TXNOTFULL_MASK)==0) {
+      /* wait for space in the FIFO */
+    }
+    nofRepeats--;
+    DEVICE_SPI_MASTER->FIFOWR = ctrl | (nofRepeats==0?SPI_FIFOWR_EOT_MASK:0);
+  }
+  while((DEVICE_SPI_MASTER->FIFOSTAT&SPI_FIFOSTAT_TXEMPTY_MASK)==0) {
+    /* wait until FIFO is empty */
+  }
+  while((DEVICE_SPI_MASTER->STAT&SPI_STAT_MSTIDLE_MASK)==0) {
+    /* wait until last bit has been shifted out */
+  }
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+}
+
+uint8_t McuSPI_WriteSegments(McuSPI_Config config, const McuSPI_Segment_t *segments, size_t nofSegments, McuSPI_SetDCCallback setDC) {
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
+  McuSPI_SwitchConfig(config);
+  /* clear tx/rx errors and empty FIFOs */
+  DEVICE_SPI_MASTER->FIFOCFG |= SPI_FIFOCFG_EMPTYTX_MASK | SPI_FIFOCFG_EMPTYRX_MASK;
+  DEVICE_SPI_MASTER->FIFOSTAT |= SPI_FIFOSTAT_TXERR_MASK | SPI_FIFOSTAT_RXERR_MASK;
+  for(size_t i=0; i<nofSegments; i++) {
+    if (setDC!=NULL && (i==0 || segments[i].dcHigh!=segments[i-1].dcHigh)) {
+      setDC(segments[i].dcHigh); /* previous segment has been shifted out */
+    }
+    McuSPI_WriteFifo(config, segments[i].data, segments[i].nofBytes, segments[i].frame16);
+  }
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+  return ERR_OK;
+}
+
+uint8_t McuSPI_WriteSegmentsAsync(McuSPI_Config config, const McuSPI_Segment_t *segments, size_t nofSegments, McuSPI_SetDCCallback setDC, McuSPI_DoneCallback done, void *param) {
+  const McuSPI_Segment_t *last;
+  uint8_t res;
+
+  if (nofSegments==0) {
+    return ERR_FAILED;
+  }
+  last = &segments[nofSegments-1];
+  McuSPI_RequestBus(McuSPI_ConfigClient(config));
+  (void)McuSPI_WriteSegments(config, segments, nofSegments-1, setDC);
+  if (setDC!=NULL && (nofSegments==1 || last->dcHigh!=segments[nofSegments-2].dcHigh)) {
+    setDC(last->dcHigh);
+  }
+  res = McuSPI_WriteAsync(config, last->data, last->nofBytes, last->frame16, done, param);
+  McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+  return res;
+}
+
+#if MCUSPI_CONFIG_USE_DMA
+static void McuSPI_DmaStartChunk(void) {
+  McuSPI_DmaDescriptor_t *desc = &dmaDescriptorTable[MCUSPI_CONFIG_DMA_TX_CHANNEL];
+  size_t nof;
+
+  nof = dmaXfer.nofRemaining;
+  if (nof>MCUSPI_DMA_MAX_TRANSFER_COUNT) {
+    nof = MCUSPI_DMA_MAX_TRANSFER_COUNT;
+  }
+  if (clients[dmaXfer.client].quantum>0 && nof>clients[dmaXfer.client].quantum) {
+    nof = clients[dmaXfer.client].quantum; /* the transfer can be suspended at the end of each chunk */
+  }
+  desc->dstEndAddr = (void*)&DEVICE_SPI_MASTER->FIFOWR;
+  desc->linkToNextDesc = NULL;
+  dmaXfer.nofRemaining -= nof;
+  if (dmaXfer.mode==McuSPI_DmaRepeat) {
+    desc->srcEndAddr = &dmaXfer.fillWord; /* source does not increment, so the end is the start */
+    DEVICE_SPI_DMA->CHANNEL[MCUSPI_CONFIG_DMA_TX_CHANNEL].XFERCFG =
+          DMA_CHANNEL_XFERCFG_CFGVALID_MASK
+        | DMA_CHANNEL_XFERCFG_SWTRIG_MASK
+        | DMA_CHANNEL_XFERCFG_CLRTRIG_MASK
+        | DMA_CHANNEL_XFERCFG_SETINTA_MASK
+        | DMA_CHANNEL_XFERCFG_WIDTH(2) /* 32bit: full FIFOWR word with the control bits */
+        | DMA_CHANNEL_XFERCFG_SRCINC(0)
+        | DMA_CHANNEL_XFERCFG_DSTINC(0)
+        | DMA_CHANNEL_XFERCFG_XFERCOUNT(nof-1);
+    return;
+  }
+  if (dmaXfer.mode==McuSPI_DmaHalfwords) {
+    desc->srcEndAddr = (void*)(dmaXfer.data+2*(nof-1));
+    dmaXfer.data += 2*nof;
+  } else {
+    desc->srcEndAddr = (void*)(dmaXfer.data+nof-1);
+    dmaXfer.data += nof;
+  }
+  DEVICE_SPI_DMA->CHANNEL[MCUSPI_CONFIG_DMA_TX_CHANNEL].XFERCFG =
+        DMA_CHANNEL_XFERCFG_CFGVALID_MASK
+      | DMA_CHANNEL_XFERCFG_SWTRIG_MASK /* no hardware trigger: start it, paced by the FIFO request */
+      | DMA_CHANNEL_XFERCFG_CLRTRIG_MASK
+      | DMA_CHANNEL_XFERCFG_SETINTA_MASK
+      | DMA_CHANNEL_XFERCFG_WIDTH(dmaXfer.mode==McuSPI_DmaHalfwords?1:0) /* 16bit or 8bit */
+      | DMA_CHANNEL_XFERCFG_SRCINC(1)
+      | DMA_CHANNEL_XFERCFG_DSTINC(0)
+      | DMA_CHANNEL_XFERCFG_XFERCOUNT(nof-1);
+}
+
+static void McuSPI_DmaStart(void) {
+  /* clear tx/rx errors and empty FIFOs */
+  DEVICE_SPI_MASTER->FIFOCFG |= SPI_FIFOCFG_EMPTYTX_MASK | SPI_FIFOCFG_EMPTYRX_MASK;
+  DEVICE_SPI_MASTER->FIFOSTAT |= SPI_FIFOSTAT_TXERR_MASK | SPI_FIFOSTAT_RXERR_MASK;
+  if (dmaXfer.mode!=McuSPI_DmaRepeat) { /* repeated writes carry the control bits in each 32bit word */
+    /* halfword write to the control bits does not push anything into the FIFO, but the control bits get used for the DMA data writes */
+    *(((volatile uint16_t *)&DEVICE_SPI_MASTER->FIFOWR)+1) = (uint16_t)(dmaXfer.ctrl>>16);
+  }
+  SPI_EnableTxDMA(DEVICE_SPI_MASTER, true);
+  McuSPI_DmaStartChunk();
+}
+
+static void McuSPI_DmaWaitShiftedOut(void) {
+  while((DEVICE_SPI_MASTER->FIFOSTAT&SPI_FIFOSTAT_TXEMPTY_MASK)==0) {
+    /* wait, at most a FIFO depth of bytes */
+  }
+  while((DEVICE_SPI_MASTER->STAT&SPI_STAT_MSTIDLE_MASK)==0) {
+    /* wait until last bit has been shifted out */
+  }
+}
+
+static bool McuSPI_DmaSuspendRequested(void) {
+  /* only once the task has released the bus, and only for a client with higher priority */
+  McuSPI_ClientDesc_t *desc = &clients[dmaXfer.client];
+
+  if (desc->quantum==0 || arbiter.ownerTask!=NULL) {
+    return false;
+  }
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    if (clients[i].nofWaiting>0 && clients[i].priority>desc->priority) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void McuSPI_DmaSuspend(void) {
+  /* called from the DMA interrupt at the end of a chunk: hand the bus over in the middle of the transfer */
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  McuSPI_Client grant;
+
+  McuSPI_DmaWaitShiftedOut();
+  SPI_EnableTxDMA(DEVICE_SPI_MASTER, false);
+  if (clients[dmaXfer.client].selected) {
+    McuSPI_SetCS(dmaXfer.client, false); /* the display keeps the memory write state, the next pixel continues after the chip select */
+  }
+  dmaXfer.suspended = true;
+  clients[dmaXfer.client].stats.nofSuspends++;
+  grant = McuSPI_ArbiterFree();
+  if (grant!=MCUSPI_NO_CLIENT) {
+    (void)xSemaphoreGiveFromISR(clients[grant].grant, &xHigherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void McuSPI_DmaResume(void) {
+  /* called by McuSPI_ArbiterNext() when the bus is free again */
+  dmaXfer.suspended = false;
+  arbiter.owner = dmaXfer.client;
+  arbiter.ownerTask = NULL;
+  arbiter.nesting = 0;
+  arbiter.grantCycles = McuArmTools_GetCycleCounter();
+  if (clients[dmaXfer.client].selected) {
+    McuSPI_SetCS(dmaXfer.client, true);
+  }
+  McuSPI_SwitchConfig(dmaXfer.config);
+  McuSPI_DmaStart();
+}
+
+static void McuSPI_DmaFinish(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  McuSPI_DoneCallback done;
+  McuSPI_ClientDesc_t *desc = &clients[dmaXfer.client];
+  McuSPI_Client grant = MCUSPI_NO_CLIENT;
+
+  /* last frame is written by the CPU, so it can carry the end-of-transfer flag */
+  if (dmaXfer.mode==McuSPI_DmaRepeat) {
+    DEVICE_SPI_MASTER->FIFOWR = dmaXfer.fillWord|SPI_FIFOWR_EOT_MASK;
+  } else if (dmaXfer.mode==McuSPI_DmaHalfwords) {
+    DEVICE_SPI_MASTER->FIFOWR = (dmaXfer.ctrl|SPI_FIFOWR_EOT_MASK) | *(const uint16_t*)dmaXfer.data;
+  } else {
+    DEVICE_SPI_MASTER->FIFOWR = (dmaXfer.ctrl|SPI_FIFOWR_EOT_MASK) | *dmaXfer.data;
+  }
+  McuSPI_DmaWaitShiftedOut();
+  SPI_EnableTxDMA(DEVICE_SPI_MASTER, false);
+  done = dmaXfer.done;
+  dmaXfer.busy = false;
+  if (desc->deselectAtEnd) {
+    desc->deselectAtEnd = false;
+    desc->selected = false;
+    McuSPI_SetCS(dmaXfer.client, false);
+  }
+  if (arbiter.ownerTask==NULL) { /* the task has released the bus already, otherwise it gets freed in McuSPI_ReleaseBus() */
+    grant = McuSPI_ArbiterFree();
+  }
+  if (grant!=MCUSPI_NO_CLIENT) {
+    (void)xSemaphoreGiveFromISR(clients[grant].grant, &xHigherPriorityTaskWoken);
+  }
+  if (done!=NULL) {
+    done(dmaXfer.param);
+  }
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+void DEVICE_SPI_DMA_IRQHandler(void) {
+  uint32_t mask = 1U<<MCUSPI_CONFIG_DMA_TX_CHANNEL;
+
+  if (DEVICE_SPI_DMA->COMMON[0].INTA&mask) {
+    DEVICE_SPI_DMA->COMMON[0].INTA = mask; /* clear flag */
+    if (dmaXfer.nofRemaining>0) {
+      if (McuSPI_DmaSuspendRequested()) {
+        McuSPI_DmaSuspend();
+      } else {
+        McuSPI_DmaStartChunk();
+      }
+    } else {
+      McuSPI_DmaFinish();
+    }
+  }
+  if (DEVICE_SPI_DMA->COMMON[0].ERRINT&mask) {
+    DEVICE_SPI_DMA->COMMON[0].ERRINT = mask; /* clear flag */
+    for(;;) { /* error */ }
+  }
+  __DSB();
+}
+#endif /* MCUSPI_CONFIG_USE_DMA */
+
+static uint8_t McuSPI_WriteAsync(McuSPI_Config config, const uint8_t *data, size_t nofBytes, bool frame16, McuSPI_DoneCallback done, void *param) {
+  size_t nofFrames;
+
+  nofFrames = frame16?nofBytes/2:nofBytes;
+  if (nofFrames==0) {
+    return ERR_FAILED;
+  }
+#if MCUSPI_CONFIG_USE_DMA
+  if (nofFrames>1) { /* for a single frame the setup is not worth it */
+    McuSPI_RequestBus(McuSPI_ConfigClient(config));
+    if (dmaXfer.busy) { /* nested request of the owner: its previous transfer is still running */
+      McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+      return ERR_BUSY;
+    }
+    McuSPI_SwitchConfig(config);
+    dmaXfer.busy = true;
+    dmaXfer.suspended = false;
+    dmaXfer.client = McuSPI_ConfigClient(config);
+    dmaXfer.config = config;
+    dmaXfer.mode = frame16?McuSPI_DmaHalfwords:McuSPI_DmaBytes;
+    dmaXfer.data = data;
+    dmaXfer.nofRemaining = nofFrames-1; /* last frame gets written at the end with the EOT flag */
+    dmaXfer.done = done;
+    dmaXfer.param = param;
+    dmaXfer.ctrl = McuSPI_FifoCtrl(config, frame16);
+    McuSPI_DmaStart();
+    McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+    return ERR_OK;
+  }
+#endif
+  McuSPI_Segment_t segment = {.dcHigh=false, .frame16=frame16, .data=data, .nofBytes=nofBytes};
+
+  (void)McuSPI_WriteSegments(config, &segment, 1, NULL); /* blocking, DC is not touched without a callback */
+  if (done!=NULL) {
+    done(param);
+  }
+  return ERR_OK;
+}
+
+uint8_t McuSPI_WriteBytesAsync(McuSPI_Config config, uint8_t *data, size_t nofBytes, McuSPI_DoneCallback done, void *param) {
+  return McuSPI_WriteAsync(config, data, nofBytes, false, done, param);
+}
+
+uint8_t McuSPI_WriteRepeated16Async(McuSPI_Config config, uint16_t value, size_t nofRepeats, McuSPI_DoneCallback done, void *param) {
+  if (nofRepeats==0) {
+    return ERR_FAILED;
+  }
+#if MCUSPI_CONFIG_USE_DMA
+  if (nofRepeats>1) {
+    McuSPI_RequestBus(McuSPI_ConfigClient(config));
+    if (dmaXfer.busy) { /* nested request of the owner: its previous transfer is still running */
+      McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+      return ERR_BUSY;
+    }
+    McuSPI_SwitchConfig(config);
+    dmaXfer.busy = true;
+    dmaXfer.suspended = false;
+    dmaXfer.client = McuSPI_ConfigClient(config);
+    dmaXfer.config = config;
+    dmaXfer.mode = McuSPI_DmaRepeat;
+    dmaXfer.nofRemaining = nofRepeats-1; /* last frame gets written at the end with the EOT flag */
+    dmaXfer.done = done;
+    dmaXfer.param = param;
+    dmaXfer.fillWord = McuSPI_FifoCtrl(config, true) | value;
+    McuSPI_DmaStart();
+    McuSPI_ReleaseBus(McuSPI_ConfigClient(config));
+    return ERR_OK;
+  }
+#endif
+  McuSPI_WriteRepeated16(config, value, nofRepeats);
+  if (done!=NULL) {
+    done(param);
+  }
+  return ERR_OK;
+}
+
+bool McuSPI_IsBusy(void) {
+#if MCUSPI_CONFIG_USE_DMA
+  return dmaXfer.busy;
+#else
+  return false;
+#endif
+}
+
+#if MCUSPI_CONFIG_USE_DMA
+static void McuSPI_InitDMA(void) {
+  CLOCK_EnableClock(kCLOCK_Dma0);
+  RESET_PeripheralReset(kDMA0_RST_SHIFT_RSTn);
+  DEVICE_SPI_DMA->SRAMBASE = (uint32_t)dmaDescriptorTable;
+  DEVICE_SPI_DMA->CTRL |= DMA_CTRL_ENABLE_MASK;
+  DEVICE_SPI_DMA->CHANNEL[MCUSPI_CONFIG_DMA_TX_CHANNEL].CFG = DMA_CHANNEL_CFG_PERIPHREQEN_MASK; /* paced by the SPI TX FIFO request */
+  DEVICE_SPI_DMA->COMMON[0].ENABLESET = 1U<<MCUSPI_CONFIG_DMA_TX_CHANNEL;
+  DEVICE_SPI_DMA->COMMON[0].INTENSET = 1U<<MCUSPI_CONFIG_DMA_TX_CHANNEL;
+  /* interrupt calls RTOS API, so it has to be at or below the max syscall priority */
+  NVIC_SetPriority(DEVICE_SPI_DMA_IRQ, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+  EnableIRQ(DEVICE_SPI_DMA_IRQ);
+
+  dmaXfer.busy = false;
+  dmaXfer.suspended = false;
+}
 #endif
+
+void McuSPI_GetClientStats(McuSPI_Client client, McuSPI_ClientStats_t *stats, uint32_t *elapsedMs) {
+  taskENTER_CRITICAL();
+  *stats = clients[client].stats;
+  if (arbiter.owner==client) { /* include the current ownership */
+    stats->busyCycles += McuArmTools_GetCycleCounter()-arbiter.grantCycles;
+  }
+  *elapsedMs = (xTaskGetTickCount()-arbiter.statsStartTicks)*portTICK_PERIOD_MS;
+  taskEXIT_CRITICAL();
+}
+
+void McuSPI_ResetStats(void) {
+  taskENTER_CRITICAL();
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    memset(&clients[i].stats, 0, sizeof(clients[i].stats));
+  }
+  arbiter.grantCycles = McuArmTools_GetCycleCounter();
+  arbiter.statsStartTicks = xTaskGetTickCount();
+  taskEXIT_CRITICAL();
+}
+
+#if MCUSPI_CONFIG_PARSE_COMMAND_ENABLED
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"McuSPI", (unsigned char*)"Group of SPI bus arbiter commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Reset the wait time and utilization statistics\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[64], name[16];
+  McuSPI_ClientStats_t stats;
+  uint32_t elapsedMs, cyclesPerUs;
+  uint64_t elapsedCycles;
+
+  McuShell_SendStatusStr((unsigned char*)"McuSPI", (unsigned char*)"\r\n", io->stdOut);
+  cyclesPerUs = SystemCoreClock/1000000U;
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    McuSPI_GetClientStats(i, &stats, &elapsedMs);
+    McuUtility_strcpy(name, sizeof(name), (unsigned char*)"  ");
+    McuUtility_strcat(name, sizeof(name), (const unsigned char*)clients[i].name);
+
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"prio ");
+    McuUtility_strcatNum8u(buf, sizeof(buf), clients[i].priority);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", quantum ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), clients[i].quantum);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", grants ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofGrants);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", suspends ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofSuspends);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    McuShell_SendStatusStr(name, buf, io->stdOut);
+
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"avg ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofGrants==0 ? 0 : (uint32_t)(stats.waitCycles/stats.nofGrants/cyclesPerUs));
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), stats.maxWaitCycles/cyclesPerUs);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+    McuShell_SendStatusStr((unsigned char*)"    wait", buf, io->stdOut);
+
+    elapsedCycles = (uint64_t)elapsedMs*(SystemCoreClock/1000U);
+    McuUtility_Num32uToStr(buf, sizeof(buf), elapsedCycles==0 ? 0 : (uint32_t)((stats.busyCycles*100U)/elapsedCycles));
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"% of ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), elapsedMs);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+    McuShell_SendStatusStr((unsigned char*)"    busy", buf, io->stdOut);
+  }
+  return ERR_OK;
+}
+
+uint8_t McuSPI_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "McuSPI help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "McuSPI status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strcmp((char*)cmd, "McuSPI reset")==0) {
+    *handled = TRUE;
+    McuSPI_ResetStats();
+    return ERR_OK;
+  }
+  return ERR_OK;
 }
+#endif /* MCUSPI_CONFIG_PARSE_COMMAND_ENABLED */
 
 void McuSPI_Deinit(void) {
-#if MCUSPI_CONFIG_USE_MUTEX
-  vSemaphoreDelete(mutex);
-  mutex = NULL;
+#if MCUSPI_CONFIG_USE_DMA
+  DisableIRQ(DEVICE_SPI_DMA_IRQ);
+  DEVICE_SPI_DMA->COMMON[0].ENABLECLR = 1U<<MCUSPI_CONFIG_DMA_TX_CHANNEL;
 #endif
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    vSemaphoreDelete(clients[i].grant);
+    clients[i].grant = NULL;
+  }
 }
 
 void McuSPI_Init(void) {
@@ -157,15 +861,32 @@ void McuSPI_Init(void) {
   /* reset FLEXCOMM for SPI */
   RESET_PeripheralReset(kFC7_RST_SHIFT_RSTn);
 
-  McuSPI_CurrentConfig = -1; /* give it an illegal value */
+  /* initialize the peripheral once for each configuration and keep the resulting register contents for McuSPI_SwitchConfig() */
+  for(size_t i=0; i<MCUSPI_NOF_CONFIGS; i++) {
+    McuSPI_SwitchConfigFull((McuSPI_Config)i);
+    regImages[i].cfg = DEVICE_SPI_MASTER->CFG;
+    regImages[i].div = DEVICE_SPI_MASTER->DIV;
+    regImages[i].dly = DEVICE_SPI_MASTER->DLY;
+    regImages[i].fifoTrig = DEVICE_SPI_MASTER->FIFOTRIG;
+  }
   McuSPI_SwitchConfig(McuSPI_ConfigLCD);
 
-#if MCUSPI_CONFIG_USE_MUTEX
-  mutex = xSemaphoreCreateRecursiveMutex();
-  if (mutex!=NULL) {
-    vQueueAddToRegistry(mutex, "McuSPIMutex");
-  } else {
-    for(;;) { /* error */ }
+  arbiter.owner = MCUSPI_NO_CLIENT;
+  arbiter.ownerTask = NULL;
+  arbiter.nesting = 0;
+  for(int i=0; i<McuSPI_NofClients; i++) {
+    clients[i].grant = xSemaphoreCreateBinary();
+    if (clients[i].grant!=NULL) {
+      vQueueAddToRegistry(clients[i].grant, "McuSPIGrant");
+    } else {
+      for(;;) { /* error */ }
+    }
+    clients[i].nofWaiting = 0;
+    clients[i].selected = false;
+    clients[i].deselectAtEnd = false;
   }
+  McuSPI_ResetStats();
+#if MCUSPI_CONFIG_USE_DMA
+  McuSPI_InitDMA();
 #endif
 }
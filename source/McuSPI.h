@@ -9,8 +9,10 @@
 #define MCUSPI_H_
 
 #include "platform.h"
+#include "McuSPIconfig.h"
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef enum {
   McuSPI_ConfigLCD,
@@ -20,13 +22,83 @@ typedef enum {
 #endif
 } McuSPI_Config;
 
+/* devices sharing the bus: the bus arbiter hands the bus over by priority, see McuSPIconfig.h */
+typedef enum {
+  McuSPI_ClientLCD,
+  McuSPI_ClientTouch,
+  McuSPI_NofClients /* sentinel, must be last */
+} McuSPI_Client;
+
+typedef void (*McuSPI_DoneCallback)(void *param); /* called at the end of an asynchronous transfer, possibly from interrupt context */
+typedef void (*McuSPI_SetCSCallback)(bool active); /* asserts or deasserts the chip select of a client, gets called from interrupt context too */
+
+/* sets the chip select of the client, used by McuSPI_Select() and McuSPI_Deselect() */
+void McuSPI_SetClientChipSelect(McuSPI_Client client, McuSPI_SetCSCallback setCS);
+
+/* switches the bus to the configuration with the register contents precomputed in McuSPI_Init(). The bus has to be idle */
 void McuSPI_SwitchConfig(McuSPI_Config newConfig);
 
+/* same as McuSPI_SwitchConfig(), but initializes the peripheral with the SDK driver. Used at initialization and for comparison in 'bench spi' */
+void McuSPI_SwitchConfigFull(McuSPI_Config newConfig);
+
+/* reserve the bus for a sequence of transfers. Waits until the bus is free, clients with higher priority are served first.
+ * An asynchronous transfer keeps the bus after McuSPI_ReleaseBus() until it is done. Can be nested by the same task. */
+void McuSPI_RequestBus(McuSPI_Client client);
+void McuSPI_ReleaseBus(McuSPI_Client client);
+
+/* same as McuSPI_RequestBus(), and asserts the chip select of the client */
+void McuSPI_Select(McuSPI_Client client);
+/* deasserts the chip select, or at the end of an asynchronous transfer of the client, and releases the bus */
+void McuSPI_Deselect(McuSPI_Client client);
+
 void McuSPI_WriteByte(McuSPI_Config config, uint8_t data);
 void MCUSPI_WriteBytes(McuSPI_Config config, uint8_t *data, size_t nofBytes);
 void McuSPI_WriteReadByte(McuSPI_Config config, uint8_t write, uint8_t *read);
 void McuSPI_ReadByte(McuSPI_Config config, uint8_t *data);
 
+/* one part of a transaction: the bytes get written with the DC (data/command) line at the given level */
+typedef struct {
+  bool dcHigh; /* level of the DC line for this segment */
+  bool frame16; /* data is an array of uint16_t, written as 16bit frames (MSB first) instead of bytes */
+  const uint8_t *data;
+  size_t nofBytes;
+} McuSPI_Segment_t;
+
+typedef void (*McuSPI_SetDCCallback)(bool high); /* sets the DC line of the device */
+
+/* writes a sequence of segments with the bus reserved and the configuration switched only once.
+ * The DC line gets changed only after the previous segment has been shifted out completely. */
+uint8_t McuSPI_WriteSegments(McuSPI_Config config, const McuSPI_Segment_t *segments, size_t nofSegments, McuSPI_SetDCCallback setDC);
+/* same as McuSPI_WriteSegments(), but the last segment gets written asynchronously, see McuSPI_WriteBytesAsync() */
+uint8_t McuSPI_WriteSegmentsAsync(McuSPI_Config config, const McuSPI_Segment_t *segments, size_t nofSegments, McuSPI_SetDCCallback setDC, McuSPI_DoneCallback done, void *param);
+
+/* starts writing the data and returns immediately. The buffer must stay valid until 'done' gets called.
+ * Returns ERR_BUSY if called with the bus reserved (McuSPI_RequestBus()) while the previous transfer is still running */
+uint8_t McuSPI_WriteBytesAsync(McuSPI_Config config, uint8_t *data, size_t nofBytes, McuSPI_DoneCallback done, void *param);
+bool McuSPI_IsBusy(void);
+
+/* writes the same 16bit value (MSB first) nofRepeats times, e.g. to fill a display area with a color. Uses 16bit frames, independent of the configuration */
+void McuSPI_WriteRepeated16(McuSPI_Config config, uint16_t value, size_t nofRepeats);
+/* same as McuSPI_WriteRepeated16(), but returns immediately. With DMA the source does not increment, so no buffer is needed */
+uint8_t McuSPI_WriteRepeated16Async(McuSPI_Config config, uint16_t value, size_t nofRepeats, McuSPI_DoneCallback done, void *param);
+
+typedef struct {
+  uint32_t nofGrants; /* number of times the client got the bus */
+  uint32_t nofSuspends; /* number of times an asynchronous transfer of the client got suspended for a client with higher priority */
+  uint64_t waitCycles; /* time waiting for the bus */
+  uint32_t maxWaitCycles; /* longest wait for the bus */
+  uint64_t busyCycles; /* time owning the bus, including the asynchronous transfers */
+} McuSPI_ClientStats_t;
+
+/* returns the statistics of the client and the time in ms since they have been reset */
+void McuSPI_GetClientStats(McuSPI_Client client, McuSPI_ClientStats_t *stats, uint32_t *elapsedMs);
+void McuSPI_ResetStats(void);
+
+#if MCUSPI_CONFIG_PARSE_COMMAND_ENABLED
+  #include "McuShell.h"
+  uint8_t McuSPI_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
+
 void McuSPI_Deinit(void);
 void McuSPI_Init(void);
 
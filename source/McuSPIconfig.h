@@ -8,10 +8,40 @@
 #ifndef MCUSPICONFIG_H_
 #define MCUSPICONFIG_H_
 
-#ifndef MCUSPI_CONFIG_USE_MUTEX
-  #define MCUSPI_CONFIG_USE_MUTEX    (1) /* required if sharing the SPI bus */
+#ifndef MCUSPI_CONFIG_LCD_PRIORITY
+  #define MCUSPI_CONFIG_LCD_PRIORITY     (1)
 #endif
-  /*!< 1: Use mutex for shared SPI bus access. 0: SPI bus is not shared */
+  /*!< bus arbiter priority of the display, higher value wins */
+
+#ifndef MCUSPI_CONFIG_TOUCH_PRIORITY
+  #define MCUSPI_CONFIG_TOUCH_PRIORITY   (2) /* touch reads are short, keep their latency low */
+#endif
+  /*!< bus arbiter priority of the touch controller, higher value wins */
+
+#ifndef MCUSPI_CONFIG_LCD_QUANTUM
+  #define MCUSPI_CONFIG_LCD_QUANTUM      (1024) /* 1024 pixels at 32 MHz are about 0.5 ms */
+#endif
+  /*!< number of frames of an asynchronous display transfer after which it gets suspended if a client with higher priority waits. 0: not suspended */
+
+#ifndef MCUSPI_CONFIG_TOUCH_QUANTUM
+  #define MCUSPI_CONFIG_TOUCH_QUANTUM    (0) /* only blocking transfers */
+#endif
+  /*!< same as MCUSPI_CONFIG_LCD_QUANTUM, for the touch controller */
+
+#ifndef MCUSPI_CONFIG_PARSE_COMMAND_ENABLED
+  #define MCUSPI_CONFIG_PARSE_COMMAND_ENABLED  (1)
+#endif
+  /*!< 1: shell command to print the bus arbiter statistics. 0: no shell command */
+
+#ifndef MCUSPI_CONFIG_USE_DMA
+  #define MCUSPI_CONFIG_USE_DMA      (1)
+#endif
+  /*!< 1: McuSPI_WriteBytesAsync() uses DMA and reports completion from the DMA interrupt. 0: asynchronous writes are done blocking */
+
+#ifndef MCUSPI_CONFIG_DMA_TX_CHANNEL
+  #define MCUSPI_CONFIG_DMA_TX_CHANNEL   (3) /* DMA0 request channel for the HS_LSPI (FLEXCOMM8) transmit FIFO */
+#endif
+  /*!< DMA0 channel used for the transmit FIFO, see the DMA request table in the LPC55S69 user manual */
 
 #define DEVICE_SPI_MASTER             SPI8
 #define DEVICE_SPI_MASTER_IRQ         FLEXCOMM8_IRQn
@@ -19,4 +49,8 @@
 #define DEVICE_SPI_MASTER_CLK_FREQ    CLOCK_GetFreq(kCLOCK_HsLspi)
 #define DEVICE_SPI_MASTER_IRQHandler  FLEXCOMM8_IRQHandler
 
+#define DEVICE_SPI_DMA                DMA0
+#define DEVICE_SPI_DMA_IRQ            DMA0_IRQn
+#define DEVICE_SPI_DMA_IRQHandler     DMA0_IRQHandler
+
 #endif /* MCUSPICONFIG_H_ */
@@ -12,14 +12,27 @@
 #include "McuUtility.h"
 #include "McuShell.h"
 #include "TouchCalibrate.h"
+#if MCUSTMPE610_CONFIG_USE_INT
+  #include "McuRTOS.h"
+  #include "fsl_iocon.h"
+#endif
 
 static McuSPI_Config configSPI = -1;
 
-#define SELECT_CONTROLLER()    McuGPIO_SetLow(McuSTMPE610_CSPin)
-#define DESELECT_CONTROLLER()  McuGPIO_SetHigh(McuSTMPE610_CSPin);
+/* shares the bus with the display: the bus arbiter in McuSPI.c drives the chip select, so it does not get asserted during a display DMA transfer */
+#define SELECT_CONTROLLER()    McuSPI_Select(McuSPI_ClientTouch)
+#define DESELECT_CONTROLLER()  McuSPI_Deselect(McuSPI_ClientTouch)
 
 static McuGPIO_Handle_t McuSTMPE610_CSPin;
 
+static void McuSTMPE610_SetCS(bool active) {
+  /* CS is LOW active */
+  McuGPIO_SetValue(McuSTMPE610_CSPin, !active);
+}
+#if MCUSTMPE610_CONFIG_USE_INT
+  static McuSTMPE610_IntCallback intCallback = NULL;
+#endif
+
 uint8_t McuSTMPE610_WriteReg8(uint8_t reg, uint8_t val) {
   SELECT_CONTROLLER();
   McuSPI_WriteByte(configSPI, reg);
@@ -74,6 +87,17 @@ uint8_t McuSTMPE610_IsTouched(bool *touched) {
   return ERR_OK;
 }
 
+static void McuSTMPE610_DecodeXYZ(const uint8_t data[4], uint16_t *x, uint16_t *y, uint8_t *z) {
+  /* 12bit x, 12bit y and 8bit z packed into 4 bytes */
+  *x = data[0];
+  *x <<= 4;
+  *x |= (data[1]>>4);
+  *y = data[1]&0x0F;
+  *y <<= 8;
+  *y |= data[2];
+  *z = data[3];
+}
+
 uint8_t McuSTMPE610_ReadTouchData(uint16_t *x, uint16_t *y, uint8_t *z) {
   uint8_t data[4], res;
   bool empty;
@@ -84,13 +108,7 @@ uint8_t McuSTMPE610_ReadTouchData(uint16_t *x, uint16_t *y, uint8_t *z) {
       return res;
     }
   }
-  *x = data[0];
-  *x <<= 4;
-  *x |= (data[1]>>4);
-  *y = data[1]&0x0F;
-  *y <<= 8;
-  *y |= data[2];
-  *z = data[3];
+  McuSTMPE610_DecodeXYZ(data, x, y, z);
   res = McuSTMPE610_FIFOisEmpty(&empty);
   if (res==ERR_OK && empty) {
     res = McuSTMPE610_WriteReg8(MCUSTMPE610_INT_STA_REG, 0xff); /* reset all interrupts */
@@ -101,6 +119,38 @@ uint8_t McuSTMPE610_ReadTouchData(uint16_t *x, uint16_t *y, uint8_t *z) {
   return ERR_OK;
 }
 
+uint8_t McuSTMPE610_ReadFIFO(McuSTMPE610_TouchPoint *points, uint8_t maxPoints, uint8_t *nofPoints) {
+  uint8_t data[4], size, res;
+
+  *nofPoints = 0;
+  res = McuSTMPE610_FIFOBufSize(&size);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  if (size>maxPoints) {
+    size = maxPoints; /* the remaining points stay in the FIFO for the next call */
+  }
+  if (size==0) {
+    return ERR_OK;
+  }
+  /* read all points in a single chip select cycle: every address byte clocks out the next FIFO byte */
+  SELECT_CONTROLLER();
+  McuSPI_WriteByte(configSPI, 0x80|MCUSTMPE610_TSC_DATA_REG); /* MSB to denote read operation */
+  for(uint8_t i=0; i<size; i++) {
+    for(uint8_t j=0; j<sizeof(data); j++) {
+      if (i==size-1 && j==sizeof(data)-1) {
+        McuSPI_ReadByte(configSPI, &data[j]); /* last byte: no further read address */
+      } else {
+        McuSPI_WriteReadByte(configSPI, 0x80|MCUSTMPE610_TSC_DATA_REG, &data[j]);
+      }
+    }
+    McuSTMPE610_DecodeXYZ(data, &points[i].x, &points[i].y, &points[i].z);
+  }
+  DESELECT_CONTROLLER();
+  *nofPoints = size;
+  return ERR_OK;
+}
+
 uint8_t McuSTMPE610_GetPoint(uint16_t *x, uint16_t *y, uint8_t *z) {
   uint16_t xp, yp;
   uint8_t zp;
@@ -199,7 +249,11 @@ uint8_t McuSTMPE610_InitController(void) {
   McuSTMPE610_WriteReg8(MCUSTMPE610_SYS_CTRL1_REG, MCUSTMPE610_SYS_CTRL1_RESET); /* reset */
   McuSTMPE610_WriteReg8(MCUSTMPE610_SYS_CTRL2_REG, 0x0); /* turn on clocks */
   McuSTMPE610_WriteReg8(MCUSTMPE610_TSC_CTRL_REG, MCUSTMPE610_TSC_CTRL_XYZ | MCUSTMPE610_TSC_CTRL_EN); /* XYZ enable */
+#if MCUSTMPE610_CONFIG_USE_INT
+  McuSTMPE610_WriteReg8(MCUSTMPE610_INT_EN_REG, MCUSTMPE610_INT_EN_TOUCHDET|MCUSTMPE610_INT_EN_FIFOTH); /* pen down/up and new samples */
+#else
   McuSTMPE610_WriteReg8(MCUSTMPE610_INT_EN_REG, MCUSTMPE610_INT_EN_TOUCHDET);
+#endif
   McuSTMPE610_WriteReg8(MCUSTMPE610_ADC_CTRL1_REG, MCUSTMPE610_ADC_CTRL1_10BIT | (0x6 << 4)); /* 96 clocks per conversion */
   McuSTMPE610_WriteReg8(MCUSTMPE610_ADC_CTRL2_REG, MCUSTMPE610_ADC_CTRL2_6_5MHZ);
   McuSTMPE610_WriteReg8(MCUSTMPE610_TSC_CFG_REG, MCUSTMPE610_TSC_CFG_4SAMPLE | MCUSTMPE610_TSC_CFG_DELAY_1MS | MCUSTMPE610_TSC_CFG_SETTLE_5MS);
@@ -210,10 +264,56 @@ uint8_t McuSTMPE610_InitController(void) {
   McuSTMPE610_WriteReg8(MCUSTMPE610_TSC_I_DRIVE_REG, MCUSTMPE610_TSC_I_DRIVE_50MA);
   McuSTMPE610_WriteReg8(MCUSTMPE610_INT_STA_REG, 0xFF); /* reset all ints */
   McuSTMPE610_WriteReg8(MCUSTMPE610_INT_CTRL_REG, MCUSTMPE610_INT_CTRL_POL_HIGH | MCUSTMPE610_INT_CTRL_ENABLE);
+#if MCUSTMPE610_CONFIG_USE_INT
+  PINT->SIENR = 1U<<MCUSTMPE610_INT_PINT_CHANNEL; /* controller is ready: unmask the pin interrupt */
+#endif
   return ERR_OK;
 }
 
+#if MCUSTMPE610_CONFIG_USE_INT
+void MCUSTMPE610_INT_IRQHandler(void) {
+  /* The INT line is level sensitive and stays asserted until INT_STA gets cleared over SPI.
+   * Mask it here and let the callback defer the SPI access to task context. */
+  PINT->CIENR = 1U<<MCUSTMPE610_INT_PINT_CHANNEL;
+  if (intCallback!=NULL) {
+    intCallback();
+  }
+  __DSB();
+}
+
+void McuSTMPE610_SetIntCallback(McuSTMPE610_IntCallback callback) {
+  intCallback = callback;
+}
+
+uint8_t McuSTMPE610_AckInterrupt(void) {
+  uint8_t res;
+
+  res = McuSTMPE610_WriteReg8(MCUSTMPE610_INT_STA_REG, 0xFF); /* reset all interrupts, releases the INT line */
+  /* unmask: if the controller raised INT again in the meantime, the interrupt fires right away */
+  PINT->SIENR = 1U<<MCUSTMPE610_INT_PINT_CHANNEL;
+  return res;
+}
+
+static void McuSTMPE610_InitInterrupt(void) {
+  IOCON_PinMuxSet(IOCON, MCUSTMPE610_INT_PORT, MCUSTMPE610_INT_PIN, IOCON_FUNC0|IOCON_MODE_INACT|IOCON_DIGITAL_EN);
+  CLOCK_EnableClock(kCLOCK_InputMux);
+  CLOCK_EnableClock(kCLOCK_Pint);
+  INPUTMUX->PINTSEL[MCUSTMPE610_INT_PINT_CHANNEL] = INPUTMUX_PINTSEL_INTPIN(MCUSTMPE610_INT_PORT*32U+MCUSTMPE610_INT_PIN);
+  PINT->CIENR = 1U<<MCUSTMPE610_INT_PINT_CHANNEL; /* masked until McuSTMPE610_InitController() */
+  PINT->ISEL |= 1U<<MCUSTMPE610_INT_PINT_CHANNEL; /* level sensitive */
+  PINT->SIENF = 1U<<MCUSTMPE610_INT_PINT_CHANNEL; /* active high, matches MCUSTMPE610_INT_CTRL_POL_HIGH */
+  NVIC_SetPriority(MCUSTMPE610_INT_IRQ, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+  NVIC_EnableIRQ(MCUSTMPE610_INT_IRQ);
+}
+#endif /* MCUSTMPE610_CONFIG_USE_INT */
+
 void McuSTMPE610_Deinit(void) {
+#if MCUSTMPE610_CONFIG_USE_INT
+  NVIC_DisableIRQ(MCUSTMPE610_INT_IRQ);
+  PINT->CIENR = 1U<<MCUSTMPE610_INT_PINT_CHANNEL;
+  intCallback = NULL;
+#endif
+  McuSPI_SetClientChipSelect(McuSPI_ClientTouch, NULL);
   McuSTMPE610_CSPin = McuGPIO_DeinitGPIO(McuSTMPE610_CSPin);
   configSPI = -1;
 }
@@ -230,6 +330,10 @@ void McuSTMPE610_Init(void) {
   config.hw.port = MCUSTMPE610_CS_PORT;
   config.hw.gpio = MCUSTMPE610_CS_GPIO;
   McuSTMPE610_CSPin = McuGPIO_InitGPIO(&config);
+  McuSPI_SetClientChipSelect(McuSPI_ClientTouch, McuSTMPE610_SetCS);
 
   configSPI = McuSPI_ConfigTouch1; /* default configuration */
+#if MCUSTMPE610_CONFIG_USE_INT
+  McuSTMPE610_InitInterrupt();
+#endif
 }
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "McuSTMPE610config.h"
 
 /* see https://github.com/adafruit/Adafruit_STMPE610 for register definition */
 #define MCUSTMPE610_CHIP_ID_REG       0x00
@@ -115,6 +116,7 @@
 #define MCUSTMPE610_TSC_FRACTION_Z_REG  0x56
 
 #define MCUSTMPE610_TSC_DATA_XYZ_REG    0x52
+#define MCUSTMPE610_TSC_DATA_REG        0x57 /* reading it repeatedly pops the FIFO byte by byte */
 
 
 /* Touchscreen controller drive I */
@@ -122,6 +124,10 @@
   #define MCUSTMPE610_TSC_I_DRIVE_20MA 0x00
   #define MCUSTMPE610_TSC_I_DRIVE_50MA 0x01
 
+typedef struct {
+  uint16_t x, y; /* raw ADC values */
+  uint8_t z; /* pressure: the harder the press, the lower the number */
+} McuSTMPE610_TouchPoint;
 
 uint8_t McuSTMPE610_ReadReg8(uint8_t addr, uint8_t *val);
 uint8_t McuSTMPE610_ReadReg16(uint8_t addr, uint16_t *val);
@@ -131,6 +137,7 @@ uint8_t McuSTMPE610_FIFOisEmpty(bool *isEmpty);
 uint8_t McuSTMPE610_FIFOBufSize(uint8_t *size);
 uint8_t McuSTMPE610_IsTouched(bool *touched);
 uint8_t McuSTMPE610_ReadTouchData(uint16_t *x, uint16_t *y, uint8_t *z);
+uint8_t McuSTMPE610_ReadFIFO(McuSTMPE610_TouchPoint *points, uint8_t maxPoints, uint8_t *nofPoints);
 uint8_t McuSTMPE610_GetPoint(uint16_t *x, uint16_t *y, uint8_t *z);
 uint8_t McuSTMPE610_GetLastPoint(uint16_t *x, uint16_t *y, uint8_t *z);
 uint8_t McuSTMPE610_GetCalibratedCoordinates(uint16_t *x, uint16_t *y, uint8_t *z);
@@ -138,6 +145,13 @@ uint8_t McuSTMPE610_GetRawCoordinates(uint16_t *x, uint16_t *y, uint8_t *z);
 uint8_t McuSTMPE610_CheckAndSwitchSPIMode(void);
 uint8_t McuSTMPE610_InitController(void);
 
+#if MCUSTMPE610_CONFIG_USE_INT
+typedef void (*McuSTMPE610_IntCallback)(void); /* called from the pin interrupt, the interrupt stays masked until McuSTMPE610_AckInterrupt() */
+
+void McuSTMPE610_SetIntCallback(McuSTMPE610_IntCallback callback);
+uint8_t McuSTMPE610_AckInterrupt(void);
+#endif
+
 void McuSTMPE610_Deinit(void);
 void McuSTMPE610_Init(void);
 
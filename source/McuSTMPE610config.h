@@ -13,4 +13,18 @@
 #define MCUSTMPE610_CS_PORT   1U
 #define MCUSTMPE610_CS_PIN    8U
 
+#include "platform.h"
+
+#ifndef MCUSTMPE610_CONFIG_USE_INT
+  #define MCUSTMPE610_CONFIG_USE_INT   (1 && PL_CONFIG_USE_STMPE610)
+#endif
+  /*!< 1: the INT line of the controller raises a pin interrupt and the FIFO is read on demand. 0: the controller has to be polled */
+
+/* INT: IRQ pad of the shield (active high, level), wired to PIO1_9 */
+#define MCUSTMPE610_INT_PORT          1U
+#define MCUSTMPE610_INT_PIN           9U
+#define MCUSTMPE610_INT_PINT_CHANNEL  2U /* PINT channel 0 and 1 are used by the board push buttons */
+#define MCUSTMPE610_INT_IRQ           PIN_INT2_IRQn
+#define MCUSTMPE610_INT_IRQHandler    PIN_INT2_IRQHandler
+
 #endif /* MCUSTMPE610CONFIG_H_ */
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Named EQ presets in the on-chip flash. All presets are fixed size records of one store, which is written as one NVM
+ * block (with the CRC of the NVM header). A flash page has to be erased before it can be programmed again, so the
+ * store rotates through NVM_CONFIG_NOF_PRESET_PAGES pages with a sequence number: the valid page with the highest
+ * one is the current. A write erases the oldest page only, so the previous store is still there if it gets interrupted.
+ * The index of the last used preset is part of the store and gets applied at power-up, before the GUI is created.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_PRESET
+#include "Preset.h"
+#include "nvm.h"
+#include "McuRTOS.h"
+#include <string.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuUtility.h"
+#endif
+#if PL_CONFIG_USE_CODEC
+  #include "codec.h"
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  #include "EqDsp.h"
+#endif
+#if PL_CONFIG_USE_GUI
+  #include "lv.h"
+#endif
+
+#define PRESET_NOF_PAGES    (NVM_BLOCK_PRESET_LAST-NVM_BLOCK_PRESET_FIRST+1)
+
+typedef struct {
+  uint32_t seq; /* incremented with each write, the page with the highest number is the current one */
+  uint8_t active; /* index of the last used preset, or PRESET_NONE */
+  uint8_t nofPresets; /* presets[0..nofPresets-1] are used */
+  uint16_t reserved;
+  Preset_Curve_t presets[PRESET_CONFIG_MAX_PRESETS];
+} Preset_Store_t;
+
+_Static_assert(sizeof(Preset_Curve_t)==16, "preset records have a fixed size");
+_Static_assert(sizeof(Preset_Store_t)<=NVM_BLOCK_MAX_DATA_SIZE, "store has to fit into one NVM block");
+#if PL_CONFIG_USE_EQ_DSP
+_Static_assert(PRESET_NOF_BANDS==EQDSP_NOF_BANDS, "one gain per band of the EQ");
+#endif
+
+static Preset_Store_t store; /* copy of the current page */
+static uint8_t storePage; /* page of the store, relative to NVM_BLOCK_PRESET_FIRST */
+static bool storeValid; /* store has been read from flash, otherwise it has the defaults */
+static uint32_t nofWrites; /* since power-up */
+static SemaphoreHandle_t storeMutex; /* store changes and flash writes */
+
+static Preset_Curve_t live; /* settings of the EQ */
+static Preset_Curve_t selected; /* preset to be applied by the GUI */
+static bool selectedPending;
+
+static const Preset_Curve_t presetFlat = {"flat", {0, 0, 0, 0, 0}, 0, {0, 0}}; /* EQ as without presets */
+
+void Preset_GetLive(Preset_Curve_t *curve) {
+  taskENTER_CRITICAL();
+  *curve = live;
+  taskEXIT_CRITICAL();
+}
+
+void Preset_SetLiveGain(uint8_t band, int8_t gainDb) {
+  if (band<PRESET_NOF_BANDS) {
+    live.gainDb[band] = gainDb; /* single byte, no need for a critical section */
+  }
+}
+
+void Preset_SetLiveEnabled(bool enabled) {
+  live.enabled = enabled;
+}
+
+/* applies a curve to the codec and the EQ. Only the bands which change are written: the codec task skips values
+ * which it has written already, and EqDsp only recomputes on a change */
+static void Preset_ApplyCurve(const Preset_Curve_t *curve) {
+  for(int b=0; b<PRESET_NOF_BANDS; b++) {
+#if PL_CONFIG_USE_CODEC
+    (void)CODEC_WriteRegister(CODEC_REG_EQ_GAIN(b), (uint16_t)(12+curve->gainDb[b])); /* 0 is -12 dB */
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+    EqDsp_SetGain(b, curve->gainDb[b]);
+#endif
+  }
+#if PL_CONFIG_USE_CODEC
+  (void)CODEC_WriteRegister(CODEC_REG_EQ1, curve->enabled ? 0x1 : 0x0);
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  EqDsp_SetEnabled(curve->enabled!=0);
+#endif
+  taskENTER_CRITICAL();
+  live = *curve;
+  taskEXIT_CRITICAL();
+}
+
+/* writes the store to the page after the current one, skipping pages which fail. The current page is never
+ * overwritten, so it keeps the last good copy. Called with the mutex taken */
+static uint8_t Preset_WriteStore(void) {
+  uint8_t page;
+
+  store.seq++;
+  for(int i=1; i<PRESET_NOF_PAGES; i++) {
+    page = (storePage+i)%PRESET_NOF_PAGES;
+    if (NVM_WriteBlock(NVM_BLOCK_PRESET_FIRST+page, &store, sizeof(store))==ERR_OK) {
+      storePage = page;
+      storeValid = true;
+      nofWrites++;
+      return ERR_OK;
+    }
+  }
+  store.seq--; /* nothing written: the current page still has the highest number */
+  return ERR_FAILED;
+}
+
+static int Preset_Find(const char *name) {
+  for(int i=0; i<store.nofPresets; i++) {
+    if (strncmp(store.presets[i].name, name, PRESET_NAME_SIZE)==0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint8_t Preset_Select(uint8_t index) {
+  uint8_t res = ERR_OK;
+
+  (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+  if (index>=store.nofPresets) {
+    (void)xSemaphoreGive(storeMutex);
+    return ERR_RANGE;
+  }
+  if (store.active!=index) { /* selecting the same preset again does not wear the flash */
+    store.active = index;
+    res = Preset_WriteStore();
+  }
+#if PL_CONFIG_USE_GUI
+  /* the GUI applies it band by band through the gain columns, so they stay in sync with the EQ */
+  taskENTER_CRITICAL();
+  selected = store.presets[index];
+  selectedPending = true;
+  memcpy(live.name, selected.name, sizeof(live.name));
+  taskEXIT_CRITICAL();
+  LV_Notify(LV_NOTIFY_WAKEUP);
+#else
+  Preset_ApplyCurve(&store.presets[index]);
+#endif
+  (void)xSemaphoreGive(storeMutex);
+  return res;
+}
+
+bool Preset_TakeSelected(Preset_Curve_t *curve) {
+  bool pending;
+
+  taskENTER_CRITICAL();
+  pending = selectedPending;
+  if (pending) {
+    *curve = selected;
+    selectedPending = false;
+  }
+  taskEXIT_CRITICAL();
+  return pending;
+}
+
+uint8_t Preset_Save(const char *name) {
+  Preset_Curve_t curve;
+  uint8_t res = ERR_OK;
+  int i;
+
+  if (name[0]=='\0' || strlen(name)>=PRESET_NAME_SIZE) {
+    return ERR_FAILED;
+  }
+  Preset_GetLive(&curve);
+  memset(curve.name, 0, sizeof(curve.name)); /* no garbage after the name in flash */
+  strcpy(curve.name, name);
+  memset(curve.reserved, 0, sizeof(curve.reserved));
+  (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+  i = Preset_Find(name);
+  if (i<0) {
+    if (store.nofPresets>=PRESET_CONFIG_MAX_PRESETS) {
+      (void)xSemaphoreGive(storeMutex);
+      return ERR_OVERFLOW;
+    }
+    i = store.nofPresets++;
+  } else if (store.active==i && memcmp(&store.presets[i], &curve, sizeof(curve))==0) {
+    (void)xSemaphoreGive(storeMutex);
+    return ERR_OK; /* no change, no write */
+  }
+  store.presets[i] = curve;
+  store.active = (uint8_t)i;
+  res = Preset_WriteStore();
+  taskENTER_CRITICAL();
+  memcpy(live.name, curve.name, sizeof(live.name));
+  taskEXIT_CRITICAL();
+  (void)xSemaphoreGive(storeMutex);
+  return res;
+}
+
+uint8_t Preset_Delete(const char *name) {
+  uint8_t res;
+  int i;
+
+  (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+  i = Preset_Find(name);
+  if (i<0) {
+    (void)xSemaphoreGive(storeMutex);
+    return ERR_FAILED;
+  }
+  store.nofPresets--;
+  memmove(&store.presets[i], &store.presets[i+1], (store.nofPresets-i)*sizeof(store.presets[0]));
+  memset(&store.presets[store.nofPresets], 0, sizeof(store.presets[0]));
+  if (store.active==i) {
+    store.active = PRESET_NONE; /* the EQ keeps its settings */
+  } else if (store.active!=PRESET_NONE && store.active>i) {
+    store.active--;
+  }
+  res = Preset_WriteStore();
+  (void)xSemaphoreGive(storeMutex);
+  return res;
+}
+
+#if PL_CONFIG_USE_SHELL
+static void Preset_StrcatCurve(uint8_t *buf, size_t bufSize, const Preset_Curve_t *curve) {
+  for(int b=0; b<PRESET_NOF_BANDS; b++) {
+    McuUtility_strcatNum32s(buf, bufSize, curve->gainDb[b]);
+    McuUtility_chcat(buf, bufSize, ' ');
+  }
+  McuUtility_strcat(buf, bufSize, curve->enabled ? (unsigned char*)"dB, on" : (unsigned char*)"dB, off");
+}
+
+static uint8_t PrintList(const McuShell_StdIOType *io) {
+  uint8_t buf[48], name[16];
+
+  (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+  for(int i=0; i<store.nofPresets; i++) {
+    McuUtility_strcpy(name, sizeof(name), (unsigned char*)(i==store.active ? "  * " : "    "));
+    McuUtility_strcat(name, sizeof(name), (unsigned char*)store.presets[i].name);
+    buf[0] = '\0';
+    Preset_StrcatCurve(buf, sizeof(buf), &store.presets[i]);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    McuShell_SendStatusStr(name, buf, io->stdOut);
+  }
+  (void)xSemaphoreGive(storeMutex);
+  return ERR_OK;
+}
+
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+  Preset_Curve_t curve;
+
+  McuShell_SendStatusStr((unsigned char*)"preset", (unsigned char*)"\r\n", io->stdOut);
+  (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+  if (storeValid) {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"page ");
+    McuUtility_strcatNum8u(buf, sizeof(buf), storePage);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" of ");
+    McuUtility_strcatNum8u(buf, sizeof(buf), PRESET_NOF_PAGES);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", seq ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), store.seq);
+  } else {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"not written, defaults");
+  }
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  store", buf, io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), store.nofPresets);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" of ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), PRESET_CONFIG_MAX_PRESETS);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), nofWrites);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" writes\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  presets", buf, io->stdOut);
+  Preset_GetLive(&curve);
+  if (store.active==PRESET_NONE) {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"none");
+  } else {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)store.presets[store.active].name);
+    if (memcmp(curve.gainDb, store.presets[store.active].gainDb, sizeof(curve.gainDb))!=0
+        || curve.enabled!=store.presets[store.active].enabled)
+    {
+      McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" (changed)");
+    }
+  }
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  (void)xSemaphoreGive(storeMutex);
+  McuShell_SendStatusStr((unsigned char*)"  active", buf, io->stdOut);
+  buf[0] = '\0';
+  Preset_StrcatCurve(buf, sizeof(buf), &curve);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  live", buf, io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"preset", (unsigned char*)"Group of EQ preset commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  list", (unsigned char*)"List the stored presets, * is the active one\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  save <name>", (unsigned char*)"Store the current EQ settings, up to 7 characters\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  load <name>", (unsigned char*)"Apply a preset, it gets restored at power-up\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  delete <name>", (unsigned char*)"Remove a preset\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+uint8_t Preset_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  const char *name;
+  uint8_t res;
+  int i;
+
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "preset help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "preset status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strcmp((char*)cmd, "preset list")==0) {
+    *handled = TRUE;
+    return PrintList(io);
+  } else if (McuUtility_strncmp((char*)cmd, "preset save ", sizeof("preset save ")-1)==0) {
+    *handled = TRUE;
+    name = (const char*)cmd+sizeof("preset save ")-1;
+    res = Preset_Save(name);
+    if (res==ERR_OVERFLOW) {
+      McuShell_SendStr((unsigned char*)"no free preset\r\n", io->stdErr);
+    } else if (res!=ERR_OK) {
+      McuShell_SendStr((unsigned char*)"failed, name has to be 1 to 7 characters\r\n", io->stdErr);
+    }
+    return res;
+  } else if (McuUtility_strncmp((char*)cmd, "preset load ", sizeof("preset load ")-1)==0) {
+    *handled = TRUE;
+    name = (const char*)cmd+sizeof("preset load ")-1;
+    (void)xSemaphoreTake(storeMutex, portMAX_DELAY);
+    i = Preset_Find(name);
+    (void)xSemaphoreGive(storeMutex);
+    if (i<0) {
+      McuShell_SendStr((unsigned char*)"unknown preset\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    return Preset_Select((uint8_t)i);
+  } else if (McuUtility_strncmp((char*)cmd, "preset delete ", sizeof("preset delete ")-1)==0) {
+    *handled = TRUE;
+    name = (const char*)cmd+sizeof("preset delete ")-1;
+    if (Preset_Delete(name)!=ERR_OK) {
+      McuShell_SendStr((unsigned char*)"unknown preset\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    return ERR_OK;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_SHELL */
+
+/* reads all pages and keeps the valid one with the highest sequence number */
+static void Preset_LoadStore(void) {
+  static Preset_Store_t page; /* not on the stack */
+
+  storeValid = false;
+  for(int i=0; i<PRESET_NOF_PAGES; i++) {
+    if (NVM_ReadBlock(NVM_BLOCK_PRESET_FIRST+i, &page, sizeof(page))!=ERR_OK
+        || page.nofPresets>PRESET_CONFIG_MAX_PRESETS
+        || (page.active!=PRESET_NONE && page.active>=page.nofPresets))
+    {
+      continue;
+    }
+    if (!storeValid || (int32_t)(page.seq-store.seq)>0) { /* wraps around */
+      store = page;
+      storePage = (uint8_t)i;
+      storeValid = true;
+    }
+  }
+  if (!storeValid) { /* never written: one flat preset, written with the first change */
+    memset(&store, 0, sizeof(store));
+    store.presets[0] = presetFlat;
+    store.nofPresets = 1;
+    store.active = 0;
+    storePage = PRESET_NOF_PAGES-1; /* first write goes to the first page */
+  }
+}
+
+void Preset_Deinit(void) {
+  /* mutex is kept */
+}
+
+void Preset_Init(void) {
+  storeMutex = xSemaphoreCreateMutex();
+  if (storeMutex==NULL) {
+    for(;;) {} /* out of memory? */
+  }
+  vQueueAddToRegistry(storeMutex, "PresetMutex");
+  nofWrites = 0;
+  selectedPending = false;
+  Preset_LoadStore();
+  Preset_ApplyCurve(store.active!=PRESET_NONE ? &store.presets[store.active] : &presetFlat);
+}
+
+#endif /* PL_CONFIG_USE_PRESET */
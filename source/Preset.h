@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PRESET_H_
+#define PRESET_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_PRESET
+#include <stdbool.h>
+#include <stdint.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#ifndef PRESET_CONFIG_MAX_PRESETS
+  #define PRESET_CONFIG_MAX_PRESETS   (16)
+#endif
+  /*!< number of presets in the store, all of them are written with each save */
+
+#define PRESET_NOF_BANDS      (5) /* bands of the EQ screen */
+#define PRESET_NAME_SIZE      (8) /* including the zero byte */
+#define PRESET_NONE           (0xff) /* no preset selected, or deleted */
+
+/* one EQ curve, fixed size record of the store */
+typedef struct {
+  char name[PRESET_NAME_SIZE]; /* zero terminated */
+  int8_t gainDb[PRESET_NOF_BANDS]; /* per band, low to high */
+  uint8_t enabled; /* EQ on */
+  uint8_t reserved[2];
+} Preset_Curve_t;
+
+/* current settings of the EQ, as restored at power-up and changed with the GUI */
+void Preset_GetLive(Preset_Curve_t *curve);
+void Preset_SetLiveGain(uint8_t band, int8_t gainDb);
+void Preset_SetLiveEnabled(bool enabled);
+
+/* makes a preset the last used one (stored in flash) and requests the GUI to switch to it */
+uint8_t Preset_Select(uint8_t index);
+
+/* called by the GUI: returns true and the curve if a preset has been selected since the last call */
+bool Preset_TakeSelected(Preset_Curve_t *curve);
+
+/* stores the live curve with a name, replaces a preset with the same name */
+uint8_t Preset_Save(const char *name);
+uint8_t Preset_Delete(const char *name);
+
+#if PL_CONFIG_USE_SHELL
+  uint8_t Preset_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
+
+void Preset_Deinit(void);
+/* loads the store from flash and applies the last used preset to the codec and the software EQ.
+ * Has to be called after CODEC_Init() and EqDsp_Init(), and before the GUI creates the EQ screen */
+void Preset_Init(void);
+
+#endif /* PL_CONFIG_USE_PRESET */
+
+#endif /* PRESET_H_ */
@@ -11,12 +11,31 @@
 #include "McuRTT.h"
 #include "McuArmTools.h"
 #include "McuILI9341.h"
+#if PL_CONFIG_USE_GUI
+  #include "lv.h"
+#endif
+#if PL_CONFIG_USE_BENCH
+  #include "bench.h"
+#endif
 #if PL_CONFIG_USE_I2C
   #include "McuI2CSpy.h"
 #endif
 #if PL_CONFIG_USE_FT6206
   #include "McuFT6206.h"
 #endif
+#include "McuSPI.h"
+#if PL_CONFIG_USE_TOUCH_TRACE
+  #include "TouchTrace.h"
+#endif
+#if PL_CONFIG_USE_CODEC
+  #include "codec.h"
+#endif
+#if PL_CONFIG_USE_SPECTRUM
+  #include "Spectrum.h"
+#endif
+#if PL_CONFIG_USE_PRESET
+  #include "Preset.h"
+#endif
 
 static const McuShell_ParseCommandCallback CmdParserTable[] =
 {
@@ -33,6 +52,27 @@ static const McuShell_ParseCommandCallback CmdParserTable[] =
 #endif
 #if MCUILI9341_CONFIG_PARSE_COMMAND_ENABLED
   McuILI9341_ParseCommand,
+#endif
+#if MCUSPI_CONFIG_PARSE_COMMAND_ENABLED
+  McuSPI_ParseCommand,
+#endif
+#if PL_CONFIG_USE_CODEC
+  CODEC_ParseCommand,
+#endif
+#if PL_CONFIG_USE_SPECTRUM
+  Spectrum_ParseCommand,
+#endif
+#if PL_CONFIG_USE_PRESET
+  Preset_ParseCommand,
+#endif
+#if PL_CONFIG_USE_GUI
+  LV_ParseCommand,
+#endif
+#if PL_CONFIG_USE_TOUCH_TRACE
+  TouchTrace_ParseCommand,
+#endif
+#if PL_CONFIG_USE_BENCH
+  BENCH_ParseCommand,
 #endif
   NULL /* Sentinel */
 };
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Spectrum analyser: a low priority task takes the last SPECTRUM_CONFIG_FFT_SIZE samples of the source every
+ * SPECTRUM_CONFIG_PERIOD_MS, applies a Hann window, transforms them with a real FFT and sums the power of the bins
+ * into log spaced bars. The bars are published with a sequence number, the view polls them in the GUI task.
+ * The real FFT is a complex FFT of half the size plus a split step, with the packed output of arm_rfft_fast_f32().
+ * The project has no I2S path yet which pushes the audio stream, so the generated sweep is the default source.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_SPECTRUM
+#include "Spectrum.h"
+#include "McuRTOS.h"
+#include <math.h>
+#include <string.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuUtility.h"
+#endif
+#if SPECTRUM_CONFIG_USE_CMSIS_DSP
+  #ifndef ARM_MATH_CM33
+    #define ARM_MATH_CM33 /* LPC55S69 */
+  #endif
+  #include "arm_math.h"
+#endif
+
+#define SPECTRUM_NOF_BINS       (SPECTRUM_CONFIG_FFT_SIZE/2)
+#define SPECTRUM_FULL_SCALE     (8388608.0f) /* 24bit samples */
+#define SPECTRUM_MIN_HZ         (50.0f) /* lower edge of the first bar */
+#define SPECTRUM_MAX_HZ         (16000.0f) /* upper edge of the last bar */
+#define SPECTRUM_TONE_AMPLITUDE (0.5f) /* -6 dBFS */
+#define SPECTRUM_SWEEP_FRAMES   (3000/SPECTRUM_CONFIG_PERIOD_MS) /* from the first to the last bar */
+#define SPECTRUM_2PI            (2.0f*3.14159265f)
+
+#if (SPECTRUM_CONFIG_FFT_SIZE&(SPECTRUM_CONFIG_FFT_SIZE-1))!=0
+  #error "FFT size has to be a power of two"
+#endif
+
+static float fftBuf[SPECTRUM_CONFIG_FFT_SIZE]; /* windowed samples, transformed in place */
+static float fftOut[SPECTRUM_CONFIG_FFT_SIZE]; /* DC, Nyquist, then real and imaginary part of bin 1..N/2-1 */
+static float window[SPECTRUM_CONFIG_FFT_SIZE/2]; /* first half of the Hann window, the second is symmetric */
+#if SPECTRUM_CONFIG_USE_CMSIS_DSP
+static arm_rfft_fast_instance_f32 rfft;
+#else
+static float twiddle[SPECTRUM_CONFIG_FFT_SIZE]; /* cos and sin of 2*pi*k/N for k<N/2, interleaved */
+#endif
+static uint16_t barFirstBin[SPECTRUM_NOF_BARS], barLastBin[SPECTRUM_NOF_BARS]; /* low bars can share a bin */
+static SemaphoreHandle_t analyseMutex; /* fftBuf[] and fftOut[] are used by the task and the benchmark */
+
+static struct { /* written by Spectrum_PushSamples() */
+  int32_t samples[SPECTRUM_CONFIG_FFT_SIZE]; /* mono, ring buffer */
+  volatile size_t idx; /* next to be written, the oldest sample */
+} ring;
+
+static struct {
+  TaskHandle_t task;
+  volatile bool running;
+  Spectrum_Source_e source;
+  uint32_t toneHz;
+  float sweepHz, sweepFactor;
+  int32_t frame[SPECTRUM_CONFIG_FFT_SIZE]; /* samples of the current analysis */
+  uint32_t nofFrames; /* number of analyses */
+} analyser;
+
+static struct {
+  uint8_t levels[SPECTRUM_NOF_BARS];
+  uint32_t seq; /* incremented with each analysis */
+} result;
+
+void Spectrum_PushSamples(const int32_t *frames, size_t nofFrames) {
+  size_t idx = ring.idx;
+
+  for(size_t i=0; i<nofFrames; i++) {
+    ring.samples[idx] = (frames[2*i]+frames[2*i+1])/2; /* left and right to mono, no overflow with 24bit samples */
+    idx = (idx+1)&(SPECTRUM_CONFIG_FFT_SIZE-1);
+  }
+  ring.idx = idx;
+}
+
+void Spectrum_GenerateTone(int32_t *samples, float hz, float amplitude) {
+  float w = SPECTRUM_2PI*hz/SPECTRUM_CONFIG_SAMPLE_RATE;
+
+  for(int i=0; i<SPECTRUM_CONFIG_FFT_SIZE; i++) {
+    samples[i] = (int32_t)(amplitude*SPECTRUM_FULL_SCALE*sinf(w*i));
+  }
+}
+
+#if !SPECTRUM_CONFIG_USE_CMSIS_DSP
+static void Spectrum_Cfft(float *buf, size_t n) {
+  /* in place radix-2 decimation in time FFT of n complex values (real and imaginary part interleaved) */
+  size_t i, j, bit, len, step, a, b, k;
+  float tmp, wr, wi, tr, ti;
+
+  for(i=1, j=0; i<n; i++) { /* bit reversed order */
+    for(bit=n>>1; j&bit; bit>>=1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i<j) {
+      tmp = buf[2*i]; buf[2*i] = buf[2*j]; buf[2*j] = tmp;
+      tmp = buf[2*i+1]; buf[2*i+1] = buf[2*j+1]; buf[2*j+1] = tmp;
+    }
+  }
+  for(len=2; len<=n; len<<=1) {
+    step = SPECTRUM_CONFIG_FFT_SIZE/len; /* e^(-2*pi*i*k/len) is twiddle index k*step */
+    for(i=0; i<n; i+=len) {
+      for(k=0; k<len/2; k++) {
+        wr = twiddle[2*k*step];
+        wi = -twiddle[2*k*step+1];
+        a = i+k;
+        b = a+len/2;
+        tr = wr*buf[2*b]-wi*buf[2*b+1];
+        ti = wr*buf[2*b+1]+wi*buf[2*b];
+        buf[2*b] = buf[2*a]-tr;
+        buf[2*b+1] = buf[2*a+1]-ti;
+        buf[2*a] += tr;
+        buf[2*a+1] += ti;
+      }
+    }
+  }
+}
+#endif
+
+static void Spectrum_Rfft(float *in, float *out) {
+#if SPECTRUM_CONFIG_USE_CMSIS_DSP
+  arm_rfft_fast_f32(&rfft, in, out, 0);
+#else
+  /* the even samples are the real, the odd ones the imaginary part of N/2 complex values Z */
+  const size_t m = SPECTRUM_NOF_BINS;
+  float er, ei, dr, di, wr, wi;
+
+  Spectrum_Cfft(in, m);
+  out[0] = in[0]+in[1]; /* DC */
+  out[1] = in[0]-in[1]; /* Nyquist */
+  for(size_t k=1; k<m; k++) {
+    /* even part E=(Z[k]+conj(Z[m-k]))/2, odd part O=-i*(Z[k]-conj(Z[m-k]))/2, X[k]=E+e^(-2*pi*i*k/N)*O */
+    er = 0.5f*(in[2*k]+in[2*(m-k)]);
+    ei = 0.5f*(in[2*k+1]-in[2*(m-k)+1]);
+    dr = 0.5f*(in[2*k+1]+in[2*(m-k)+1]); /* real part of O */
+    di = -0.5f*(in[2*k]-in[2*(m-k)]); /* imaginary part of O */
+    wr = twiddle[2*k];
+    wi = -twiddle[2*k+1];
+    out[2*k] = er+wr*dr-wi*di;
+    out[2*k+1] = ei+wr*di+wi*dr;
+  }
+#endif
+}
+
+void Spectrum_Analyse(const int32_t *samples, uint8_t levels[SPECTRUM_NOF_BARS]) {
+  /* power of a full scale sine in its bin: amplitude N/2, times 0.5 for the coherent gain of the Hann window */
+  const float fullScale = (SPECTRUM_CONFIG_FFT_SIZE/4.0f)*(SPECTRUM_CONFIG_FFT_SIZE/4.0f);
+  float power, re, im, db;
+  int32_t level;
+
+  (void)xSemaphoreTake(analyseMutex, portMAX_DELAY);
+  for(int i=0; i<SPECTRUM_CONFIG_FFT_SIZE/2; i++) {
+    fftBuf[i] = samples[i]*(window[i]/SPECTRUM_FULL_SCALE);
+    fftBuf[SPECTRUM_CONFIG_FFT_SIZE-1-i] = samples[SPECTRUM_CONFIG_FFT_SIZE-1-i]*(window[i]/SPECTRUM_FULL_SCALE);
+  }
+  Spectrum_Rfft(fftBuf, fftOut);
+  for(int b=0; b<SPECTRUM_NOF_BARS; b++) {
+    power = 0.0f;
+    for(int k=barFirstBin[b]; k<=barLastBin[b]; k++) {
+      re = fftOut[2*k];
+      im = fftOut[2*k+1];
+      power += re*re+im*im;
+    }
+    db = 10.0f*log10f(power/fullScale+1e-12f);
+    level = (int32_t)((db+SPECTRUM_CONFIG_RANGE_DB)*(SPECTRUM_LEVEL_MAX/(float)SPECTRUM_CONFIG_RANGE_DB));
+    if (level<0) {
+      level = 0;
+    } else if (level>SPECTRUM_LEVEL_MAX) {
+      level = SPECTRUM_LEVEL_MAX;
+    }
+    levels[b] = (uint8_t)level;
+  }
+  (void)xSemaphoreGive(analyseMutex);
+}
+
+bool Spectrum_GetBars(uint8_t levels[SPECTRUM_NOF_BARS], uint32_t *seq) {
+  bool isNew;
+
+  taskENTER_CRITICAL();
+  isNew = result.seq!=*seq;
+  if (isNew) {
+    memcpy(levels, result.levels, sizeof(result.levels));
+    *seq = result.seq;
+  }
+  taskEXIT_CRITICAL();
+  return isNew;
+}
+
+void Spectrum_SetSource(Spectrum_Source_e source, uint32_t toneHz) {
+  analyser.toneHz = toneHz;
+  analyser.sweepHz = SPECTRUM_MIN_HZ;
+  analyser.source = source;
+}
+
+void Spectrum_SetRunning(bool run) {
+  analyser.running = run;
+  if (run && analyser.task!=NULL) {
+    (void)xTaskNotifyGive(analyser.task);
+  }
+}
+
+static void Spectrum_GetFrame(int32_t *frame) {
+  size_t idx;
+
+  switch(analyser.source) {
+    case SPECTRUM_SOURCE_TONE:
+      Spectrum_GenerateTone(frame, (float)analyser.toneHz, SPECTRUM_TONE_AMPLITUDE);
+      break;
+    case SPECTRUM_SOURCE_SWEEP:
+      Spectrum_GenerateTone(frame, analyser.sweepHz, SPECTRUM_TONE_AMPLITUDE);
+      analyser.sweepHz *= analyser.sweepFactor;
+      if (analyser.sweepHz>SPECTRUM_MAX_HZ) {
+        analyser.sweepHz = SPECTRUM_MIN_HZ;
+      }
+      break;
+    case SPECTRUM_SOURCE_AUDIO:
+    default:
+      /* oldest first. Not locked: a block pushed while copying only mixes two adjacent frames on the display */
+      idx = ring.idx;
+      for(int i=0; i<SPECTRUM_CONFIG_FFT_SIZE; i++) {
+        frame[i] = ring.samples[(idx+i)&(SPECTRUM_CONFIG_FFT_SIZE-1)];
+      }
+      break;
+  }
+}
+
+static void SpectrumTask(void *pv) {
+  TickType_t lastWakeTime = xTaskGetTickCount();
+  uint8_t levels[SPECTRUM_NOF_BARS];
+
+  for(;;) {
+    if (!analyser.running) {
+      (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY); /* Spectrum_SetRunning() */
+      lastWakeTime = xTaskGetTickCount();
+      continue;
+    }
+    vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(SPECTRUM_CONFIG_PERIOD_MS));
+    Spectrum_GetFrame(analyser.frame);
+    Spectrum_Analyse(analyser.frame, levels);
+    analyser.nofFrames++;
+    taskENTER_CRITICAL();
+    memcpy(result.levels, levels, sizeof(result.levels));
+    result.seq++;
+    taskEXIT_CRITICAL();
+  }
+}
+
+#if PL_CONFIG_USE_SHELL
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[80];
+  uint8_t levels[SPECTRUM_NOF_BARS];
+  uint32_t seq = result.seq-1; /* always get a copy */
+
+  McuShell_SendStatusStr((unsigned char*)"spectrum", (unsigned char*)"\r\n", io->stdOut);
+  McuShell_SendStatusStr((unsigned char*)"  running", analyser.running?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+  switch(analyser.source) {
+    case SPECTRUM_SOURCE_TONE:
+      McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"tone ");
+      McuUtility_strcatNum32u(buf, sizeof(buf), analyser.toneHz);
+      McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" Hz\r\n");
+      break;
+    case SPECTRUM_SOURCE_SWEEP:
+      McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"sweep\r\n");
+      break;
+    case SPECTRUM_SOURCE_AUDIO:
+    default:
+      McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"audio\r\n");
+      break;
+  }
+  McuShell_SendStatusStr((unsigned char*)"  source", buf, io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), SPECTRUM_CONFIG_FFT_SIZE);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" points, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), analyser.nofFrames);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" frames\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  fft", buf, io->stdOut);
+  (void)Spectrum_GetBars(levels, &seq);
+  buf[0] = '\0';
+  for(int i=0; i<SPECTRUM_NOF_BARS; i++) {
+    McuUtility_strcatNum8u(buf, sizeof(buf), levels[i]);
+    McuUtility_chcat(buf, sizeof(buf), ' ');
+  }
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  bars", buf, io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"spectrum", (unsigned char*)"Group of spectrum analyser commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  source audio|sweep", (unsigned char*)"Analyse the audio stream or a generated sweep\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  source tone <hz>", (unsigned char*)"Analyse a generated sine\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+uint8_t Spectrum_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  const unsigned char *p;
+  uint32_t hz;
+
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "spectrum help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "spectrum status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strcmp((char*)cmd, "spectrum source audio")==0) {
+    *handled = TRUE;
+    Spectrum_SetSource(SPECTRUM_SOURCE_AUDIO, 0);
+    return ERR_OK;
+  } else if (McuUtility_strcmp((char*)cmd, "spectrum source sweep")==0) {
+    *handled = TRUE;
+    Spectrum_SetSource(SPECTRUM_SOURCE_SWEEP, 0);
+    return ERR_OK;
+  } else if (McuUtility_strncmp((char*)cmd, "spectrum source tone ", sizeof("spectrum source tone ")-1)==0) {
+    *handled = TRUE;
+    p = cmd+sizeof("spectrum source tone ")-1;
+    if (McuUtility_xatoi(&p, (int32_t*)&hz)!=ERR_OK || hz==0 || hz>=SPECTRUM_CONFIG_SAMPLE_RATE/2) {
+      McuShell_SendStr((unsigned char*)"wrong frequency\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    Spectrum_SetSource(SPECTRUM_SOURCE_TONE, hz);
+    return ERR_OK;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_SHELL */
+
+void Spectrum_Deinit(void) {
+  Spectrum_SetRunning(false); /* task and mutex are kept */
+}
+
+void Spectrum_Init(void) {
+  const float binHz = (float)SPECTRUM_CONFIG_SAMPLE_RATE/SPECTRUM_CONFIG_FFT_SIZE;
+  float ratio = powf(SPECTRUM_MAX_HZ/SPECTRUM_MIN_HZ, 1.0f/SPECTRUM_NOF_BARS);
+  float lo = SPECTRUM_MIN_HZ, hi;
+  int first, last;
+
+  for(int i=0; i<SPECTRUM_CONFIG_FFT_SIZE/2; i++) {
+    window[i] = 0.5f-0.5f*cosf(SPECTRUM_2PI*i/SPECTRUM_CONFIG_FFT_SIZE);
+#if !SPECTRUM_CONFIG_USE_CMSIS_DSP
+    twiddle[2*i] = cosf(SPECTRUM_2PI*i/SPECTRUM_CONFIG_FFT_SIZE);
+    twiddle[2*i+1] = sinf(SPECTRUM_2PI*i/SPECTRUM_CONFIG_FFT_SIZE);
+#endif
+  }
+#if SPECTRUM_CONFIG_USE_CMSIS_DSP
+  (void)arm_rfft_fast_init_f32(&rfft, SPECTRUM_CONFIG_FFT_SIZE);
+#endif
+  for(int b=0; b<SPECTRUM_NOF_BARS; b++) { /* bins from the lower to below the upper edge, at least one */
+    hi = lo*ratio;
+    first = (int)lroundf(lo/binHz);
+    last = (int)lroundf(hi/binHz)-1;
+    if (first<1) {
+      first = 1; /* skip DC */
+    }
+    if (last<first) {
+      last = first;
+    } else if (last>=SPECTRUM_NOF_BINS) {
+      last = SPECTRUM_NOF_BINS-1;
+    }
+    barFirstBin[b] = (uint16_t)first;
+    barLastBin[b] = (uint16_t)last;
+    lo = hi;
+  }
+  memset(&ring, 0, sizeof(ring));
+  memset(&result, 0, sizeof(result));
+  memset(&analyser, 0, sizeof(analyser));
+  analyser.sweepFactor = powf(SPECTRUM_MAX_HZ/SPECTRUM_MIN_HZ, 1.0f/SPECTRUM_SWEEP_FRAMES);
+  Spectrum_SetSource(SPECTRUM_SOURCE_SWEEP, 0);
+  analyseMutex = xSemaphoreCreateMutex();
+  if (analyseMutex==NULL) {
+    for(;;) {} /* out of memory? */
+  }
+  vQueueAddToRegistry(analyseMutex, "SpectrumMutex");
+  /* lowest priority: shares the CPU with the idle task, the GUI task always comes first */
+  if (xTaskCreate(SpectrumTask, "Spectrum", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY, &analyser.task) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_USE_SPECTRUM */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_SPECTRUM
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#ifndef SPECTRUM_CONFIG_USE_CMSIS_DSP
+  #define SPECTRUM_CONFIG_USE_CMSIS_DSP   (0)
+#endif
+  /*!< 1: transform with arm_rfft_fast_f32() of the CMSIS-DSP library, which has to be added to the linker settings.
+   *   0: transform with the radix-2 FFT of this module */
+
+#ifndef SPECTRUM_CONFIG_FFT_SIZE
+  #define SPECTRUM_CONFIG_FFT_SIZE        (1024)
+#endif
+  /*!< number of samples per analysis, power of two. 1024 at 48 kHz: 47 Hz per bin, 21 ms of audio */
+
+#ifndef SPECTRUM_CONFIG_SAMPLE_RATE
+  #define SPECTRUM_CONFIG_SAMPLE_RATE     (48000)
+#endif
+  /*!< audio sample rate in Hz */
+
+#ifndef SPECTRUM_CONFIG_PERIOD_MS
+  #define SPECTRUM_CONFIG_PERIOD_MS       (33)
+#endif
+  /*!< analysis period of the task, 30 frames per second */
+
+#ifndef SPECTRUM_CONFIG_RANGE_DB
+  #define SPECTRUM_CONFIG_RANGE_DB        (60)
+#endif
+  /*!< dynamic range of the bars: level 0 is this many dB below full scale */
+
+#define SPECTRUM_NOF_BARS        (16) /* log spaced bands from 50 Hz to 16 kHz */
+#define SPECTRUM_LEVEL_MAX       (255) /* level of a full scale sine */
+
+typedef enum {
+  SPECTRUM_SOURCE_AUDIO, /* samples from Spectrum_PushSamples() */
+  SPECTRUM_SOURCE_TONE,  /* generated sine, -6 dBFS */
+  SPECTRUM_SOURCE_SWEEP, /* generated sine sweeping over all bars in about 3 s */
+} Spectrum_Source_e;
+
+/* adds interleaved stereo frames (24bit right aligned) of the audio stream, to be called from the task serving the
+ * I2S DMA ping-pong buffer. The project has no I2S path yet, so nothing calls it */
+void Spectrum_PushSamples(const int32_t *frames, size_t nofFrames);
+
+/* selects where the analysis task gets the samples from, toneHz is used for SPECTRUM_SOURCE_TONE */
+void Spectrum_SetSource(Spectrum_Source_e source, uint32_t toneHz);
+
+/* the analysis task only runs while a view is shown */
+void Spectrum_SetRunning(bool run);
+
+/* copies the bar levels if a new analysis is available since *seq, and updates *seq */
+bool Spectrum_GetBars(uint8_t levels[SPECTRUM_NOF_BARS], uint32_t *seq);
+
+/* windows and transforms SPECTRUM_CONFIG_FFT_SIZE mono samples and maps the bins onto the bars. Used by the task
+ * and by the benchmark, serialized with a mutex */
+void Spectrum_Analyse(const int32_t *samples, uint8_t levels[SPECTRUM_NOF_BARS]);
+
+/* fills SPECTRUM_CONFIG_FFT_SIZE samples with a sine, amplitude relative to full scale */
+void Spectrum_GenerateTone(int32_t *samples, float hz, float amplitude);
+
+#if PL_CONFIG_USE_SHELL
+  uint8_t Spectrum_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
+
+void Spectrum_Deinit(void);
+void Spectrum_Init(void);
+
+#endif /* PL_CONFIG_USE_SPECTRUM */
+
+#endif /* SPECTRUM_H_ */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Spectrum screen: the bars are drawn as stacked segments by the design function of a plain object instead of an
+ * lv_chart, which invalidates the whole chart on each change. An update invalidates one area per bar, covering only
+ * the segments which changed (bar top and peak marker), so the SPI link to the panel only carries those.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_SPECTRUM && PL_CONFIG_USE_GUI
+#include "SpectrumView.h"
+#include "Spectrum.h"
+#include "gui.h"
+#include "LittlevGL/lvgl/lvgl.h"
+#include <string.h>
+
+#define SPECTRUMVIEW_HEADER_HEIGHT   (40) /* back button and title */
+#define SPECTRUMVIEW_SEG_HEIGHT      (4) /* pixels per bar segment, the top one is a gap */
+#define SPECTRUMVIEW_BAR_GAP         (3) /* pixels between two bars */
+
+static struct {
+  lv_obj_t *screen;
+  lv_obj_t *bars; /* object drawing all bars */
+  lv_task_t *refrTask;
+  lv_design_cb_t ancestorDesign;
+  uint8_t nofSegments; /* of a full bar */
+  uint8_t bar[SPECTRUM_NOF_BARS]; /* number of lit segments, as drawn */
+  uint8_t peak[SPECTRUM_NOF_BARS]; /* segment with the peak marker plus one, 0: none */
+  uint8_t peakHold[SPECTRUM_NOF_BARS]; /* updates until the peak starts to fall */
+  uint32_t seq; /* of the last bar levels */
+} view;
+
+static lv_style_t bgStyle, barStyle, peakStyle;
+
+static void GUI_Spectrum_GetSegmentsArea(int bar, int lo, int hi, lv_area_t *area) {
+  /* area of the segments lo..hi of a bar, segment 0 is at the bottom */
+  lv_area_t coords;
+  lv_coord_t pitch = lv_obj_get_width(view.bars)/SPECTRUM_NOF_BARS;
+
+  lv_obj_get_coords(view.bars, &coords);
+  area->x1 = coords.x1+bar*pitch+SPECTRUMVIEW_BAR_GAP/2;
+  area->x2 = area->x1+pitch-SPECTRUMVIEW_BAR_GAP-1;
+  area->y2 = coords.y2-lo*SPECTRUMVIEW_SEG_HEIGHT;
+  area->y1 = coords.y2-hi*SPECTRUMVIEW_SEG_HEIGHT-(SPECTRUMVIEW_SEG_HEIGHT-2);
+}
+
+static bool GUI_Spectrum_Design(lv_obj_t *obj, const lv_area_t *mask, lv_design_mode_t mode) {
+  lv_area_t coords, area;
+  const lv_style_t *style;
+  lv_opa_t opa;
+  int lo, hi;
+
+  if (mode!=LV_DESIGN_DRAW_MAIN) {
+    return view.ancestorDesign(obj, mask, mode);
+  }
+  (void)view.ancestorDesign(obj, mask, mode); /* background */
+  lv_obj_get_coords(obj, &coords);
+  /* only the segment rows inside the mask */
+  lo = (coords.y2-mask->y2)/SPECTRUMVIEW_SEG_HEIGHT;
+  hi = (coords.y2-mask->y1)/SPECTRUMVIEW_SEG_HEIGHT;
+  if (lo<0) {
+    lo = 0;
+  }
+  if (hi>=view.nofSegments) {
+    hi = view.nofSegments-1;
+  }
+  opa = lv_obj_get_opa_scale(obj);
+  for(int b=0; b<SPECTRUM_NOF_BARS; b++) {
+    GUI_Spectrum_GetSegmentsArea(b, 0, 0, &area);
+    if (area.x2<mask->x1 || area.x1>mask->x2) {
+      continue;
+    }
+    for(int s=lo; s<=hi; s++) {
+      if (s+1==view.peak[b]) {
+        style = &peakStyle;
+      } else if (s<view.bar[b]) {
+        style = &barStyle;
+      } else {
+        continue;
+      }
+      GUI_Spectrum_GetSegmentsArea(b, s, s, &area);
+      lv_draw_rect(&area, mask, style, opa);
+    }
+  }
+  return true;
+}
+
+static void GUI_Spectrum_SetBar(int b, uint8_t bar, uint8_t peak) {
+  /* one area per bar for all changed segments, so an update needs at most SPECTRUM_NOF_BARS of the LV_INV_BUF_SIZE
+   * areas. More would make LVGL invalidate the whole screen */
+  int lo = view.nofSegments, hi = -1;
+  lv_area_t area;
+
+  if (bar!=view.bar[b]) {
+    lo = bar<view.bar[b] ? bar : view.bar[b];
+    hi = (bar>view.bar[b] ? bar : view.bar[b])-1;
+  }
+  if (peak!=view.peak[b]) {
+    if (view.peak[b]>0) {
+      lo = view.peak[b]-1<lo ? view.peak[b]-1 : lo;
+      hi = view.peak[b]-1>hi ? view.peak[b]-1 : hi;
+    }
+    if (peak>0) {
+      lo = peak-1<lo ? peak-1 : lo;
+      hi = peak-1>hi ? peak-1 : hi;
+    }
+  }
+  view.bar[b] = bar;
+  view.peak[b] = peak;
+  if (hi>=lo) {
+    GUI_Spectrum_GetSegmentsArea(b, lo, hi, &area);
+    lv_inv_area(lv_obj_get_disp(view.bars), &area);
+  }
+}
+
+static void GUI_Spectrum_Refresh(lv_task_t *task) {
+  uint8_t levels[SPECTRUM_NOF_BARS];
+  uint8_t bar, peak;
+
+  if (!Spectrum_GetBars(levels, &view.seq)) {
+    return; /* no new analysis */
+  }
+  for(int b=0; b<SPECTRUM_NOF_BARS; b++) {
+    bar = (uint8_t)((levels[b]*view.nofSegments)/SPECTRUM_LEVEL_MAX);
+    peak = view.peak[b];
+    if (bar>=peak) {
+      peak = bar;
+      view.peakHold[b] = SPECTRUMVIEW_CONFIG_PEAK_HOLD;
+    } else if (view.peakHold[b]>0) {
+      view.peakHold[b]--;
+    } else {
+      peak--;
+    }
+    GUI_Spectrum_SetBar(b, bar, peak);
+  }
+}
+
+static void GUI_Spectrum_BackEvent(lv_obj_t *obj, lv_event_t event) {
+  if (event==LV_EVENT_RELEASED) {
+    GUI_Spectrum_Close();
+  }
+}
+
+void GUI_Spectrum_Close(void) {
+  Spectrum_SetRunning(false);
+  if (view.refrTask!=NULL) {
+    lv_task_del(view.refrTask);
+    view.refrTask = NULL;
+  }
+  if (view.screen!=NULL) {
+    GUI_SwitchToMainScreen();
+    lv_obj_del(view.screen);
+    view.screen = NULL;
+    view.bars = NULL;
+  }
+}
+
+void GUI_Spectrum_Create(void) {
+  lv_obj_t *btn, *label;
+
+  if (view.screen!=NULL) {
+    return; /* already open */
+  }
+  lv_style_copy(&bgStyle, &lv_style_plain);
+  bgStyle.body.main_color = LV_COLOR_BLACK;
+  bgStyle.body.grad_color = LV_COLOR_BLACK;
+  lv_style_copy(&barStyle, &bgStyle);
+  barStyle.body.main_color = LV_COLOR_LIME;
+  barStyle.body.grad_color = LV_COLOR_LIME;
+  lv_style_copy(&peakStyle, &bgStyle);
+  peakStyle.body.main_color = LV_COLOR_RED;
+  peakStyle.body.grad_color = LV_COLOR_RED;
+
+  view.screen = lv_obj_create(NULL, NULL);
+  lv_scr_load(view.screen);
+
+  btn = lv_btn_create(view.screen, NULL);
+  lv_obj_set_size(btn, 50, SPECTRUMVIEW_HEADER_HEIGHT-10);
+  lv_obj_align(btn, NULL, LV_ALIGN_IN_TOP_LEFT, 5, 5);
+  lv_obj_set_event_cb(btn, GUI_Spectrum_BackEvent);
+  label = lv_label_create(btn, NULL);
+  lv_label_set_text(label, LV_SYMBOL_LEFT);
+
+  label = lv_label_create(view.screen, NULL);
+  lv_label_set_text(label, "Spectrum");
+  lv_obj_align(label, NULL, LV_ALIGN_IN_TOP_MID, 0, 12);
+
+  view.bars = lv_obj_create(view.screen, NULL);
+  lv_obj_set_style(view.bars, &bgStyle);
+  lv_obj_set_click(view.bars, false);
+  lv_obj_set_pos(view.bars, 0, SPECTRUMVIEW_HEADER_HEIGHT);
+  lv_obj_set_size(view.bars, LV_HOR_RES, LV_VER_RES-SPECTRUMVIEW_HEADER_HEIGHT);
+  view.ancestorDesign = lv_obj_get_design_cb(view.bars);
+  lv_obj_set_design_cb(view.bars, GUI_Spectrum_Design);
+  view.nofSegments = (LV_VER_RES-SPECTRUMVIEW_HEADER_HEIGHT)/SPECTRUMVIEW_SEG_HEIGHT;
+  memset(view.bar, 0, sizeof(view.bar));
+  memset(view.peak, 0, sizeof(view.peak));
+  memset(view.peakHold, 0, sizeof(view.peakHold));
+
+  view.refrTask = lv_task_create(GUI_Spectrum_Refresh, SPECTRUMVIEW_CONFIG_REFRESH_MS, LV_TASK_PRIO_MID, NULL);
+  Spectrum_SetRunning(true);
+}
+
+#endif /* PL_CONFIG_USE_SPECTRUM && PL_CONFIG_USE_GUI */
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SPECTRUMVIEW_H_
+#define SPECTRUMVIEW_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_SPECTRUM && PL_CONFIG_USE_GUI
+
+#ifndef SPECTRUMVIEW_CONFIG_REFRESH_MS
+  #define SPECTRUMVIEW_CONFIG_REFRESH_MS     (33)
+#endif
+  /*!< period of the bar update, 30 frames per second */
+
+#ifndef SPECTRUMVIEW_CONFIG_PEAK_HOLD
+  #define SPECTRUMVIEW_CONFIG_PEAK_HOLD      (30)
+#endif
+  /*!< number of updates a peak marker is held, then it falls one segment per update */
+
+/* creates the spectrum screen, loads it and starts the analysis */
+void GUI_Spectrum_Create(void);
+
+/* stops the analysis, deletes the screen and returns to the main screen */
+void GUI_Spectrum_Close(void);
+
+#endif /* PL_CONFIG_USE_SPECTRUM && PL_CONFIG_USE_GUI */
+
+#endif /* SPECTRUMVIEW_H_ */
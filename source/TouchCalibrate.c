@@ -11,18 +11,47 @@
 #include "gui.h"
 #include "McuUtility.h"
 #include "toaster.h"
+#include "Shell.h"
+#include <string.h>
+#if PL_CONFIG_USE_NVM
+  #include "nvm.h"
+#endif
+
+/* The raw controller coordinates are mapped with an affine transformation in Q16:
+ *   x = (a*xr + b*yr + c)>>16
+ *   y = (d*xr + e*yr + f)>>16
+ * It covers scaling, offset, rotation and skew of the touch panel versus the display, and the display orientation.
+ */
+#define TOUCHCALIB_Q            (16)
+#define TOUCHCALIB_NATIVE_W     (LV_HOR_RES_MAX) /* display size in the native (portrait) orientation */
+#define TOUCHCALIB_NATIVE_H     (LV_VER_RES_MAX)
+#define TOUCHCALIB_MARKER_INSET (20+20/2) /* center of the tpcal markers: CIRCLE_OFFSET+CIRCLE_SIZE/2 */
+
+typedef struct {
+  int32_t a, b, c, d, e, f;
+} TouchCalib_Matrix_t;
+
+/* data stored in NVM */
+typedef struct {
+  TouchCalib_Matrix_t native; /* raw to display coordinates in the native orientation */
+  lv_point_t point[4]; /* raw coordinates of the markers, for reference */
+} TouchCalib_Data_t;
 
 static lv_obj_t *win;
 static struct {
   bool isCalibrated;
-  lv_point_t point[4];
+  TouchCalib_Orientation_e orientation;
+  TouchCalib_Matrix_t active; /* native matrix with the orientation folded in */
+  lv_coord_t width, height; /* display size in the current orientation */
+  TouchCalib_Data_t data;
 } cal_data =
   {
-    .isCalibrated = true,
-    .point[0] = {.x=705,  .y=549},
-    .point[1] = {.x=3394, .y=527},
-    .point[2] = {.x=3395, .y=3466},
-    .point[3] = {.x=1587, .y=3433},
+    .isCalibrated = false,
+    .orientation = TOUCHCALIB_CONFIG_ORIENTATION,
+    .data.point[0] = {.x=705,  .y=549}, /* defaults used if nothing has been stored in NVM */
+    .data.point[1] = {.x=3394, .y=527},
+    .data.point[2] = {.x=3395, .y=3466},
+    .data.point[3] = {.x=1587, .y=3433},
   };
 
 /**
@@ -69,67 +98,176 @@ void TouchCalib_SetCalibrated(bool isCalibrated) {
   cal_data.isCalibrated = isCalibrated;
 }
 
+/* maps a point from the given orientation back to the native orientation */
+static void TouchCalib_ToNative(TouchCalib_Orientation_e orientation, int32_t xo, int32_t yo, int32_t *xn, int32_t *yn) {
+  switch(orientation) {
+    case TOUCHCALIB_ORIENTATION_PORTRAIT180:
+      *xn = TOUCHCALIB_NATIVE_W-1-xo;
+      *yn = TOUCHCALIB_NATIVE_H-1-yo;
+      break;
+    case TOUCHCALIB_ORIENTATION_LANDSCAPE:
+      *xn = TOUCHCALIB_NATIVE_W-1-yo;
+      *yn = xo;
+      break;
+    case TOUCHCALIB_ORIENTATION_LANDSCAPE180:
+      *xn = yo;
+      *yn = TOUCHCALIB_NATIVE_H-1-xo;
+      break;
+    case TOUCHCALIB_ORIENTATION_PORTRAIT:
+    default:
+      *xn = xo;
+      *yn = yo;
+      break;
+  }
+}
+
+/* builds the active matrix: the rotation from native to display coordinates is applied to the native matrix */
+static void TouchCalib_UpdateActive(void) {
+  const TouchCalib_Matrix_t *n = &cal_data.data.native;
+  TouchCalib_Matrix_t *m = &cal_data.active;
+
+  switch(cal_data.orientation) {
+    case TOUCHCALIB_ORIENTATION_PORTRAIT180: /* x = W-1-xn, y = H-1-yn */
+      m->a = -n->a; m->b = -n->b; m->c = ((TOUCHCALIB_NATIVE_W-1)<<TOUCHCALIB_Q)-n->c;
+      m->d = -n->d; m->e = -n->e; m->f = ((TOUCHCALIB_NATIVE_H-1)<<TOUCHCALIB_Q)-n->f;
+      cal_data.width = TOUCHCALIB_NATIVE_W;
+      cal_data.height = TOUCHCALIB_NATIVE_H;
+      break;
+    case TOUCHCALIB_ORIENTATION_LANDSCAPE: /* x = yn, y = W-1-xn */
+      m->a = n->d; m->b = n->e; m->c = n->f;
+      m->d = -n->a; m->e = -n->b; m->f = ((TOUCHCALIB_NATIVE_W-1)<<TOUCHCALIB_Q)-n->c;
+      cal_data.width = TOUCHCALIB_NATIVE_H;
+      cal_data.height = TOUCHCALIB_NATIVE_W;
+      break;
+    case TOUCHCALIB_ORIENTATION_LANDSCAPE180: /* x = H-1-yn, y = xn */
+      m->a = -n->d; m->b = -n->e; m->c = ((TOUCHCALIB_NATIVE_H-1)<<TOUCHCALIB_Q)-n->f;
+      m->d = n->a; m->e = n->b; m->f = n->c;
+      cal_data.width = TOUCHCALIB_NATIVE_H;
+      cal_data.height = TOUCHCALIB_NATIVE_W;
+      break;
+    case TOUCHCALIB_ORIENTATION_PORTRAIT:
+    default:
+      *m = *n;
+      cal_data.width = TOUCHCALIB_NATIVE_W;
+      cal_data.height = TOUCHCALIB_NATIVE_H;
+      break;
+  }
+}
+
+/* Least squares fit of the affine matrix for the four raw points to the four display points, done once.
+ * Single precision, as the FPU of the M33: with the centered sums the matrix is off by a few 1/65536 pixel at most.
+ * Returns false if the points do not span an area (e.g. the same corner touched twice). */
+static bool TouchCalib_Fit(const lv_point_t raw[4], const int32_t xd[4], const int32_t yd[4], TouchCalib_Matrix_t *m) {
+  float mx = 0, my = 0, mX = 0, mY = 0;
+  float sxx = 0, sxy = 0, syy = 0, sxX = 0, syX = 0, sxY = 0, syY = 0;
+  float det, a, b, d, e;
+
+  for(int i=0; i<4; i++) {
+    mx += raw[i].x; my += raw[i].y; mX += xd[i]; mY += yd[i];
+  }
+  mx /= 4.0f; my /= 4.0f; mX /= 4.0f; mY /= 4.0f;
+  for(int i=0; i<4; i++) { /* centered sums, avoids the loss of precision with the 0..4095 raw values */
+    float dx = raw[i].x-mx, dy = raw[i].y-my, dX = xd[i]-mX, dY = yd[i]-mY;
+
+    sxx += dx*dx; sxy += dx*dy; syy += dy*dy;
+    sxX += dx*dX; syX += dy*dX; sxY += dx*dY; syY += dy*dY;
+  }
+  det = sxx*syy-sxy*sxy;
+  if (det<1.0f) {
+    return false;
+  }
+  a = (sxX*syy-syX*sxy)/det;
+  b = (syX*sxx-sxX*sxy)/det;
+  d = (sxY*syy-syY*sxy)/det;
+  e = (syY*sxx-sxY*sxy)/det;
+  m->a = (int32_t)(a*(1<<TOUCHCALIB_Q));
+  m->b = (int32_t)(b*(1<<TOUCHCALIB_Q));
+  m->c = (int32_t)((mX-a*mx-b*my)*(1<<TOUCHCALIB_Q));
+  m->d = (int32_t)(d*(1<<TOUCHCALIB_Q));
+  m->e = (int32_t)(e*(1<<TOUCHCALIB_Q));
+  m->f = (int32_t)((mY-d*mx-e*my)*(1<<TOUCHCALIB_Q));
+  return true;
+}
+
+/* computes the native matrix from the raw marker coordinates, touched in the current orientation */
+static bool TouchCalib_Compute(const lv_point_t points[4]) {
+  int32_t xd[4], yd[4];
+  int32_t w = cal_data.width, h = cal_data.height;
+  TouchCalib_Matrix_t native;
+
+  /* marker centers in tpcal order: top-left, top-right, bottom-right, bottom-left */
+  TouchCalib_ToNative(cal_data.orientation, TOUCHCALIB_MARKER_INSET, TOUCHCALIB_MARKER_INSET, &xd[0], &yd[0]);
+  TouchCalib_ToNative(cal_data.orientation, w-TOUCHCALIB_MARKER_INSET, TOUCHCALIB_MARKER_INSET, &xd[1], &yd[1]);
+  TouchCalib_ToNative(cal_data.orientation, w-TOUCHCALIB_MARKER_INSET, h-TOUCHCALIB_MARKER_INSET, &xd[2], &yd[2]);
+  TouchCalib_ToNative(cal_data.orientation, TOUCHCALIB_MARKER_INSET, h-TOUCHCALIB_MARKER_INSET, &xd[3], &yd[3]);
+  if (!TouchCalib_Fit(points, xd, yd, &native)) {
+    return false;
+  }
+  cal_data.data.native = native;
+  memcpy(cal_data.data.point, points, sizeof(cal_data.data.point));
+  TouchCalib_UpdateActive();
+  return true;
+}
+
 void TouchCalib_set_cal_data(lv_point_t points[4]) {
-  memcpy(cal_data.point, points, sizeof(cal_data.point)); /* store data */
-  cal_data.isCalibrated = true;
+  if (!TouchCalib_Compute(points)) {
+    SHELL_SendString((unsigned char*)"touch calibration points are not valid, keeping the previous calibration\r\n");
+  }
+#if PL_CONFIG_USE_NVM
+  else if (NVM_WriteBlock(NVM_BLOCK_TOUCH_CALIB, &cal_data.data, sizeof(cal_data.data))!=ERR_OK) {
+    SHELL_SendString((unsigned char*)"failed storing touch calibration\r\n");
+  }
+#endif
+  cal_data.isCalibrated = true; /* the previous calibration stays valid if the new one failed */
 }
 
-static int32_t int_ext(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x)  {
-  return y2 - (x2-x) / ((x2 - x1) / (y2 - y1));
+void TouchCalib_SetOrientation(TouchCalib_Orientation_e orientation) {
+  cal_data.orientation = orientation;
+  TouchCalib_UpdateActive();
+}
+
+TouchCalib_Orientation_e TouchCalib_GetOrientation(void) {
+  return cal_data.orientation;
 }
 
 void TouchCalib_Calibrate(uint16_t *x, uint16_t *y) {
   if (cal_data.isCalibrated) {
-    /* see https://github.com/littlevgl/esp32_ili9341/issues/12 */
-    #define LCD_HOR_RES     240
-    #define LCD_VER_RES     320
-    #define CIRCLE_SIZE      20
-    #define CIRCLE_OFFSET    20
-
-    int xval, yval;
+    const TouchCalib_Matrix_t *m = &cal_data.active;
+    int32_t xr = *x, yr = *y;
+    int32_t xval, yval;
 
-    xval = int_ext(cal_data.point[0].x, CIRCLE_OFFSET + CIRCLE_SIZE/2, cal_data.point[1].x, LCD_HOR_RES - CIRCLE_OFFSET + CIRCLE_SIZE/2, *x);
-    yval = int_ext(cal_data.point[1].y, CIRCLE_OFFSET + CIRCLE_SIZE/2, cal_data.point[2].y, LCD_VER_RES - CIRCLE_OFFSET + CIRCLE_SIZE/2, *y);
+    xval = (m->a*xr + m->b*yr + m->c + (1<<(TOUCHCALIB_Q-1)))>>TOUCHCALIB_Q;
+    yval = (m->d*xr + m->e*yr + m->f + (1<<(TOUCHCALIB_Q-1)))>>TOUCHCALIB_Q;
     if (xval<0) {
       xval = 0;
-    }
-    if (xval>LCD_HOR_RES-1) {
-      xval = LCD_HOR_RES-1;
+    } else if (xval>cal_data.width-1) {
+      xval = cal_data.width-1;
     }
     if (yval<0) {
       yval = 0;
-    }
-    if (yval>LCD_VER_RES-1) {
-      yval = LCD_VER_RES-1;
+    } else if (yval>cal_data.height-1) {
+      yval = cal_data.height-1;
     }
     *x = xval;
     *y = yval;
-  } else {
-#if 0
-    int ix, iy;
-
-    /* the STMPE610 delivers x and y in the range of 0...4096, and z is the pressure (the harder the press, the lower the number */
-    #define TS_MINX 300
-    #define TS_MAXX 3800
-    #define TS_MINY 210
-    #define TS_MAXY 3700
-
-    ix = *x;
-    iy = *y;
-    ix = McuUtility_map(ix, TS_MINX, TS_MAXX, 0, LCD_HOR_RES);
-    iy = McuUtility_map(iy, TS_MINY, TS_MAXY, 0, LCD_VER_RES);
-    if (ix < 0) {
-      ix = 0;
-    } else if (ix > LCD_WIDTH-1) {
-      ix = LCD_WIDTH-1;
-    }
-    if (iy < 0) {
-      iy = 0;
-    } else if (iy > LCD_HEIGHT-1) {
-      iy = LCD_HEIGHT-1;
-    }
-    *x = ix;
-    *y = iy;
-#endif
   }
 }
+
+void TouchCalib_Deinit(void) {
+}
+
+void TouchCalib_Init(void) {
+  TouchCalib_UpdateActive(); /* display size for the orientation */
+#if PL_CONFIG_USE_NVM
+  TouchCalib_Data_t data;
+
+  if (NVM_ReadBlock(NVM_BLOCK_TOUCH_CALIB, &data, sizeof(data))==ERR_OK) {
+    cal_data.data = data;
+    TouchCalib_UpdateActive();
+    cal_data.isCalibrated = true;
+    return;
+  }
+#endif
+  /* nothing stored: use the default points, so the GUI does not need to start with the calibration screen */
+  cal_data.isCalibrated = TouchCalib_Compute(cal_data.data.point);
+}
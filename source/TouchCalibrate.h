@@ -9,13 +9,37 @@
 #define TOUCHCALIBRATE_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  TOUCHCALIB_ORIENTATION_PORTRAIT,     /* native orientation of the panel */
+  TOUCHCALIB_ORIENTATION_PORTRAIT180,
+  TOUCHCALIB_ORIENTATION_LANDSCAPE,
+  TOUCHCALIB_ORIENTATION_LANDSCAPE180,
+} TouchCalib_Orientation_e;
+
+#ifndef TOUCHCALIB_CONFIG_ORIENTATION
+  #define TOUCHCALIB_CONFIG_ORIENTATION   TOUCHCALIB_ORIENTATION_PORTRAIT
+#endif
+  /*!< display orientation at startup, can be changed with TouchCalib_SetOrientation() */
 
 void TouchCalib_CreateView(void);
 
 #include "LittlevGL/lvgl/lvgl.h"
+/* Called by tpcal with the raw coordinates of the four markers: computes the affine calibration and stores it in NVM */
 void TouchCalib_set_cal_data(lv_point_t points[4]);
+
+/* maps raw controller coordinates to display coordinates of the current orientation */
 void TouchCalib_Calibrate(uint16_t *x, uint16_t *y);
 bool TouchCalib_IsCalibrated(void);
 void TouchCalib_SetCalibrated(bool isCalibrated);
 
+/* folds the display orientation into the calibration, no extra cost per sample */
+void TouchCalib_SetOrientation(TouchCalib_Orientation_e orientation);
+TouchCalib_Orientation_e TouchCalib_GetOrientation(void);
+
+void TouchCalib_Deinit(void);
+/* loads the calibration from NVM, or uses the built-in default points if none has been stored */
+void TouchCalib_Init(void);
+
 #endif /* TOUCHCALIBRATE_H_ */
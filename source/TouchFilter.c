@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Integer only filter for the resistive touch samples: pressure gating, median of N and an IIR low pass with a dead zone.
+ * The IIR smoothing factor grows with the distance to the last output: jitter gets removed, while fast movements
+ * are followed with little lag.
+ */
+#include "TouchFilter.h"
+
+#define TOUCHFILTER_Q   (4) /* fractional bits of the filter output */
+
+#if TOUCHFILTER_CONFIG_MEDIAN_N>1
+static uint16_t TouchFilter_Median(const uint16_t *window) {
+  uint16_t sorted[TOUCHFILTER_CONFIG_MEDIAN_N];
+
+  /* insertion sort, at most N*(N-1)/2 moves */
+  for(int i=0; i<TOUCHFILTER_CONFIG_MEDIAN_N; i++) {
+    uint16_t v = window[i];
+    int j = i;
+
+    while(j>0 && sorted[j-1]>v) {
+      sorted[j] = sorted[j-1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  return sorted[TOUCHFILTER_CONFIG_MEDIAN_N/2];
+}
+#endif
+
+static int32_t TouchFilter_Abs(int32_t val) {
+  return val<0 ? -val : val;
+}
+
+void TouchFilter_Reset(TouchFilter_t *filter) {
+  filter->valid = false;
+#if TOUCHFILTER_CONFIG_MEDIAN_N>1
+  filter->idx = 0;
+#endif
+}
+
+bool TouchFilter_Process(TouchFilter_t *filter, const TouchFilter_Sample_t *sample, uint16_t *x, uint16_t *y) {
+  int32_t mx, my; /* median filtered sample in Q4 */
+
+#if TOUCHFILTER_CONFIG_Z_MAX>0
+  if (sample->z>TOUCHFILTER_CONFIG_Z_MAX) { /* pressed too lightly: position is not reliable */
+    if (filter->valid) {
+      *x = (uint16_t)((filter->xq+(1<<(TOUCHFILTER_Q-1)))>>TOUCHFILTER_Q);
+      *y = (uint16_t)((filter->yq+(1<<(TOUCHFILTER_Q-1)))>>TOUCHFILTER_Q);
+    }
+    return filter->valid;
+  }
+#endif
+#if TOUCHFILTER_CONFIG_MEDIAN_N>1
+  if (!filter->valid) { /* first sample after pen down: fill the window, no wait for N samples */
+    for(int i=0; i<TOUCHFILTER_CONFIG_MEDIAN_N; i++) {
+      filter->x[i] = sample->x;
+      filter->y[i] = sample->y;
+    }
+  } else {
+    filter->x[filter->idx] = sample->x;
+    filter->y[filter->idx] = sample->y;
+  }
+  filter->idx++;
+  if (filter->idx==TOUCHFILTER_CONFIG_MEDIAN_N) {
+    filter->idx = 0;
+  }
+  mx = (int32_t)TouchFilter_Median(filter->x)<<TOUCHFILTER_Q;
+  my = (int32_t)TouchFilter_Median(filter->y)<<TOUCHFILTER_Q;
+#else
+  mx = (int32_t)sample->x<<TOUCHFILTER_Q;
+  my = (int32_t)sample->y<<TOUCHFILTER_Q;
+#endif
+  if (!filter->valid) { /* start at the first position */
+    filter->xq = mx;
+    filter->yq = my;
+    filter->valid = true;
+  } else {
+    int32_t dx = mx-filter->xq;
+    int32_t dy = my-filter->yq;
+    int32_t dist = TouchFilter_Abs(dx)>TouchFilter_Abs(dy) ? TouchFilter_Abs(dx) : TouchFilter_Abs(dy);
+
+    dist >>= TOUCHFILTER_Q; /* full pixels */
+    if (dist>TOUCHFILTER_CONFIG_DEAD_ZONE) {
+      int32_t alpha = TOUCHFILTER_CONFIG_ALPHA_MIN+(dist-TOUCHFILTER_CONFIG_DEAD_ZONE-1)*TOUCHFILTER_CONFIG_ALPHA_GAIN; /* Q8 */
+
+      if (alpha>256) {
+        alpha = 256;
+      }
+      filter->xq += (dx*alpha)/256;
+      filter->yq += (dy*alpha)/256;
+    }
+  }
+  *x = (uint16_t)((filter->xq+(1<<(TOUCHFILTER_Q-1)))>>TOUCHFILTER_Q);
+  *y = (uint16_t)((filter->yq+(1<<(TOUCHFILTER_Q-1)))>>TOUCHFILTER_Q);
+  return true;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TOUCHFILTER_H_
+#define TOUCHFILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TOUCHFILTER_CONFIG_MEDIAN_N
+  #define TOUCHFILTER_CONFIG_MEDIAN_N      (3)
+#endif
+  /*!< number of samples for the median filter, odd and up to 7. 1: no median filter */
+
+#ifndef TOUCHFILTER_CONFIG_Z_MAX
+  #define TOUCHFILTER_CONFIG_Z_MAX         (0)
+#endif
+  /*!< samples with a pressure value above this are dropped (a higher z is a lighter press, see McuSTMPE610_TouchPoint). 0: no pressure gating */
+
+#ifndef TOUCHFILTER_CONFIG_DEAD_ZONE
+  #define TOUCHFILTER_CONFIG_DEAD_ZONE     (2)
+#endif
+  /*!< movements up to this many pixels are ignored. 0: no dead zone */
+
+#ifndef TOUCHFILTER_CONFIG_ALPHA_MIN
+  #define TOUCHFILTER_CONFIG_ALPHA_MIN     (64)
+#endif
+  /*!< smoothing factor (Q8, 256 is 1.0) for movements just outside of the dead zone */
+
+#ifndef TOUCHFILTER_CONFIG_ALPHA_GAIN
+  #define TOUCHFILTER_CONFIG_ALPHA_GAIN    (32)
+#endif
+  /*!< smoothing factor increment (Q8) per pixel of movement outside the dead zone, fast movements are followed without lag. 0: fixed IIR */
+
+#if TOUCHFILTER_CONFIG_MEDIAN_N<1 || TOUCHFILTER_CONFIG_MEDIAN_N>7 || (TOUCHFILTER_CONFIG_MEDIAN_N%2)==0
+  #error "TOUCHFILTER_CONFIG_MEDIAN_N has to be 1, 3, 5 or 7"
+#endif
+
+typedef struct {
+  uint16_t x, y; /* calibrated display coordinates */
+  uint8_t z; /* pressure: the harder the press, the lower the number */
+} TouchFilter_Sample_t;
+
+typedef struct {
+#if TOUCHFILTER_CONFIG_MEDIAN_N>1
+  uint16_t x[TOUCHFILTER_CONFIG_MEDIAN_N], y[TOUCHFILTER_CONFIG_MEDIAN_N]; /* median window */
+  uint8_t idx; /* next write position in the median window */
+#endif
+  int32_t xq, yq; /* filter output in Q4 */
+  bool valid; /* a sample has been accepted since the last reset */
+} TouchFilter_t;
+
+/* to be called for each pen down */
+void TouchFilter_Reset(TouchFilter_t *filter);
+
+/* Runs one sample through pressure gating, median and IIR. The work per sample is bounded by TOUCHFILTER_CONFIG_MEDIAN_N.
+ * Returns true with the filtered position in x/y, false if no sample has been accepted since the pen went down. */
+bool TouchFilter_Process(TouchFilter_t *filter, const TouchFilter_Sample_t *sample, uint16_t *x, uint16_t *y);
+
+#endif /* TOUCHFILTER_H_ */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Small gesture recogniser for a two point touch controller:
+ * - swipe: one finger moved fast along one axis, reported when the finger is lifted
+ * - two finger drag: two fingers moved vertically, reported in steps while moving
+ */
+#include "TouchGesture.h"
+
+static int16_t TouchGesture_Abs(int16_t val) {
+  return val<0 ? -val : val;
+}
+
+void TouchGesture_Reset(TouchGesture_t *gesture) {
+  gesture->state = TOUCHGESTURE_STATE_IDLE;
+}
+
+bool TouchGesture_IsMultiTouch(const TouchGesture_t *gesture) {
+  return gesture->state==TOUCHGESTURE_STATE_DOUBLE;
+}
+
+static bool TouchGesture_CheckSwipe(const TouchGesture_t *gesture, uint32_t timeMs, TouchGesture_Event_t *event) {
+  int16_t dx = gesture->lastX-gesture->startX;
+  int16_t dy = gesture->lastY-gesture->startY;
+  int16_t adx = TouchGesture_Abs(dx);
+  int16_t ady = TouchGesture_Abs(dy);
+
+  if (timeMs-gesture->startMs>TOUCHGESTURE_CONFIG_SWIPE_MAX_MS) {
+    return false; /* too slow */
+  }
+  if (adx>=TOUCHGESTURE_CONFIG_SWIPE_MIN_DIST && adx>=2*ady) {
+    event->gesture = dx<0 ? TOUCHGESTURE_SWIPE_LEFT : TOUCHGESTURE_SWIPE_RIGHT;
+  } else if (ady>=TOUCHGESTURE_CONFIG_SWIPE_MIN_DIST && ady>=2*adx) {
+    event->gesture = dy<0 ? TOUCHGESTURE_SWIPE_UP : TOUCHGESTURE_SWIPE_DOWN;
+  } else {
+    return false; /* too short or diagonal */
+  }
+  event->steps = 0;
+  return true;
+}
+
+bool TouchGesture_Process(TouchGesture_t *gesture, const TouchGesture_Input_t *input, uint32_t timeMs, TouchGesture_Event_t *event) {
+  switch(gesture->state) {
+    case TOUCHGESTURE_STATE_IDLE:
+      if (input->nofTouches==1) {
+        gesture->startX = gesture->lastX = input->point[0].x;
+        gesture->startY = gesture->lastY = input->point[0].y;
+        gesture->startMs = timeMs;
+        gesture->state = TOUCHGESTURE_STATE_SINGLE;
+      } else if (input->nofTouches==2) {
+        gesture->refY = (input->point[0].y+input->point[1].y)/2;
+        gesture->state = TOUCHGESTURE_STATE_DOUBLE;
+      }
+      break;
+
+    case TOUCHGESTURE_STATE_SINGLE:
+      if (input->nofTouches==0) {
+        gesture->state = TOUCHGESTURE_STATE_IDLE;
+        return TouchGesture_CheckSwipe(gesture, timeMs, event);
+      } else if (input->nofTouches==2) { /* second finger down: no swipe anymore */
+        gesture->refY = (input->point[0].y+input->point[1].y)/2;
+        gesture->state = TOUCHGESTURE_STATE_DOUBLE;
+      } else {
+        gesture->lastX = input->point[0].x;
+        gesture->lastY = input->point[0].y;
+      }
+      break;
+
+    case TOUCHGESTURE_STATE_DOUBLE:
+      if (input->nofTouches<2) { /* the drag ends with the first finger lifted */
+        gesture->state = input->nofTouches==0 ? TOUCHGESTURE_STATE_IDLE : TOUCHGESTURE_STATE_DONE;
+      } else {
+        int16_t y = (input->point[0].y+input->point[1].y)/2;
+        int16_t steps = (y-gesture->refY)/TOUCHGESTURE_CONFIG_DRAG_STEP;
+
+        if (steps!=0) {
+          gesture->refY += steps*TOUCHGESTURE_CONFIG_DRAG_STEP; /* keep the remainder for the next event */
+          event->gesture = TOUCHGESTURE_TWO_FINGER_DRAG;
+          event->steps = steps;
+          return true;
+        }
+      }
+      break;
+
+    case TOUCHGESTURE_STATE_DONE:
+    default:
+      if (input->nofTouches==0) {
+        gesture->state = TOUCHGESTURE_STATE_IDLE;
+      }
+      break;
+  }
+  return false;
+}
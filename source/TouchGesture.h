@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TOUCHGESTURE_H_
+#define TOUCHGESTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TOUCHGESTURE_CONFIG_SWIPE_MIN_DIST
+  #define TOUCHGESTURE_CONFIG_SWIPE_MIN_DIST   (60)
+#endif
+  /*!< minimal movement in pixels of a single finger for a swipe */
+
+#ifndef TOUCHGESTURE_CONFIG_SWIPE_MAX_MS
+  #define TOUCHGESTURE_CONFIG_SWIPE_MAX_MS     (400)
+#endif
+  /*!< maximum time in ms between finger down and up for a swipe, slower movements are a drag */
+
+#ifndef TOUCHGESTURE_CONFIG_DRAG_STEP
+  #define TOUCHGESTURE_CONFIG_DRAG_STEP        (20)
+#endif
+  /*!< vertical movement in pixels of two fingers for one drag event */
+
+typedef enum {
+  TOUCHGESTURE_NONE,
+  TOUCHGESTURE_SWIPE_LEFT,
+  TOUCHGESTURE_SWIPE_RIGHT,
+  TOUCHGESTURE_SWIPE_UP,
+  TOUCHGESTURE_SWIPE_DOWN,
+  TOUCHGESTURE_TWO_FINGER_DRAG, /* steps is the vertical movement in TOUCHGESTURE_CONFIG_DRAG_STEP, negative is up */
+} TouchGesture_e;
+
+typedef struct {
+  TouchGesture_e gesture;
+  int8_t steps; /* only for TOUCHGESTURE_TWO_FINGER_DRAG */
+} TouchGesture_Event_t;
+
+/* one report of the touch controller, in display coordinates */
+typedef struct {
+  uint8_t nofTouches; /* 0, 1 or 2 */
+  struct {
+    int16_t x, y;
+  } point[2];
+} TouchGesture_Input_t;
+
+typedef struct {
+  enum {
+    TOUCHGESTURE_STATE_IDLE, /* no finger down */
+    TOUCHGESTURE_STATE_SINGLE, /* one finger down, swipe candidate */
+    TOUCHGESTURE_STATE_DOUBLE, /* two fingers down */
+    TOUCHGESTURE_STATE_DONE, /* gesture over or aborted, waiting until all fingers are lifted */
+  } state;
+  int16_t startX, startY; /* single finger: position at finger down */
+  int16_t lastX, lastY; /* single finger: last position */
+  int16_t refY; /* two fingers: average y at the last drag event */
+  uint32_t startMs; /* time of finger down */
+} TouchGesture_t;
+
+void TouchGesture_Reset(TouchGesture_t *gesture);
+
+/* Feeds one controller report into the recogniser, with a time stamp in ms.
+ * Returns true with the recognised gesture in event. */
+bool TouchGesture_Process(TouchGesture_t *gesture, const TouchGesture_Input_t *input, uint32_t timeMs, TouchGesture_Event_t *event);
+
+/* true while two fingers are down: the touch points should not be reported to the GUI as a press */
+bool TouchGesture_IsMultiTouch(const TouchGesture_t *gesture);
+
+#endif /* TOUCHGESTURE_H_ */
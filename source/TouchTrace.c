@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Touch input record and replay: records the stream of the LVGL touch input device (only the changes, with a time stamp)
+ * and feeds it back into LVGL with the same timing. With 'touchtrace dump' a trace is written in C initializer
+ * syntax, so it can be compiled into the benchmark and loaded with TouchTrace_Load().
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_TOUCH_TRACE
+#include "TouchTrace.h"
+#include "lv.h"
+#include "McuRTOS.h"
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+  #include "McuUtility.h"
+#endif
+
+static struct {
+  TouchTrace_Event_t events[TOUCHTRACE_CONFIG_MAX_EVENTS];
+  size_t nofEvents;
+  uint32_t startMs; /* time of the first event while recording */
+  bool recording;
+  bool full; /* recording stopped because the buffer was full */
+} trace;
+
+static struct {
+  bool active; /* used as touch source */
+  bool done; /* last event has been reached */
+  uint32_t startMs; /* time when the replay started */
+  size_t next; /* next event to be reported */
+  TouchTrace_Event_t curr; /* state reported to LVGL */
+} replay;
+
+static uint32_t TouchTrace_GetTimeMs(void) {
+  return xTaskGetTickCount()*portTICK_PERIOD_MS;
+}
+
+void TouchTrace_StartRecording(void) {
+  taskENTER_CRITICAL();
+  trace.nofEvents = 0;
+  trace.full = false;
+  trace.recording = true;
+  taskEXIT_CRITICAL();
+}
+
+void TouchTrace_StopRecording(void) {
+  trace.recording = false;
+}
+
+bool TouchTrace_IsRecording(void) {
+  return trace.recording;
+}
+
+void TouchTrace_Record(bool pressed, uint16_t x, uint16_t y) {
+  TouchTrace_Event_t *last;
+  uint32_t now;
+
+  if (!trace.recording || replay.active) {
+    return;
+  }
+  now = TouchTrace_GetTimeMs();
+  taskENTER_CRITICAL();
+  if (trace.nofEvents>0) {
+    last = &trace.events[trace.nofEvents-1];
+    if (last->pressed==pressed && last->x==x && last->y==y) {
+      taskEXIT_CRITICAL();
+      return; /* no change */
+    }
+  } else {
+    trace.startMs = now;
+  }
+  if (trace.nofEvents<TOUCHTRACE_CONFIG_MAX_EVENTS) {
+    trace.events[trace.nofEvents] = (TouchTrace_Event_t){.timeMs=now-trace.startMs, .pressed=pressed, .x=x, .y=y};
+    trace.nofEvents++;
+  } else {
+    trace.recording = false;
+    trace.full = true;
+  }
+  taskEXIT_CRITICAL();
+}
+
+void TouchTrace_Load(const TouchTrace_Event_t *events, size_t nofEvents) {
+  if (nofEvents>TOUCHTRACE_CONFIG_MAX_EVENTS) {
+    nofEvents = TOUCHTRACE_CONFIG_MAX_EVENTS;
+  }
+  taskENTER_CRITICAL();
+  trace.recording = false;
+  trace.full = false;
+  for(size_t i=0; i<nofEvents; i++) {
+    trace.events[i] = events[i];
+  }
+  trace.nofEvents = nofEvents;
+  taskEXIT_CRITICAL();
+}
+
+size_t TouchTrace_GetNofEvents(void) {
+  return trace.nofEvents;
+}
+
+uint32_t TouchTrace_GetDurationMs(void) {
+  if (trace.nofEvents==0) {
+    return 0;
+  }
+  return trace.events[trace.nofEvents-1].timeMs;
+}
+
+static bool TouchTrace_ReplaySource(bool *pressed, uint16_t *x, uint16_t *y) {
+  /* LV_TouchSourceCallback: reports the last event which is due */
+  uint32_t time = TouchTrace_GetTimeMs()-replay.startMs;
+
+  while(replay.next<trace.nofEvents && trace.events[replay.next].timeMs<=time) {
+    replay.curr = trace.events[replay.next];
+    replay.next++;
+  }
+  if (replay.next>=trace.nofEvents) {
+    replay.done = true; /* the last state is kept */
+  }
+  *pressed = replay.curr.pressed;
+  *x = replay.curr.x;
+  *y = replay.curr.y;
+  return true;
+}
+
+void TouchTrace_StartReplay(void) {
+  replay.active = true;
+  replay.done = trace.nofEvents==0;
+  replay.next = 0;
+  replay.curr = (TouchTrace_Event_t){.timeMs=0, .pressed=0, .x=0, .y=0};
+  replay.startMs = TouchTrace_GetTimeMs();
+  LV_SetTouchSource(TouchTrace_ReplaySource);
+}
+
+void TouchTrace_StopReplay(void) {
+  if (replay.active) {
+    LV_SetTouchSource(NULL);
+    replay.active = false;
+  }
+}
+
+bool TouchTrace_IsReplaying(void) {
+  return replay.active && !replay.done;
+}
+
+#if PL_CONFIG_USE_SHELL
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+
+  McuShell_SendStatusStr((unsigned char*)"touchtrace", (unsigned char*)"\r\n", io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), trace.nofEvents);
+  McuUtility_chcat(buf, sizeof(buf), '/');
+  McuUtility_strcatNum32u(buf, sizeof(buf), TOUCHTRACE_CONFIG_MAX_EVENTS);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), TouchTrace_GetDurationMs());
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  events", buf, io->stdOut);
+  if (trace.recording) {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"yes\r\n");
+  } else if (trace.full) {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"no (buffer full)\r\n");
+  } else {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"no\r\n");
+  }
+  McuShell_SendStatusStr((unsigned char*)"  recording", buf, io->stdOut);
+  McuShell_SendStatusStr((unsigned char*)"  replaying", TouchTrace_IsReplaying()?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"touchtrace", (unsigned char*)"Group of touch input record and replay commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  record", (unsigned char*)"Clear the trace and record the touch input, start on the main screen\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  stop", (unsigned char*)"Stop recording\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  dump", (unsigned char*)"Write the trace as C initializer for TouchTrace_Event_t\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+static void Dump(const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+  TouchTrace_Event_t event;
+  size_t nof;
+
+  nof = trace.nofEvents;
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"/* touch trace: ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), nof);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" events, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), TouchTrace_GetDurationMs());
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms */\r\n");
+  McuShell_SendStr(buf, io->stdOut);
+  for(size_t i=0; i<nof; i++) {
+    event = trace.events[i];
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"{");
+    McuUtility_strcatNum32u(buf, sizeof(buf), event.timeMs);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", ");
+    McuUtility_strcatNum8u(buf, sizeof(buf), event.pressed);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", ");
+    McuUtility_strcatNum16u(buf, sizeof(buf), event.x);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", ");
+    McuUtility_strcatNum16u(buf, sizeof(buf), event.y);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"},\r\n");
+    McuShell_SendStr(buf, io->stdOut);
+  }
+}
+
+uint8_t TouchTrace_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "touchtrace help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "touchtrace status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strcmp((char*)cmd, "touchtrace record")==0) {
+    *handled = TRUE;
+    TouchTrace_StartRecording();
+    return ERR_OK;
+  } else if (McuUtility_strcmp((char*)cmd, "touchtrace stop")==0) {
+    *handled = TRUE;
+    TouchTrace_StopRecording();
+    return ERR_OK;
+  } else if (McuUtility_strcmp((char*)cmd, "touchtrace dump")==0) {
+    *handled = TRUE;
+    if (trace.recording) {
+      McuShell_SendStr((unsigned char*)"stop recording first\r\n", io->stdErr);
+      return ERR_BUSY;
+    }
+    Dump(io);
+    return ERR_OK;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_SHELL */
+
+void TouchTrace_Deinit(void) {
+  TouchTrace_StopReplay();
+  trace.recording = false;
+}
+
+void TouchTrace_Init(void) {
+  trace.nofEvents = 0;
+  trace.recording = false;
+  trace.full = false;
+  replay.active = false;
+  replay.done = true;
+}
+
+#endif /* PL_CONFIG_USE_TOUCH_TRACE */
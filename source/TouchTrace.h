@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TOUCHTRACE_H_
+#define TOUCHTRACE_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_TOUCH_TRACE
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#ifndef TOUCHTRACE_CONFIG_MAX_EVENTS
+  #define TOUCHTRACE_CONFIG_MAX_EVENTS   (512) /* only changes are recorded: about 15 s of dragging at the 30 ms read period */
+#endif
+  /*!< maximum number of events in a trace, recording stops if the buffer is full */
+
+/* one change of the touch input as reported to LVGL. The state holds until the next event */
+typedef struct {
+  uint32_t timeMs; /* time since the first event of the trace */
+  uint8_t pressed; /* 1: LV_INDEV_STATE_PR, 0: LV_INDEV_STATE_REL */
+  uint16_t x, y; /* display coordinates, the last pressed position while released */
+} TouchTrace_Event_t;
+
+/* recording: clears the trace, the first event is at time 0 */
+void TouchTrace_StartRecording(void);
+void TouchTrace_StopRecording(void);
+bool TouchTrace_IsRecording(void);
+
+/* called from the LVGL input device read for each read: only changes get stored */
+void TouchTrace_Record(bool pressed, uint16_t x, uint16_t y);
+
+/* replaces the trace, e.g. with one dumped with 'touchtrace dump' and compiled into the benchmark */
+void TouchTrace_Load(const TouchTrace_Event_t *events, size_t nofEvents);
+size_t TouchTrace_GetNofEvents(void);
+uint32_t TouchTrace_GetDurationMs(void);
+
+/* replay: feeds the trace into LVGL as the touch source, with the recorded timing. Has to be called from the task running LVGL */
+void TouchTrace_StartReplay(void);
+void TouchTrace_StopReplay(void);
+bool TouchTrace_IsReplaying(void); /* false once the last event has been reached */
+
+#if PL_CONFIG_USE_SHELL
+  uint8_t TouchTrace_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
+
+void TouchTrace_Deinit(void);
+void TouchTrace_Init(void);
+
+#endif /* PL_CONFIG_USE_TOUCH_TRACE */
+
+#endif /* TOUCHTRACE_H_ */
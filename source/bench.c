@@ -0,0 +1,801 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Frame time benchmark: drives scripted touch sequences through the LVGL touch input and collects the frame
+ * measurements of lv.c (invalidated areas, rendered pixels, bytes sent to the panel, render and flush time).
+ * Times are DWT cycles, see LV_GetTimestamp().
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_BENCH
+#include "bench.h"
+#include "lv.h"
+#include "gui.h"
+#include "sysmon.h"
+#include "demo/demo.h"
+#include "McuSPI.h"
+#include "McuRTOS.h"
+#include "McuUtility.h"
+#include "McuShell.h"
+#include "TouchFilter.h"
+#if PL_CONFIG_USE_SPECTRUM
+  #include "Spectrum.h"
+  #include "SpectrumView.h"
+#endif
+#if PL_CONFIG_USE_EQ_CURVE
+  #include "EqCurve.h"
+#endif
+#if PL_CONFIG_USE_TOUCH_TRACE
+  #include "TouchTrace.h"
+#endif
+#include <string.h>
+#include <stdlib.h> /* for abs() */
+#if BENCH_CONFIG_USE_I2C || BENCH_CONFIG_USE_SPI
+  #include "McuArmTools.h"
+#endif
+#if BENCH_CONFIG_USE_I2C
+  #include "McuGenericI2C.h"
+  #if PL_CONFIG_USE_HW_I2C
+    #include "i2clib.h"
+  #endif
+#endif
+
+#if !LV_CONFIG_USE_FRAME_STATS
+  #error "benchmark needs the frame measurements of lv.c"
+#endif
+
+#define BENCH_MAX_FRAMES         (256) /* maximum number of frames recorded per scenario, about 7 s of a touch trace replay */
+#define BENCH_FRAME_PERIOD_MS    (LV_DISP_DEF_REFR_PERIOD) /* one LV_Task() call per refresh period */
+
+typedef struct {
+  bool pressed; /* touch state for this step */
+  uint16_t x, y; /* display coordinates */
+  uint8_t nofFrames; /* number of refresh periods to stay in this step */
+} BENCH_Step_t;
+
+typedef struct {
+  const char *name;
+  void (*setup)(void); /* creates the screen */
+  void (*teardown)(void); /* deletes what setup() has created, can be NULL */
+  const BENCH_Step_t *script;
+  size_t nofSteps;
+} BENCH_Scenario_t;
+
+#define BENCH_TAP(x, y)   {true, (x), (y), 3}, {false, (x), (y), 3}
+#define BENCH_IDLE(n)     {false, 0, 0, (n)}
+
+/* EQ screen: band columns are 48 pixels wide, centered at x=24, 72, 120, 168 and 216.
+ * y=140..260 hits five different gain steps, with and without the response curve above the columns */
+static const BENCH_Step_t scriptEq[] = {
+  BENCH_IDLE(3), /* full screen redraw */
+  BENCH_TAP(24, 140), BENCH_TAP(72, 170), BENCH_TAP(120, 200), BENCH_TAP(168, 230), BENCH_TAP(216, 260),
+  BENCH_TAP(24, 260), BENCH_TAP(72, 230), BENCH_TAP(120, 200), BENCH_TAP(168, 170), BENCH_TAP(216, 140),
+  BENCH_IDLE(3),
+};
+
+/* system monitor: the window updates the chart and label every 500 ms */
+static const BENCH_Step_t scriptSysMon[] = {
+  BENCH_IDLE(3*(500/BENCH_FRAME_PERIOD_MS)),
+};
+
+/* demo: switch through the tabs in the header */
+static const BENCH_Step_t scriptDemo[] = {
+  BENCH_IDLE(3),
+  BENCH_TAP(90, 15), BENCH_IDLE(10), /* 'List' */
+  BENCH_TAP(150, 15), BENCH_IDLE(10), /* 'Chart' */
+  BENCH_TAP(30, 15), BENCH_IDLE(10), /* 'Write' */
+};
+
+#if PL_CONFIG_USE_SPECTRUM
+/* spectrum: a generated sweep moves through all bars in 3 s, the analysis runs in its own task at 30 Hz */
+static const BENCH_Step_t scriptSpectrum[] = {
+  BENCH_IDLE(3), /* full screen redraw */
+  BENCH_IDLE(3000/BENCH_FRAME_PERIOD_MS),
+};
+#endif
+
+static void SetupEq(void) {
+  GUI_SwitchToMainScreen();
+  lv_obj_invalidate(lv_scr_act());
+}
+
+static void SetupSysMon(void) {
+  GUI_SwitchToMainScreen();
+  GUI_SysMon_Create();
+}
+
+#if PL_CONFIG_USE_SPECTRUM
+static void SetupSpectrum(void) {
+  GUI_SwitchToMainScreen();
+  Spectrum_SetSource(SPECTRUM_SOURCE_SWEEP, 0);
+  GUI_Spectrum_Create();
+}
+
+static void TeardownSpectrum(void) {
+  GUI_Spectrum_Close();
+  Spectrum_SetSource(SPECTRUM_SOURCE_SWEEP, 0); /* default, restarts the sweep */
+}
+#endif
+
+static const BENCH_Scenario_t scenarios[] = {
+  {"eq", SetupEq, NULL, scriptEq, sizeof(scriptEq)/sizeof(scriptEq[0])},
+  {"sysmon", SetupSysMon, GUI_SysMon_Close, scriptSysMon, sizeof(scriptSysMon)/sizeof(scriptSysMon[0])},
+  {"demo", GUI_Demo_Create, GUI_Demo_Delete, scriptDemo, sizeof(scriptDemo)/sizeof(scriptDemo[0])},
+#if PL_CONFIG_USE_SPECTRUM
+  {"spectrum", SetupSpectrum, TeardownSpectrum, scriptSpectrum, sizeof(scriptSpectrum)/sizeof(scriptSpectrum[0])},
+#endif
+};
+
+static LV_FrameSample_t samples[BENCH_MAX_FRAMES];
+static volatile size_t nofSamples;
+static const BENCH_Step_t *currStep; /* current touch state */
+
+/* benchmarks requested with the shell which have to run in the GUI task */
+typedef enum {
+  BENCH_REQUEST_ALL,      /* all scenarios */
+  BENCH_REQUEST_SCENARIO, /* requestedScenario */
+  BENCH_REQUEST_REPLAY,   /* replay the touch trace */
+  BENCH_REQUEST_SCREEN,   /* check the main screen */
+  BENCH_REQUEST_CURVE,    /* EQ scenario with the response curve measurements */
+  BENCH_REQUEST_COMPARE,  /* all scenarios with both area join policies */
+} BENCH_Request_e;
+
+static BENCH_Request_e request;
+static const BENCH_Scenario_t *requestedScenario; /* for BENCH_REQUEST_SCENARIO */
+static const McuShell_StdIOType *requestIo; /* where to write the results, NULL: no request */
+
+static void FrameHook(const LV_FrameSample_t *sample) {
+  /* called from lv.c at the end of each frame, possibly from the DMA interrupt */
+  if (nofSamples<BENCH_MAX_FRAMES) {
+    samples[nofSamples++] = *sample;
+  }
+}
+
+static bool TouchSource(bool *pressed, uint16_t *x, uint16_t *y) {
+  if (currStep==NULL) {
+    return false;
+  }
+  *pressed = currStep->pressed;
+  *x = currStep->x;
+  *y = currStep->y;
+  return true;
+}
+
+static void SortU32(uint32_t *values, size_t nof) {
+  /* insertion sort, the number of values is small */
+  for(size_t i=1; i<nof; i++) {
+    uint32_t v = values[i];
+    size_t j = i;
+
+    while(j>0 && values[j-1]>v) {
+      values[j] = values[j-1];
+      j--;
+    }
+    values[j] = v;
+  }
+}
+
+static void PrintMinAvgP99(const unsigned char *name, uint32_t *values, size_t nof, const McuShell_StdIOType *io) {
+  uint8_t buf[64];
+  uint64_t sum = 0;
+
+  for(size_t i=0; i<nof; i++) {
+    sum += values[i];
+  }
+  SortU32(values, nof);
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"min ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(values[0]));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, avg ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(sum/nof));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, p99 ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(values[(nof*99+99)/100-1])); /* nearest rank */
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  McuShell_SendStatusStr(name, buf, io->stdOut);
+}
+
+static void PrintResult(const BENCH_Scenario_t *scenario, const McuShell_StdIOType *io) {
+  static uint32_t values[BENCH_MAX_FRAMES];
+  uint32_t nofAreas = 0, px = 0, nofBytes = 0;
+  uint8_t buf[64], name[16];
+  size_t nof = nofSamples;
+
+  for(size_t i=0; i<nof; i++) {
+    nofAreas += samples[i].nofAreas;
+    px += samples[i].px;
+    nofBytes += samples[i].nofBytes;
+  }
+  McuUtility_strcpy(name, sizeof(name), (unsigned char*)"  ");
+  McuUtility_strcat(name, sizeof(name), (const unsigned char*)scenario->name);
+  McuUtility_Num32uToStr(buf, sizeof(buf), nof);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" frames, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), nofAreas);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" areas, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), px);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), nofBytes);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" bytes\r\n");
+  McuShell_SendStatusStr(name, buf, io->stdOut);
+  if (nof==0) {
+    return;
+  }
+  for(size_t i=0; i<nof; i++) {
+    values[i] = samples[i].render;
+  }
+  PrintMinAvgP99((unsigned char*)"    render", values, nof, io);
+  for(size_t i=0; i<nof; i++) {
+    values[i] = samples[i].flush;
+  }
+  PrintMinAvgP99((unsigned char*)"    flush", values, nof, io);
+}
+
+static void RunScenario(const BENCH_Scenario_t *scenario, const McuShell_StdIOType *io) {
+  scenario->setup();
+  (void)LV_Task(); /* process the setup, not measured */
+  while(McuSPI_IsBusy()) {
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  nofSamples = 0;
+  LV_SetFrameHook(FrameHook);
+  LV_SetTouchSource(TouchSource);
+  for(size_t i=0; i<scenario->nofSteps; i++) {
+    currStep = &scenario->script[i];
+    for(int j=0; j<currStep->nofFrames; j++) {
+      vTaskDelay(pdMS_TO_TICKS(BENCH_FRAME_PERIOD_MS));
+      (void)LV_Task();
+    }
+  }
+  while(McuSPI_IsBusy()) { /* last frame is still being flushed */
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  LV_SetFrameHook(NULL);
+  LV_SetTouchSource(NULL);
+  currStep = NULL;
+  if (scenario->teardown!=NULL) {
+    scenario->teardown();
+  }
+  PrintResult(scenario, io);
+}
+
+static bool CheckLimit(const unsigned char *name, uint32_t value, uint32_t limit, const unsigned char *unit, const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+  bool ok = value<=limit;
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), value);
+  McuUtility_strcat(buf, sizeof(buf), unit);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" (max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), limit);
+  McuUtility_strcat(buf, sizeof(buf), ok?(unsigned char*)") PASS\r\n":(unsigned char*)") FAIL\r\n");
+  McuShell_SendStatusStr(name, buf, io->stdOut);
+  return ok;
+}
+
+uint8_t BENCH_RunScreen(const McuShell_StdIOType *io) {
+  GUI_ScreenStats_t stats;
+  uint32_t redraw = 0;
+  bool ok = true;
+
+  SetupEq(); /* main screen, fully invalidated */
+  nofSamples = 0;
+  LV_SetFrameHook(FrameHook);
+  (void)LV_Task(); /* renders the full screen */
+  while(McuSPI_IsBusy()) { /* last band is still being flushed */
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  LV_SetFrameHook(NULL);
+  for(size_t i=0; i<nofSamples; i++) {
+    redraw += samples[i].render+samples[i].flush;
+  }
+  GUI_GetMainScreenStats(&stats);
+  McuShell_SendStatusStr((unsigned char*)"  screen", (unsigned char*)"main\r\n", io->stdOut);
+  ok &= CheckLimit((unsigned char*)"    objects", stats.nofObjects, BENCH_CONFIG_SCREEN_MAX_OBJECTS, (unsigned char*)"", io);
+  ok &= CheckLimit((unsigned char*)"    heap", stats.heapBytes, BENCH_CONFIG_SCREEN_MAX_HEAP, (unsigned char*)" bytes", io);
+  ok &= CheckLimit((unsigned char*)"    redraw", LV_TimestampToUs(redraw), BENCH_CONFIG_SCREEN_MAX_REDRAW_US, (unsigned char*)" us", io);
+  return ok ? ERR_OK : ERR_FAILED;
+}
+
+#if PL_CONFIG_USE_TOUCH_TRACE
+void BENCH_RunReplay(const McuShell_StdIOType *io) {
+  static const BENCH_Scenario_t replay = {"replay", SetupEq, NULL, NULL, 0};
+  int nofIdle = 0;
+
+  replay.setup(); /* the trace gets recorded starting on the main screen */
+  (void)LV_Task(); /* process the setup, not measured */
+  while(McuSPI_IsBusy()) {
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  nofSamples = 0;
+  LV_SetFrameHook(FrameHook);
+  TouchTrace_StartReplay();
+  while(nofIdle<3) { /* a few frames after the last event, for the release and animations */
+    vTaskDelay(pdMS_TO_TICKS(BENCH_FRAME_PERIOD_MS));
+    (void)LV_Task();
+    if (!TouchTrace_IsReplaying()) {
+      nofIdle++;
+    }
+  }
+  while(McuSPI_IsBusy()) { /* last frame is still being flushed */
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  LV_SetFrameHook(NULL);
+  TouchTrace_StopReplay();
+  PrintResult(&replay, io);
+}
+#endif
+
+#if PL_CONFIG_USE_EQ_CURVE
+void BENCH_RunCurve(const McuShell_StdIOType *io) {
+  GUI_EqCurve_Stats_t stats;
+  uint8_t buf[64];
+
+  GUI_EqCurve_ResetStats();
+  RunScenario(&scenarios[0], io); /* eq: each tap changes the gain of one band */
+  GUI_EqCurve_GetStats(&stats);
+  McuUtility_Num32uToStr(buf, sizeof(buf), stats.nofUpdates);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" updates, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofBands);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" bands evaluated at ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), EQCURVE_CONFIG_NOF_POINTS);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" points\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  curve", buf, io->stdOut);
+  if (stats.nofUpdates==0) {
+    return;
+  }
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"avg ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(stats.evalSum/stats.nofUpdates));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(stats.evalMax));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  McuShell_SendStatusStr((unsigned char*)"    evaluate", buf, io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), stats.nofAreas);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" areas, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.px/stats.nofUpdates);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px per update\r\n");
+  McuShell_SendStatusStr((unsigned char*)"    invalidated", buf, io->stdOut);
+}
+#endif
+
+void BENCH_RunAll(const McuShell_StdIOType *io) {
+  for(size_t i=0; i<sizeof(scenarios)/sizeof(scenarios[0]); i++) {
+    RunScenario(&scenarios[i], io);
+  }
+}
+
+#if LV_CONFIG_AREA_JOIN_COST
+void BENCH_CompareAreaJoin(const McuShell_StdIOType *io) {
+  uint32_t flushCost, pxCost;
+  bool enabled;
+
+  enabled = LV_GetAreaJoinCost(&flushCost, &pxCost);
+  McuShell_SendStatusStr((unsigned char*)" join overlap", (unsigned char*)"\r\n", io->stdOut);
+  LV_SetAreaJoinCost(false);
+  BENCH_RunAll(io);
+  McuShell_SendStatusStr((unsigned char*)" join cost", (unsigned char*)"\r\n", io->stdOut);
+  LV_SetAreaJoinCost(true);
+  BENCH_RunAll(io);
+  LV_SetAreaJoinCost(enabled);
+}
+#endif
+
+/* Touch filter traces, generated and not recorded: a pen down with a known true path plus pseudo random noise.
+ * The first and last samples are light presses (high z) with more noise, as seen when the pen touches down and lifts off.
+ * The figures are only as good as this noise model, check them against a trace of the panel ('touchtrace record'). */
+typedef struct {
+  const char *name;
+  uint16_t x0, y; /* start position */
+  uint8_t dx; /* true movement in pixels per sample, along x. 0: the pen is held */
+  uint8_t noise; /* maximum noise in pixels */
+  uint8_t nofSamples;
+} BENCH_TouchTrace_t;
+
+#define BENCH_TOUCH_Z_FIRM    (40) /* pressure of a firm press */
+#define BENCH_TOUCH_Z_LIGHT   (200) /* pressure while touching down or lifting off */
+#define BENCH_TOUCH_NOF_LIGHT (2) /* number of light press samples at the start and at the end */
+
+static const BENCH_TouchTrace_t touchTraces[] = {
+  {"hold", 120, 160, 0, 3, 100},
+  {"drag", 40, 160, 2, 3, 80},
+  {"swipe", 20, 160, 8, 3, 25},
+};
+
+static int32_t TouchNoise(uint32_t *seed, uint8_t amplitude) {
+  *seed = *seed*1664525U+1013904223U; /* LCG, same sequence on every run */
+  return (int32_t)((*seed>>16)%(2U*amplitude+1U))-amplitude;
+}
+
+static void TouchTraceSample(const BENCH_TouchTrace_t *trace, int i, uint32_t *seed, TouchFilter_Sample_t *sample, int32_t *trueX) {
+  bool light = i<BENCH_TOUCH_NOF_LIGHT || i>=trace->nofSamples-BENCH_TOUCH_NOF_LIGHT;
+  uint8_t noise = light ? 4*trace->noise : trace->noise;
+
+  *trueX = trace->x0+i*trace->dx;
+  sample->x = (uint16_t)(*trueX+TouchNoise(seed, noise));
+  sample->y = (uint16_t)(trace->y+TouchNoise(seed, noise));
+  sample->z = light ? BENCH_TOUCH_Z_LIGHT : BENCH_TOUCH_Z_FIRM;
+}
+
+static void StrCatTenths(uint8_t *buf, size_t bufSize, int32_t tenths) {
+  if (tenths<0) {
+    McuUtility_chcat(buf, bufSize, '-');
+    tenths = -tenths;
+  }
+  McuUtility_strcatNum32u(buf, bufSize, tenths/10);
+  McuUtility_chcat(buf, bufSize, '.');
+  McuUtility_strcatNum32u(buf, bufSize, tenths%10);
+}
+
+static void RunTouchTrace(const BENCH_TouchTrace_t *trace, const McuShell_StdIOType *io) {
+  TouchFilter_t filter;
+  TouchFilter_Sample_t sample;
+  uint32_t seed = 0x5EED;
+  uint32_t jitterRaw = 0, jitterFilt = 0; /* sum of the position changes while the pen is held */
+  uint32_t errRaw = 0, errFilt = 0; /* sum of the distances to the true position */
+  int32_t lag = 0; /* sum of the distances behind the true position, along the movement */
+  uint32_t nof = 0, ts, cost, costSum = 0, costMax = 0;
+  uint16_t x, y, rawX = 0, rawY = 0, filtX = 0, filtY = 0;
+  int32_t trueX;
+  bool valid;
+  uint8_t buf[96], name[16];
+
+  TouchFilter_Reset(&filter);
+  for(int i=0; i<trace->nofSamples; i++) {
+    TouchTraceSample(trace, i, &seed, &sample, &trueX);
+    ts = LV_GetTimestamp();
+    valid = TouchFilter_Process(&filter, &sample, &x, &y);
+    cost = LV_GetTimestamp()-ts;
+    costSum += cost;
+    if (cost>costMax) {
+      costMax = cost;
+    }
+    if (!valid) {
+      continue; /* nothing reported to LVGL */
+    }
+    if (nof>0 && trace->dx==0) {
+      jitterRaw += abs(sample.x-rawX)+abs(sample.y-rawY);
+      jitterFilt += abs(x-filtX)+abs(y-filtY);
+    }
+    errRaw += abs(sample.x-trueX)+abs(sample.y-trace->y);
+    errFilt += abs(x-trueX)+abs(y-trace->y);
+    lag += trueX-x;
+    rawX = sample.x; rawY = sample.y;
+    filtX = x; filtY = y;
+    nof++;
+  }
+  McuUtility_strcpy(name, sizeof(name), (unsigned char*)"  ");
+  McuUtility_strcat(name, sizeof(name), (const unsigned char*)trace->name);
+  McuUtility_Num32uToStr(buf, sizeof(buf), nof);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"/");
+  McuUtility_strcatNum32u(buf, sizeof(buf), trace->nofSamples);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" samples accepted\r\n");
+  McuShell_SendStatusStr(name, buf, io->stdOut);
+  if (nof==0) {
+    return;
+  }
+  if (trace->dx==0) {
+    McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"raw ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), jitterRaw);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px, filtered ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), jitterFilt);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px, removed ");
+    McuUtility_strcatNum32u(buf, sizeof(buf), jitterRaw==0 ? 0 : 100-(jitterFilt*100)/jitterRaw);
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"%\r\n");
+    McuShell_SendStatusStr((unsigned char*)"    jitter", buf, io->stdOut);
+  }
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"raw ");
+  StrCatTenths(buf, sizeof(buf), (int32_t)((errRaw*10)/nof));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px, filtered ");
+  StrCatTenths(buf, sizeof(buf), (int32_t)((errFilt*10)/nof));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px\r\n");
+  McuShell_SendStatusStr((unsigned char*)"    error", buf, io->stdOut);
+  if (trace->dx!=0) {
+    buf[0] = '\0';
+    StrCatTenths(buf, sizeof(buf), (lag*10)/(int32_t)(nof*trace->dx)); /* distance behind divided by the speed */
+    McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" samples\r\n");
+    McuShell_SendStatusStr((unsigned char*)"    lag", buf, io->stdOut);
+  }
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"avg ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), costSum/trace->nofSamples);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), costMax);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" cycles per sample\r\n");
+  McuShell_SendStatusStr((unsigned char*)"    cost", buf, io->stdOut);
+}
+
+void BENCH_RunTouchFilter(const McuShell_StdIOType *io) {
+  uint8_t buf[64];
+
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"median ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), TOUCHFILTER_CONFIG_MEDIAN_N);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", z max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), TOUCHFILTER_CONFIG_Z_MAX);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", dead zone ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), TOUCHFILTER_CONFIG_DEAD_ZONE);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px\r\n");
+  McuShell_SendStatusStr((unsigned char*)" touch filter", buf, io->stdOut);
+  McuShell_SendStatusStr((unsigned char*)" traces", (unsigned char*)"generated, fixed seed\r\n", io->stdOut);
+  for(size_t i=0; i<sizeof(touchTraces)/sizeof(touchTraces[0]); i++) {
+    RunTouchTrace(&touchTraces[i], io);
+  }
+}
+
+#if PL_CONFIG_USE_SPECTRUM
+#define BENCH_FFT_NOF_FRAMES   (32)
+
+void BENCH_RunFft(const McuShell_StdIOType *io) {
+  static int32_t frame[SPECTRUM_CONFIG_FFT_SIZE];
+  uint32_t values[BENCH_FFT_NOF_FRAMES];
+  uint8_t levels[SPECTRUM_NOF_BARS];
+  uint8_t buf[64];
+  uint32_t ts, sum = 0;
+
+  for(int i=0; i<BENCH_FFT_NOF_FRAMES; i++) {
+    Spectrum_GenerateTone(frame, 50.0f+i*500.0f, 0.5f); /* not timed */
+    ts = LV_GetTimestamp();
+    Spectrum_Analyse(frame, levels);
+    values[i] = LV_GetTimestamp()-ts;
+    sum += values[i];
+  }
+  McuUtility_Num32uToStr(buf, sizeof(buf), SPECTRUM_CONFIG_FFT_SIZE);
+#if SPECTRUM_CONFIG_USE_CMSIS_DSP
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" points, CMSIS-DSP\r\n");
+#else
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" points, radix-2\r\n");
+#endif
+  McuShell_SendStatusStr((unsigned char*)" spectrum fft", buf, io->stdOut);
+  /* share of the analysis period, the redraw is measured with 'bench run spectrum' */
+  McuUtility_Num32uToStr(buf, sizeof(buf), LV_TimestampToUs(sum/BENCH_FFT_NOF_FRAMES)/(SPECTRUM_CONFIG_PERIOD_MS*10));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"% of ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), SPECTRUM_CONFIG_PERIOD_MS);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  load", buf, io->stdOut);
+  PrintMinAvgP99((unsigned char*)"  analyse", values, BENCH_FFT_NOF_FRAMES, io);
+}
+#endif /* PL_CONFIG_USE_SPECTRUM */
+
+#if BENCH_CONFIG_USE_I2C
+#define BENCH_I2C_DEVICE_ADDR   (0x1A) /* WM8904 audio codec on the LPC55S69-EVK */
+#define BENCH_I2C_DEVICE_REG    (0x00) /* 16bit device ID register */
+#define BENCH_I2C_NOF_READS     (100)
+
+void BENCH_RunI2C(const McuShell_StdIOType *io) {
+  uint8_t buf[64], reg, data[2];
+  uint32_t start, cycles, nofErrors = 0;
+#if PL_CONFIG_USE_HW_I2C && I2CLIB_CONFIG_USE_INTERRUPT
+  I2CLIB_Stats_t stats;
+
+  I2CLIB_ResetStats();
+#endif
+  start = McuArmTools_GetCycleCounter();
+  for(int i=0; i<BENCH_I2C_NOF_READS; i++) {
+    reg = BENCH_I2C_DEVICE_REG;
+    if (McuGenericI2C_ReadAddress(BENCH_I2C_DEVICE_ADDR, &reg, sizeof(reg), data, sizeof(data))!=ERR_OK) {
+      nofErrors++;
+    }
+  }
+  cycles = McuArmTools_GetCycleCounter()-start;
+
+#if PL_CONFIG_USE_HW_I2C
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"FLEXCOMM4, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), I2CLIB_CONFIG_BAUDRATE/1000);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" kHz\r\n");
+#else
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"bit banging\r\n");
+#endif
+  McuShell_SendStatusStr((unsigned char*)" i2c", buf, io->stdOut);
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), BENCH_I2C_NOF_READS);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" x 2 bytes, errors ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), nofErrors);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  reads", buf, io->stdOut);
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), cycles/BENCH_I2C_NOF_READS/(SystemCoreClock/1000000U));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us per read\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  time", buf, io->stdOut);
+#if PL_CONFIG_USE_HW_I2C && I2CLIB_CONFIG_USE_INTERRUPT
+  I2CLIB_GetStats(&stats);
+  McuUtility_Num32uToStr(buf, sizeof(buf), (uint32_t)(((uint64_t)stats.blockedCycles*100U)/cycles));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"% blocked, available to other tasks\r\n");
+#else
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"0% blocked, CPU busy for the whole transfer\r\n");
+#endif
+  McuShell_SendStatusStr((unsigned char*)"  cpu", buf, io->stdOut);
+}
+#endif /* BENCH_CONFIG_USE_I2C */
+
+#if BENCH_CONFIG_USE_SPI
+#define BENCH_SPI_NOF_SWITCHES  (1000) /* each one LCD->touch->LCD */
+
+static uint32_t BENCH_TimeSPISwitch(void (*switchConfig)(McuSPI_Config)) {
+  uint32_t start;
+
+  start = McuArmTools_GetCycleCounter();
+  for(int i=0; i<BENCH_SPI_NOF_SWITCHES; i++) {
+    switchConfig(McuSPI_ConfigTouch1);
+    switchConfig(McuSPI_ConfigLCD);
+  }
+  return (McuArmTools_GetCycleCounter()-start)/(2*BENCH_SPI_NOF_SWITCHES);
+}
+
+void BENCH_RunSPI(const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+  uint32_t full, fast;
+
+  McuSPI_RequestBus(McuSPI_ClientLCD); /* keeps the display and touch off the bus */
+  full = BENCH_TimeSPISwitch(McuSPI_SwitchConfigFull);
+  fast = BENCH_TimeSPISwitch(McuSPI_SwitchConfig);
+  McuSPI_ReleaseBus(McuSPI_ClientLCD);
+
+  McuShell_SendStatusStr((unsigned char*)" spi", (unsigned char*)"cycles per configuration switch\r\n", io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), full);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  SPI_MasterInit", buf, io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), fast);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  precomputed", buf, io->stdOut);
+}
+#endif /* BENCH_CONFIG_USE_SPI */
+
+void BENCH_Process(void) {
+  const McuShell_StdIOType *io;
+
+  io = requestIo;
+  if (io==NULL) {
+    return; /* nothing requested */
+  }
+  McuShell_SendStatusStr((unsigned char*)"bench", (unsigned char*)"\r\n", io->stdOut);
+  switch(request) {
+    case BENCH_REQUEST_SCENARIO:
+      RunScenario(requestedScenario, io);
+      break;
+#if PL_CONFIG_USE_TOUCH_TRACE
+    case BENCH_REQUEST_REPLAY:
+      BENCH_RunReplay(io);
+      break;
+#endif
+    case BENCH_REQUEST_SCREEN:
+      (void)BENCH_RunScreen(io);
+      break;
+#if PL_CONFIG_USE_EQ_CURVE
+    case BENCH_REQUEST_CURVE:
+      BENCH_RunCurve(io);
+      break;
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+    case BENCH_REQUEST_COMPARE:
+      BENCH_CompareAreaJoin(io);
+      break;
+#endif
+    case BENCH_REQUEST_ALL:
+    default:
+      BENCH_RunAll(io);
+      break;
+  }
+  requestIo = NULL;
+}
+
+/* hands a benchmark over to the GUI task, only one can be pending */
+static uint8_t Request(BENCH_Request_e req, const BENCH_Scenario_t *scenario, const McuShell_StdIOType *io) {
+  if (requestIo!=NULL) {
+    McuShell_SendStr((unsigned char*)"benchmark already running\r\n", io->stdErr);
+    return ERR_BUSY;
+  }
+  request = req;
+  requestedScenario = scenario;
+  requestIo = io; /* picked up by the GUI task */
+  LV_Notify(LV_NOTIFY_WAKEUP);
+  return ERR_OK;
+}
+
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[48];
+
+  McuShell_SendStatusStr((unsigned char*)"bench", (unsigned char*)"\r\n", io->stdOut);
+  buf[0] = '\0';
+  for(size_t i=0; i<sizeof(scenarios)/sizeof(scenarios[0]); i++) {
+    McuUtility_strcat(buf, sizeof(buf), (const unsigned char*)scenarios[i].name);
+    McuUtility_chcat(buf, sizeof(buf), ' ');
+  }
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  scenarios", buf, io->stdOut);
+  McuShell_SendStatusStr((unsigned char*)"  running", requestIo!=NULL?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"bench", (unsigned char*)"Group of GUI frame time benchmark commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  run all|<name>", (unsigned char*)"Run all or a single scenario\r\n", io->stdOut);
+#if PL_CONFIG_USE_TOUCH_TRACE
+  McuShell_SendHelpStr((unsigned char*)"  replay", (unsigned char*)"Replay the trace recorded with 'touchtrace record'\r\n", io->stdOut);
+#endif
+  McuShell_SendHelpStr((unsigned char*)"  screen", (unsigned char*)"Check objects, heap and redraw time of the main screen\r\n", io->stdOut);
+#if PL_CONFIG_USE_EQ_CURVE
+  McuShell_SendHelpStr((unsigned char*)"  curve", (unsigned char*)"Run the EQ scenario, report evaluation time and pixels of the response curve\r\n", io->stdOut);
+#endif
+  McuShell_SendHelpStr((unsigned char*)"  touch", (unsigned char*)"Run generated touch traces through the touch filter\r\n", io->stdOut);
+#if PL_CONFIG_USE_SPECTRUM
+  McuShell_SendHelpStr((unsigned char*)"  fft", (unsigned char*)"Time the spectrum analysis of one frame\r\n", io->stdOut);
+#endif
+#if BENCH_CONFIG_USE_I2C
+  McuShell_SendHelpStr((unsigned char*)"  i2c", (unsigned char*)"Time register reads from the audio codec on the I2C bus\r\n", io->stdOut);
+#endif
+#if BENCH_CONFIG_USE_SPI
+  McuShell_SendHelpStr((unsigned char*)"  spi", (unsigned char*)"Time switching the SPI bus between the LCD and touch configuration\r\n", io->stdOut);
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+  McuShell_SendHelpStr((unsigned char*)"  compare", (unsigned char*)"Run all scenarios with both area join policies\r\n", io->stdOut);
+#endif
+  return ERR_OK;
+}
+
+uint8_t BENCH_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  const unsigned char *p;
+
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "bench help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "bench status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strncmp((char*)cmd, "bench run ", sizeof("bench run ")-1)==0) {
+    *handled = TRUE;
+    p = cmd+sizeof("bench run ")-1;
+    if (McuUtility_strcmp((char*)p, "all")==0) {
+      return Request(BENCH_REQUEST_ALL, NULL, io);
+    }
+    for(size_t i=0; i<sizeof(scenarios)/sizeof(scenarios[0]); i++) {
+      if (McuUtility_strcmp((char*)p, scenarios[i].name)==0) {
+        return Request(BENCH_REQUEST_SCENARIO, &scenarios[i], io);
+      }
+    }
+    McuShell_SendStr((unsigned char*)"unknown scenario\r\n", io->stdErr);
+    return ERR_FAILED;
+#if PL_CONFIG_USE_TOUCH_TRACE
+  } else if (McuUtility_strcmp((char*)cmd, "bench replay")==0) {
+    *handled = TRUE;
+    if (TouchTrace_GetNofEvents()==0 || TouchTrace_IsRecording()) {
+      McuShell_SendStr((unsigned char*)"no touch trace, or still recording\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    return Request(BENCH_REQUEST_REPLAY, NULL, io);
+#endif
+  } else if (McuUtility_strcmp((char*)cmd, "bench screen")==0) {
+    *handled = TRUE;
+    return Request(BENCH_REQUEST_SCREEN, NULL, io);
+#if PL_CONFIG_USE_EQ_CURVE
+  } else if (McuUtility_strcmp((char*)cmd, "bench curve")==0) {
+    *handled = TRUE;
+    return Request(BENCH_REQUEST_CURVE, NULL, io);
+#endif
+  } else if (McuUtility_strcmp((char*)cmd, "bench touch")==0) {
+    *handled = TRUE;
+    BENCH_RunTouchFilter(io); /* does not use LVGL, runs in the shell task */
+    return ERR_OK;
+#if PL_CONFIG_USE_SPECTRUM
+  } else if (McuUtility_strcmp((char*)cmd, "bench fft")==0) {
+    *handled = TRUE;
+    BENCH_RunFft(io); /* runs in the shell task */
+    return ERR_OK;
+#endif
+#if BENCH_CONFIG_USE_I2C
+  } else if (McuUtility_strcmp((char*)cmd, "bench i2c")==0) {
+    *handled = TRUE;
+    BENCH_RunI2C(io); /* runs in the shell task */
+    return ERR_OK;
+#endif
+#if BENCH_CONFIG_USE_SPI
+  } else if (McuUtility_strcmp((char*)cmd, "bench spi")==0) {
+    *handled = TRUE;
+    BENCH_RunSPI(io); /* runs in the shell task */
+    return ERR_OK;
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+  } else if (McuUtility_strcmp((char*)cmd, "bench compare")==0) {
+    *handled = TRUE;
+    return Request(BENCH_REQUEST_COMPARE, NULL, io);
+#endif
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_BENCH */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_BENCH
+#include "McuShell.h"
+#include "lv.h"
+
+#define BENCH_CONFIG_USE_I2C   (PL_CONFIG_USE_I2C) /* 'bench i2c': needs the codec on the board */
+#define BENCH_CONFIG_USE_SPI   (PL_CONFIG_USE_STMPE610) /* 'bench spi': needs the SPI hardware and a second bus configuration */
+
+#ifndef BENCH_CONFIG_SCREEN_MAX_OBJECTS
+  #define BENCH_CONFIG_SCREEN_MAX_OBJECTS    (32)
+#endif
+  /*!< 'bench screen' limit for the number of LVGL objects of the main screen */
+
+#ifndef BENCH_CONFIG_SCREEN_MAX_HEAP
+  #define BENCH_CONFIG_SCREEN_MAX_HEAP       (8*1024)
+#endif
+  /*!< 'bench screen' limit for the heap used by the main screen, in bytes */
+
+#ifndef BENCH_CONFIG_SCREEN_MAX_REDRAW_US
+  #define BENCH_CONFIG_SCREEN_MAX_REDRAW_US  (100000)
+#endif
+  /*!< 'bench screen' limit for render plus flush time of a full redraw of the main screen */
+
+uint8_t BENCH_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+
+/* runs all scenarios and writes the results to io. Has to be called from the task running LVGL */
+void BENCH_RunAll(const McuShell_StdIOType *io);
+
+#if LV_CONFIG_AREA_JOIN_COST
+/* runs all scenarios with the LVGL default area join and with the cost based one */
+void BENCH_CompareAreaJoin(const McuShell_StdIOType *io);
+#endif
+
+/* checks object count, heap and full redraw time of the main screen against the BENCH_CONFIG_SCREEN_* limits.
+ * Writes PASS or FAIL, so it can be used as check in a test script. Has to be called from the task running LVGL */
+uint8_t BENCH_RunScreen(const McuShell_StdIOType *io);
+
+#if PL_CONFIG_USE_TOUCH_TRACE
+/* replays the trace of TouchTrace.c through LVGL, starting on the main screen. Has to be called from the task running LVGL */
+void BENCH_RunReplay(const McuShell_StdIOType *io);
+#endif
+
+#if PL_CONFIG_USE_EQ_CURVE
+/* runs the EQ scenario and reports the evaluation time and invalidated pixels of the response curve.
+ * Has to be called from the task running LVGL */
+void BENCH_RunCurve(const McuShell_StdIOType *io);
+#endif
+
+/* runs generated touch traces (no recordings) through the filter in TouchFilter.c, reports jitter, position error, lag and cost per sample */
+void BENCH_RunTouchFilter(const McuShell_StdIOType *io);
+
+#if PL_CONFIG_USE_SPECTRUM
+/* times the analysis of one spectrum frame, the redraw budget is the 'spectrum' scenario */
+void BENCH_RunFft(const McuShell_StdIOType *io);
+#endif
+
+#if BENCH_CONFIG_USE_I2C
+/* reads a register of the audio codec, reports the time per read and how much of it the CPU was free for other tasks */
+void BENCH_RunI2C(const McuShell_StdIOType *io);
+#endif
+
+#if BENCH_CONFIG_USE_SPI
+/* toggles the SPI bus between the LCD and the touch configuration, with the SDK driver and with the precomputed registers */
+void BENCH_RunSPI(const McuShell_StdIOType *io);
+#endif
+
+/* to be called periodically from the GUI task: runs a benchmark requested with the shell */
+void BENCH_Process(void);
+#endif /* PL_CONFIG_USE_BENCH */
+
+#endif /* BENCH_H_ */
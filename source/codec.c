@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Register writer for the WM8904 audio codec: the GUI queues register writes without blocking, and a task writes them
+ * over I2C. The task keeps a shadow copy of the registers: requests for the same register collapse (the latest wins),
+ * writes which do not change the codec are skipped, and adjacent registers are written in one transaction using
+ * the register address auto-increment of the codec.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_CODEC
+#include "codec.h"
+#include "McuRTOS.h"
+#include "McuGenericI2C.h"
+#include "McuUtility.h"
+#include "leds.h"
+#include <string.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#define CODEC_NOF_SHADOW   (CODEC_REG_SHADOW_LAST-CODEC_REG_SHADOW_FIRST+1)
+
+typedef struct {
+  uint8_t reg;
+  uint16_t val;
+  TickType_t time; /* when the request has been queued */
+} CODEC_Request_t;
+
+static QueueHandle_t requestQueue;
+
+static struct {
+  uint16_t val[CODEC_NOF_SHADOW]; /* register values in the codec */
+  uint32_t valid; /* bit set: val[] is known */
+} shadow;
+
+static struct { /* only used by the codec task */
+  uint16_t val[CODEC_NOF_SHADOW];
+  TickType_t time[CODEC_NOF_SHADOW]; /* time of the oldest request merged */
+  uint32_t mask; /* bit set: a write is pending */
+} pending;
+
+static struct {
+  uint32_t nofRequests; /* accepted by CODEC_WriteRegister() */
+  uint32_t nofOverflows; /* rejected because the queue was full */
+  uint32_t nofCollapsed; /* replaced by a later request to the same register before being written */
+  uint32_t nofUnchanged; /* skipped because the codec has the value already */
+  uint32_t nofWritten; /* registers written */
+  uint32_t nofTransfers; /* I2C transactions */
+  uint32_t nofErrors; /* failed I2C transactions */
+  uint32_t maxDepth; /* maximum number of requests in the queue */
+  uint32_t latencySumMs, latencyMaxMs; /* from queuing the request until written */
+} stats;
+
+uint8_t CODEC_WriteRegister(uint8_t reg, uint16_t val) {
+  CODEC_Request_t req;
+  UBaseType_t depth;
+
+  if (reg<CODEC_REG_SHADOW_FIRST || reg>CODEC_REG_SHADOW_LAST) {
+    return ERR_RANGE;
+  }
+  req.reg = reg;
+  req.val = val;
+  req.time = xTaskGetTickCount();
+  if (xQueueSendToBack(requestQueue, &req, 0)!=pdPASS) {
+    stats.nofOverflows++;
+    return ERR_OVERFLOW;
+  }
+  stats.nofRequests++;
+  depth = uxQueueMessagesWaiting(requestQueue);
+  if (depth>stats.maxDepth) {
+    stats.maxDepth = depth;
+  }
+  return ERR_OK;
+}
+
+bool CODEC_GetRegister(uint8_t reg, uint16_t *val) {
+  int i = reg-CODEC_REG_SHADOW_FIRST;
+  bool valid;
+
+  if (reg<CODEC_REG_SHADOW_FIRST || reg>CODEC_REG_SHADOW_LAST) {
+    return false;
+  }
+  taskENTER_CRITICAL();
+  valid = (shadow.valid&(1u<<i))!=0;
+  *val = shadow.val[i];
+  taskEXIT_CRITICAL();
+  return valid;
+}
+
+static void CODEC_Merge(const CODEC_Request_t *req) {
+  int i = req->reg-CODEC_REG_SHADOW_FIRST;
+
+  if (pending.mask&(1u<<i)) {
+    stats.nofCollapsed++;
+  } else {
+    pending.time[i] = req->time;
+    pending.mask |= 1u<<i;
+  }
+  pending.val[i] = req->val; /* latest wins */
+}
+
+static void CODEC_Flush(void) {
+  uint8_t data[2*CODEC_NOF_SHADOW];
+  uint8_t reg, res;
+  int i, first, n;
+  uint32_t latency;
+
+  for(i=0; i<CODEC_NOF_SHADOW; i++) { /* drop the writes which do not change the codec */
+    if ((pending.mask&shadow.valid&(1u<<i)) && pending.val[i]==shadow.val[i]) {
+      pending.mask &= ~(1u<<i);
+      stats.nofUnchanged++;
+    }
+  }
+  i = 0;
+  while(i<CODEC_NOF_SHADOW) {
+    if (!(pending.mask&(1u<<i))) {
+      i++;
+      continue;
+    }
+    first = i; /* one transaction for a run of adjacent registers */
+    n = 0;
+    while(i<CODEC_NOF_SHADOW && (pending.mask&(1u<<i))) {
+      data[2*n] = pending.val[i]>>8; /* 16bit registers, MSB first */
+      data[2*n+1] = pending.val[i]&0xff;
+      n++;
+      i++;
+    }
+    reg = CODEC_REG_SHADOW_FIRST+first;
+    McuLED_On(LED_Blue);
+    res = McuGenericI2C_WriteAddress(CODEC_CONFIG_I2C_ADDR, &reg, sizeof(reg), data, 2*n);
+    McuLED_Off(LED_Blue);
+    stats.nofTransfers++;
+    if (res!=ERR_OK) {
+      stats.nofErrors++;
+    }
+    taskENTER_CRITICAL();
+    for(int j=first; j<first+n; j++) {
+      if (res==ERR_OK) {
+        shadow.val[j] = pending.val[j];
+        shadow.valid |= 1u<<j;
+      } else {
+        shadow.valid &= ~(1u<<j); /* state unknown: the next request gets written */
+      }
+    }
+    taskEXIT_CRITICAL();
+    for(int j=first; j<first+n; j++) {
+      pending.mask &= ~(1u<<j);
+      if (res==ERR_OK) {
+        latency = (xTaskGetTickCount()-pending.time[j])*portTICK_PERIOD_MS;
+        stats.nofWritten++;
+        stats.latencySumMs += latency;
+        if (latency>stats.latencyMaxMs) {
+          stats.latencyMaxMs = latency;
+        }
+      }
+    }
+  }
+}
+
+static void CODEC_ReadShadow(void) {
+  uint8_t reg, data[2];
+
+  for(int i=0; i<CODEC_NOF_SHADOW; i++) {
+    reg = CODEC_REG_SHADOW_FIRST+i;
+    if (McuGenericI2C_ReadAddress(CODEC_CONFIG_I2C_ADDR, &reg, sizeof(reg), data, sizeof(data))==ERR_OK) {
+      taskENTER_CRITICAL();
+      shadow.val[i] = (data[0]<<8)|data[1];
+      shadow.valid |= 1u<<i;
+      taskEXIT_CRITICAL();
+    }
+  }
+}
+
+static void CodecTask(void *pv) {
+  CODEC_Request_t req;
+
+  CODEC_ReadShadow(); /* registers which cannot be read are written on the first request */
+  for(;;) {
+    if (xQueueReceive(requestQueue, &req, portMAX_DELAY)==pdPASS) {
+      CODEC_Merge(&req);
+      vTaskDelay(pdMS_TO_TICKS(CODEC_CONFIG_COALESCE_MS)); /* collect the requests following the first one */
+      while(xQueueReceive(requestQueue, &req, 0)==pdPASS) {
+        CODEC_Merge(&req);
+      }
+      CODEC_Flush();
+    }
+  }
+}
+
+#if PL_CONFIG_USE_SHELL
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[64];
+  uint16_t val;
+
+  McuShell_SendStatusStr((unsigned char*)"codec", (unsigned char*)"\r\n", io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), uxQueueMessagesWaiting(requestQueue));
+  McuUtility_chcat(buf, sizeof(buf), '/');
+  McuUtility_strcatNum32u(buf, sizeof(buf), CODEC_CONFIG_QUEUE_LENGTH);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.maxDepth);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", overflows ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofOverflows);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  queue", buf, io->stdOut);
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), stats.nofRequests);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", written ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofWritten);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" in ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofTransfers);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" transfers, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofErrors);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" errors\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  requests", buf, io->stdOut);
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), stats.nofCollapsed+stats.nofUnchanged);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" (collapsed ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofCollapsed);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", unchanged ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofUnchanged);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  saved", buf, io->stdOut);
+
+  McuUtility_strcpy(buf, sizeof(buf), (unsigned char*)"avg ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.nofWritten==0 ? 0 : stats.latencySumMs/stats.nofWritten);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms, max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.latencyMaxMs);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  latency", buf, io->stdOut);
+
+  buf[0] = '\0';
+  for(uint8_t reg=CODEC_REG_SHADOW_FIRST; reg<=CODEC_REG_SHADOW_LAST; reg++) {
+    if (CODEC_GetRegister(reg, &val)) {
+      McuUtility_strcatNum16Hex(buf, sizeof(buf), val);
+    } else {
+      McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"????");
+    }
+    McuUtility_chcat(buf, sizeof(buf), ' ');
+  }
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  shadow", buf, io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"codec", (unsigned char*)"Group of audio codec register writer commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  write <reg> <val>", (unsigned char*)"Queue a write of a shadowed register, e.g. 'codec write 0x87 0x000C'\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Reset the statistics\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+uint8_t CODEC_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  const unsigned char *p;
+  uint8_t reg;
+  uint16_t val;
+
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "codec help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "codec status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+  } else if (McuUtility_strcmp((char*)cmd, "codec reset")==0) {
+    *handled = TRUE;
+    memset(&stats, 0, sizeof(stats));
+    return ERR_OK;
+  } else if (McuUtility_strncmp((char*)cmd, "codec write ", sizeof("codec write ")-1)==0) {
+    *handled = TRUE;
+    p = cmd+sizeof("codec write ")-1;
+    if (McuUtility_ScanHex8uNumber(&p, &reg)!=ERR_OK || McuUtility_ScanHex16uNumber(&p, &val)!=ERR_OK) {
+      McuShell_SendStr((unsigned char*)"wrong arguments\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    return CODEC_WriteRegister(reg, val);
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_SHELL */
+
+void CODEC_Deinit(void) {
+  /* task and queue are kept */
+}
+
+void CODEC_Init(void) {
+  requestQueue = xQueueCreate(CODEC_CONFIG_QUEUE_LENGTH, sizeof(CODEC_Request_t));
+  if (requestQueue==NULL) {
+    for(;;) {} /* out of memory? */
+  }
+  vQueueAddToRegistry(requestQueue, "CodecReq");
+  if (xTaskCreate(CodecTask, "Codec", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, NULL) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_USE_CODEC */
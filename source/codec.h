@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef CODEC_H_
+#define CODEC_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_CODEC
+#include <stdbool.h>
+#include <stdint.h>
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#ifndef CODEC_CONFIG_I2C_ADDR
+  #define CODEC_CONFIG_I2C_ADDR       (0x1A)
+#endif
+  /*!< 7bit I2C address of the WM8904 audio codec on the LPC55S69-EVK */
+
+#ifndef CODEC_CONFIG_QUEUE_LENGTH
+  #define CODEC_CONFIG_QUEUE_LENGTH   (16)
+#endif
+  /*!< number of register writes which can be queued for the codec task */
+
+#ifndef CODEC_CONFIG_COALESCE_MS
+  #define CODEC_CONFIG_COALESCE_MS    (10)
+#endif
+  /*!< time the codec task collects requests after the first one, so repeated writes to a register collapse into one */
+
+/* WM8904 registers with a shadow copy: EQ enable and the gains of the 5 bands */
+#define CODEC_REG_EQ1               (0x86) /* bit 0: EQ_ENA */
+#define CODEC_REG_EQ_GAIN(band)     (0x87+(band)) /* band 0..4: 0 is -12 dB, 1 dB per count */
+#define CODEC_REG_SHADOW_FIRST      CODEC_REG_EQ1
+#define CODEC_REG_SHADOW_LAST       CODEC_REG_EQ_GAIN(4)
+
+/* queues a write of a shadowed register for the codec task, does not block.
+ * Returns ERR_RANGE for a register without shadow and ERR_OVERFLOW if the queue is full */
+uint8_t CODEC_WriteRegister(uint8_t reg, uint16_t val);
+
+/* value of a shadowed register in the codec, false if not known (not read or written yet, or failed) */
+bool CODEC_GetRegister(uint8_t reg, uint16_t *val);
+
+#if PL_CONFIG_USE_SHELL
+  uint8_t CODEC_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
+
+void CODEC_Deinit(void);
+void CODEC_Init(void);
+
+#endif /* PL_CONFIG_USE_CODEC */
+
+#endif /* CODEC_H_ */
@@ -425,8 +425,19 @@ static void chart_create(lv_obj_t * parent)
 static void Btn_Exit_click_action(struct _lv_obj_t *obj, lv_event_t event) {
 	/* delete main menu window and all its objects */
   if(event == LV_EVENT_CLICKED) {
+    GUI_Demo_Delete();
+  }
+}
+
+/**
+ * Switch back to the main screen and delete the demo screen
+ */
+void GUI_Demo_Delete(void)
+{
+  if (demo_screen!=NULL) {
     GUI_SwitchToMainScreen(); /* switch back to main screen ... */
     lv_obj_del(demo_screen);  /* and delete current demo screen */
+    demo_screen = NULL;
   }
 }
 
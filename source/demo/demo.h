@@ -14,6 +14,7 @@ extern "C" {
  * Create a demo application
  */
 void GUI_Demo_Create(void);
+void GUI_Demo_Delete(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
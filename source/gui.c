@@ -20,9 +20,9 @@
 #include "McuILI9341.h"
 #include "McuFontDisplay.h"
 #include "Shell.h"
-#include <stdio.h>
 //#include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #if PL_CONFIG_USE_STMPE610
   #include "McuSTMPE610.h"
   #include "TouchCalibrate.h"
@@ -30,9 +30,70 @@
 #endif
 #include "sysmon.h"
 #include "demo/demo.h"
+#if PL_CONFIG_USE_BENCH
+  #include "bench.h"
+#endif
+#if PL_CONFIG_USE_GUI_TOUCH_NAV
+  #include "touch.h"
+#endif
+#if PL_CONFIG_USE_CODEC
+  #include "codec.h"
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  #include "EqDsp.h"
+#endif
+#if PL_CONFIG_USE_SPECTRUM
+  #include "SpectrumView.h"
+#endif
+#if PL_CONFIG_USE_EQ_CURVE
+  #include "EqCurve.h"
+#endif
+#if PL_CONFIG_USE_PRESET
+  #include "Preset.h"
+#endif
 
 static TaskHandle_t GUI_TaskHndl;
 static lv_obj_t *main_screen;
+/* EQ bands of the codec, left to right. Each band is one column with a button matrix of the gain steps */
+typedef struct {
+  const char *name; /* center frequency, shown below the column */
+  uint8_t reg; /* WM8904 register with the gain of the band */
+} GUI_EqBand_t;
+
+static const GUI_EqBand_t eqBands[] = {
+  {"100Hz", 0x87},
+  {"300Hz", 0x88},
+  {"875Hz", 0x89},
+  {"2,4kHz", 0x8A},
+  {"6,9kHz", 0x8B},
+};
+#define GUI_EQ_NOF_BANDS    (sizeof(eqBands)/sizeof(eqBands[0]))
+#define GUI_EQ_BAND_WIDTH   (48) /* width of a band column in pixels */
+#if PL_CONFIG_USE_EQ_CURVE
+  #define GUI_EQ_CURVE_HEIGHT  (60) /* response curve between the window header and the gain columns */
+#else
+  #define GUI_EQ_CURVE_HEIGHT  (0)
+#endif
+#define GUI_EQ_COLUMN_HEIGHT  (250-GUI_EQ_CURVE_HEIGHT) /* height of a gain column */
+
+/* gain steps of a band column, top to bottom: button index in the matrix */
+static const int8_t eqGainDb[] = {9, 6, 3, 0, -3, -6, -9};
+static const char *eqGainMap[] = {"+9dB", "\n", "+6dB", "\n", "+3dB", "\n", "0dB", "\n", "-3dB", "\n", "-6dB", "\n", "-9dB", ""};
+#define GUI_EQ_NOF_STEPS    (sizeof(eqGainDb)/sizeof(eqGainDb[0]))
+#define GUI_EQ_STEP_0DB     (3) /* selected at power-up without presets */
+#define GUI_EQ_GAIN_REG_VAL(db)  ((uint16_t)(12+(db))) /* WM8904 band gain: 0 is -12 dB, 1 dB per count */
+
+/* EQ control model: the user data of the button matrix of a band is its band index and the selected gain step,
+ * so an event resolves without searching and only the two buttons which change get updated */
+#define GUI_EQ_CTRL(band, step)   ((lv_obj_user_data_t)(((band)<<8)|(step)))
+#define GUI_EQ_CTRL_BAND(ctrl)    ((uint8_t)((ctrl)>>8))
+#define GUI_EQ_CTRL_STEP(ctrl)    ((uint8_t)((ctrl)&0xff))
+
+static lv_obj_t *eqBandBtnm[GUI_EQ_NOF_BANDS]; /* button matrix of each band, used by the gestures */
+static lv_obj_t *eqPowerBtn; /* EQ on/off in the window header */
+#if PL_CONFIG_USE_BENCH
+static size_t mainScreenHeapBytes; /* heap used to create the main screen */
+#endif
 
 #if 0
 /* task notification bits */
@@ -153,98 +214,216 @@ static void event_handler(lv_obj_t *obj, lv_event_t event) {
 }
 
 
-/* event handler for EQ buttons that set the gain for the corresponding band */
-static void set_gain(lv_obj_t *obj, lv_event_t event) {
+/* writes the gain of a band to the codec: only queued, the codec task does the I2C transfer */
+static void GUI_EqApplyGain(uint8_t band, uint8_t step) {
+#if PL_CONFIG_USE_CODEC
+  (void)CODEC_WriteRegister(eqBands[band].reg, GUI_EQ_GAIN_REG_VAL(eqGainDb[step]));
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  EqDsp_SetGain(band, eqGainDb[step]); /* same band order */
+#endif
+#if PL_CONFIG_USE_EQ_CURVE
+  GUI_EqCurve_Update();
+#endif
+#if PL_CONFIG_USE_PRESET
+  Preset_SetLiveGain(band, eqGainDb[step]);
+#endif
+}
 
-  if(event == LV_EVENT_CLICKED) {
-	  McuLED_On(LED_Blue);
+/* returns the selected gain step of a band */
+static uint8_t GUI_EqGetStep(int band) {
+  return GUI_EQ_CTRL_STEP(lv_obj_get_user_data(eqBandBtnm[band]));
+}
+
+/* selects a gain step of the band of a button matrix: only the previously and the newly selected button get updated */
+static void GUI_EqSelect(lv_obj_t *btnm, uint8_t step) {
+  lv_obj_user_data_t ctrl = lv_obj_get_user_data(btnm);
+  uint8_t band = GUI_EQ_CTRL_BAND(ctrl);
+  uint8_t prev = GUI_EQ_CTRL_STEP(ctrl);
+
+  if (step>=GUI_EQ_NOF_STEPS) {
+    return;
+  }
+  lv_btnm_set_btn_ctrl(btnm, step, LV_BTNM_CTRL_TGL_STATE); /* clicking the selected button has released it: keep it selected */
+  if (step==prev) {
+    return; /* no change */
+  }
+  lv_btnm_clear_btn_ctrl(btnm, prev, LV_BTNM_CTRL_TGL_STATE);
+  lv_obj_set_user_data(btnm, GUI_EQ_CTRL(band, step));
+  GUI_EqApplyGain(band, step);
+}
 
-	  lv_obj_t *parent = lv_obj_get_parent(obj);
-	  lv_obj_t *child = lv_obj_get_child(parent, NULL);
-    while (child != NULL)
-    {
-        lv_btn_set_state(child, LV_BTN_STATE_REL);
-    	child = lv_obj_get_child(parent, child);
+/* event handler for the EQ button matrix of a band, sets the gain for the band */
+static void set_gain(lv_obj_t *obj, lv_event_t event) {
+  if(event == LV_EVENT_VALUE_CHANGED) { /* sent on release (LV_BTNM_CTRL_CLICK_TRIG), after the toggle state has been updated */
+    GUI_EqSelect(obj, *(const uint32_t*)lv_event_get_data()); /* data is the button index, which is the gain step */
+  }
+}
+
+#if PL_CONFIG_USE_PRESET
+/* gain step closest to a gain */
+static uint8_t GUI_EqGainToStep(int8_t gainDb) {
+  uint8_t step = 0;
 
+  for(size_t i=1; i<GUI_EQ_NOF_STEPS; i++) {
+    if (abs(eqGainDb[i]-gainDb)<abs(eqGainDb[step]-gainDb)) {
+      step = (uint8_t)i;
     }
-    lv_btn_set_state(obj, LV_BTN_STATE_TGL_PR);
-    int v = gain_value(obj);
-    int b = band_coord(parent);
-    // Write the gain value in the specific register of EQ band
-    //TODO
-    //WM8904_WriteRegister((wm8904_handle_t *)((uint32_t)(codecHandle->codecDevHandle)), b , v);
-	  McuLED_Off(LED_Blue);
+  }
+  return step;
+}
+#endif
 
-	return 1;
+/* creates the band labels and gain columns of the EQ, the columns are centered on the parent.
+ * The gains are the ones restored by Preset_Init(), which has applied them to the codec and the EQ already */
+static void GUI_EqCreate(lv_obj_t *parent) {
+  uint8_t step = GUI_EQ_STEP_0DB;
+#if PL_CONFIG_USE_PRESET
+  Preset_Curve_t preset;
 
+  Preset_GetLive(&preset);
+#endif
+#if PL_CONFIG_USE_EQ_CURVE
+  lv_obj_t *curve = GUI_EqCurve_Create(parent, GUI_EQ_NOF_BANDS*GUI_EQ_BAND_WIDTH, GUI_EQ_CURVE_HEIGHT);
+
+  lv_obj_align(curve, NULL, LV_ALIGN_CENTER, 0, 10-250/2+GUI_EQ_CURVE_HEIGHT/2-2); /* on top of the columns */
+#endif
+  for(size_t i=0; i<GUI_EQ_NOF_BANDS; i++) {
+    lv_coord_t x = ((int)i-(int)GUI_EQ_NOF_BANDS/2)*GUI_EQ_BAND_WIDTH; /* offset of the column center */
+    lv_obj_t *obj;
+
+    obj = lv_label_create(parent, NULL);
+    lv_label_set_align(obj, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
+    lv_label_set_static_text(obj, eqBands[i].name); /* no copy of the text on the heap */
+    lv_obj_set_width(obj, GUI_EQ_BAND_WIDTH);
+    lv_obj_align(obj, NULL, LV_ALIGN_CENTER, x, 150);
+
+    obj = lv_btnm_create(parent, NULL);
+    lv_obj_set_size(obj, GUI_EQ_BAND_WIDTH-4, GUI_EQ_COLUMN_HEIGHT);
+    lv_btnm_set_map(obj, eqGainMap);
+    lv_btnm_set_btn_ctrl_all(obj, LV_BTNM_CTRL_TGL_ENABLE|LV_BTNM_CTRL_CLICK_TRIG|LV_BTNM_CTRL_NO_REPEAT);
+#if PL_CONFIG_USE_PRESET
+    step = GUI_EqGainToStep(preset.gainDb[i]);
+#endif
+    lv_btnm_set_btn_ctrl(obj, step, LV_BTNM_CTRL_TGL_STATE);
+    lv_obj_set_user_data(obj, GUI_EQ_CTRL(i, step));
+    lv_obj_align(obj, NULL, LV_ALIGN_CENTER, x, 10+GUI_EQ_CURVE_HEIGHT/2);
+    lv_obj_set_event_cb(obj, set_gain);
+    eqBandBtnm[i] = obj;
   }
 }
-/* Return the register address of the band by the EQ buttons container x display coord */
-int band_coord(lv_obj_t *obj) {
-    int16_t x = (int16_t) lv_obj_get_x(obj);
-    printf("x coord : %" "d" "/n", x);
-    if (x == 0)
-    	return 0x87; // Band 1 register address
-    else if (x==48)
-    	return 0x88; // Band 2
-    else if (x==96)
-    	return 0x89; //Band 3
-    else if (x==144)
-    	return 0x8A; //Band 4
-    else if (x==192)
-    	return 0x8B; //Band 5
+
+#if PL_CONFIG_USE_BENCH
+void GUI_GetMainScreenStats(GUI_ScreenStats_t *stats) {
+  stats->nofObjects = lv_obj_count_children_recursive(main_screen)+1; /* including the screen */
+  stats->heapBytes = mainScreenHeapBytes;
 }
+#endif
 
+#if PL_CONFIG_USE_SPECTRUM
+static void spectrum_btn_event(lv_obj_t *obj, lv_event_t event) {
+  if (event==LV_EVENT_CLICKED) {
+    GUI_Spectrum_Create();
+  }
+}
+#endif
+
+/* shows the EQ state with the power button and the LEDs */
+static void GUI_EqShowEnabled(bool enabled) {
+  if (enabled) {
+    lv_btn_set_state(eqPowerBtn, LV_BTN_STATE_TGL_PR);
+    McuLED_On(LED_Green);
+    McuLED_Off(LED_Red);
+  } else {
+    lv_btn_set_state(eqPowerBtn, LV_BTN_STATE_REL);
+    McuLED_On(LED_Red);
+    McuLED_Off(LED_Green);
+  }
+}
 
-/* Return the binary value of the gain for band registers by the EQ buttons labels */
-int gain_value(lv_obj_t *obj) {
-	lv_obj_t *label=lv_obj_get_child(obj, NULL);
-	char *gain = lv_label_get_text(label);
-    printf("%s \n", gain);
-
-	if (strcmp(gain, "-9dB")==0)
-		return 0x3;
-	else if (strcmp(gain, "-6dB")==0)
-		return 0x6;
-	else if (strcmp(gain, "-3dB")==0)
-		return 0x9;
-	else if (strcmp(gain, "+3dB")==0)
-		return 0xF;
-	else if (strcmp(gain, "+6dB")==0)
-		return 0x12;
-	else if (strcmp(gain, "+9dB")==0)
-		return 0x15;
-	else
-		return 0xC; //0dB
+/* turns the EQ on or off */
+static void GUI_EqSetEnabled(bool enabled) {
+  GUI_EqShowEnabled(enabled);
+#if PL_CONFIG_USE_CODEC
+  (void)CODEC_WriteRegister(CODEC_REG_EQ1, enabled ? 0x1 : 0x0); /* EQ on or off */
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  EqDsp_SetEnabled(enabled);
+#endif
+#if PL_CONFIG_USE_EQ_CURVE
+  GUI_EqCurve_Update(); /* flat while disabled */
+#endif
+#if PL_CONFIG_USE_PRESET
+  Preset_SetLiveEnabled(enabled);
+#endif
 }
 
 /* Power button handler that turn on and off the EQ */
 static void switch_btn(lv_obj_t *obj, lv_event_t event) {
-	  if(event == LV_EVENT_CLICKED) {
-		  if (lv_btn_get_state(obj)==LV_BTN_STATE_TGL_REL)
-		  {
-		    lv_btn_set_state(obj, LV_BTN_STATE_REL);
-		    McuLED_On(LED_Red);
-		    McuLED_Off(LED_Green);
-		    //TODO Turn off
-		    // WM8904_WriteRegister((wm8904_handle_t *)((uint32_t)(codecHandle->codecDevHandle)), 0x86 , 0x0);
-		}
-		  else
-		{
-		    lv_btn_set_state(obj, LV_BTN_STATE_TGL_PR);
-		    McuLED_On(LED_Green);
-		    McuLED_Off(LED_Red);
-		    // TODO Turn On
-		    //WM8904_WriteRegister((wm8904_handle_t *)((uint32_t)(codecHandle->codecDevHandle)), 0x86 , 0x1);
-		}
-		  //lv_obj_set_event_cb(obj, switch_btn);
-
-	  }
+  if(event == LV_EVENT_CLICKED) {
+    GUI_EqSetEnabled(lv_btn_get_state(obj)!=LV_BTN_STATE_TGL_REL); /* released after being on: off */
+  }
 }
 
+#if PL_CONFIG_USE_PRESET
+/* switches the EQ to a preset selected with Preset_Select(): only the bands which change get selected, each writes
+ * its gain to the codec and the EQ */
+static void GUI_EqApplyPreset(const Preset_Curve_t *curve) {
+  for(size_t i=0; i<GUI_EQ_NOF_BANDS; i++) {
+    uint8_t step = GUI_EqGainToStep(curve->gainDb[i]);
+
+    if (step!=GUI_EqGetStep(i)) {
+      GUI_EqSelect(eqBandBtnm[i], step);
+    }
+  }
+  if ((lv_btn_get_state(eqPowerBtn)==LV_BTN_STATE_TGL_PR)!=(curve->enabled!=0)) {
+    GUI_EqSetEnabled(curve->enabled!=0);
+  }
+}
+
+static void GUI_EqProcessPreset(void) {
+  Preset_Curve_t curve;
+
+  if (Preset_TakeSelected(&curve) && main_screen!=NULL) {
+    GUI_EqApplyPreset(&curve);
+  }
+}
+#endif
+
+
+#if TOUCH_CONFIG_USE_GESTURES
+/* moves the gain of all EQ bands by the number of steps, negative is up (more gain) */
+static void GUI_EqShiftAllBands(int steps) {
+  for(size_t i=0; i<GUI_EQ_NOF_BANDS; i++) {
+    int curr = GUI_EqGetStep(i);
+    int step = curr+steps; /* the steps are ordered from +9dB down to -9dB */
+
+    if (step<0) {
+      step = 0;
+    } else if (step>=(int)GUI_EQ_NOF_STEPS) {
+      step = GUI_EQ_NOF_STEPS-1;
+    }
+    if (step!=curr) {
+      GUI_EqSelect(eqBandBtnm[i], step);
+    }
+  }
+}
+
+static void GUI_OnTouchGesture(const TouchGesture_Event_t *event) {
+  if (event->gesture==TOUCHGESTURE_TWO_FINGER_DRAG && lv_scr_act()==main_screen) {
+    GUI_EqShiftAllBands(event->steps);
+  }
+}
+#endif
+
+void GUI_SwitchToMainScreen(void) {
+  lv_scr_load(main_screen);
+}
 
 void GUI_MainMenuCreate(void) {
-	lv_obj_t * label;
+#if PL_CONFIG_USE_BENCH && configSUPPORT_DYNAMIC_ALLOCATION && configUSE_HEAP_SCHEME!=3 /* wrapper to malloc() does not have xPortGetFreeHeapSize() */
+  size_t freeHeapSize = xPortGetFreeHeapSize();
+#endif
 
 #if PL_CONFIG_USE_GUI_KEY_NAV
   GUI_GroupPush();
@@ -252,6 +431,9 @@ void GUI_MainMenuCreate(void) {
 
   /* create main screen */
   main_screen = lv_obj_create(NULL, NULL);
+#if TOUCH_CONFIG_USE_GESTURES
+  TOUCH_SetGestureCallback(GUI_OnTouchGesture); /* two finger drag moves all EQ bands */
+#endif
   lv_scr_load(main_screen); /* load the screen */
 
   /* create window */
@@ -264,405 +446,28 @@ void GUI_MainMenuCreate(void) {
 
 
   /* Add control button to the header */
-  lv_obj_t *power_btn = lv_win_add_btn(gui_win, LV_SYMBOL_POWER);           /* Add close button and use built-in close action */
-  lv_obj_set_event_cb(power_btn, switch_btn);
-  McuLED_On(LED_Red);
-
-
-
-
-  // EQ buttons, container and labels
-
-  lv_obj_t * band_1_label = lv_label_create(lv_scr_act(), NULL);
-  lv_label_set_align(band_1_label, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
-  lv_label_set_text(band_1_label, "100Hz");
-  lv_obj_set_width(band_1_label, 48);
-  lv_obj_align(band_1_label, NULL, LV_ALIGN_CENTER, -96, 150);
-
-  lv_obj_t * band_2_label = lv_label_create(lv_scr_act(), NULL);
-  lv_label_set_align(band_2_label, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
-  lv_label_set_text(band_2_label, "300Hz");
-  lv_obj_set_width(band_2_label, 48);
-  lv_obj_align(band_2_label, NULL, LV_ALIGN_CENTER, -48, 150);
-
-  lv_obj_t * band_3_label = lv_label_create(lv_scr_act(), NULL);
-  lv_label_set_align(band_3_label, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
-  lv_label_set_text(band_3_label, "875Hz");
-  lv_obj_set_width(band_3_label, 48);
-  lv_obj_align(band_3_label, NULL, LV_ALIGN_CENTER, 0, 150);
-
-  lv_obj_t * band_4_label = lv_label_create(lv_scr_act(), NULL);
-  lv_label_set_align(band_4_label, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
-  lv_label_set_text(band_4_label, "2,4Hz");
-  lv_obj_set_width(band_4_label, 48);
-  lv_obj_align(band_4_label, NULL, LV_ALIGN_CENTER, 48, 150);
-
-  lv_obj_t * band_5_label = lv_label_create(lv_scr_act(), NULL);
-  lv_label_set_align(band_5_label, LV_LABEL_ALIGN_CENTER);       /*Center aligned lines*/
-  lv_label_set_text(band_5_label, "6,9kHz");
-  lv_obj_set_width(band_5_label, 48);
-  lv_obj_align(band_5_label, NULL, LV_ALIGN_CENTER, 96, 150);
-
-
-
-  lv_obj_t * band_1;
-
-  band_1 = lv_cont_create(lv_scr_act(), NULL);
-  lv_obj_set_auto_realign(band_1, true);                    /*Auto realign when the size changes*/
-  lv_obj_align_origo(band_1, NULL, LV_ALIGN_CENTER, 0, 0);  /*This parametrs will be sued when realigned*/
-  lv_cont_set_fit(band_1, LV_FIT_TIGHT);
-  lv_cont_set_layout(band_1, LV_LAYOUT_COL_M);
-  lv_obj_align(band_1, NULL, LV_ALIGN_CENTER, -96, 10);
-
-
-  lv_obj_t *b1m9 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1m9, set_gain);
-  lv_obj_align(b1m9, NULL, LV_ALIGN_CENTER, 0, 120);
-  lv_obj_set_width(b1m9, 44);
-  //lv_btn_set_toggle(b1m9, true);
-  //lv_btn_toggle(b1m9);
-
-
-  label = lv_label_create(b1m9, NULL);
-  lv_label_set_text(label, "+9dB");
-
-
-  lv_obj_t *b1m6 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1m6, set_gain);
-  lv_obj_align(b1m6, NULL, LV_ALIGN_CENTER, 0, 85);
-  lv_obj_set_width(b1m6, 44);
-
-  label = lv_label_create(b1m6, NULL);
-  lv_label_set_text(label, "+6dB");
-
-  lv_obj_t *b1m3 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1m3, set_gain);
-  lv_obj_align(b1m3, NULL, LV_ALIGN_CENTER, 0, 50);
-  lv_obj_set_width(b1m3, 44);
-
-  label = lv_label_create(b1m3, NULL);
-  lv_label_set_text(label, "+3dB");
-
-  lv_obj_t *b1p0 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1p0, set_gain);
-  lv_obj_align(b1p0, NULL, LV_ALIGN_CENTER, 0, 15);
-  lv_obj_set_width(b1p0, 44);
-  lv_btn_set_state(b1p0, LV_BTN_STATE_TGL_PR);
-
-
-  label = lv_label_create(b1p0, NULL);
-  lv_label_set_text(label, "0dB");
-
-  lv_obj_t *b1p3 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1p3, set_gain);
-  lv_obj_align(b1p3, NULL, LV_ALIGN_CENTER, 0, -20);
-  lv_obj_set_width(b1p3, 44);
-
-  label = lv_label_create(b1p3, NULL);
-  lv_label_set_text(label, "-3dB");
-
-  lv_obj_t *b1p6 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1p6, set_gain);
-  lv_obj_align(b1p6, NULL, LV_ALIGN_CENTER, 0, -55);
-  lv_obj_set_width(b1p6, 44);
-
-  label = lv_label_create(b1p6, NULL);
-  lv_label_set_text(label, "-6dB");
-
-  lv_obj_t *b1p9 = lv_btn_create(band_1, NULL);
-  lv_obj_set_event_cb(b1p9, set_gain);
-  lv_obj_align(b1p9, NULL, LV_ALIGN_CENTER, 0, -90);
-  lv_obj_set_width(b1p9, 44);
-
-  label = lv_label_create(b1p9, NULL);
-  lv_label_set_text(label, "-9dB");
-
-
-
-
-  lv_obj_t * band_2;
-
-  band_2 = lv_cont_create(lv_scr_act(), NULL);
-  lv_obj_set_auto_realign(band_2, true);                    /*Auto realign when the size changes*/
-  lv_obj_align_origo(band_2, NULL, LV_ALIGN_CENTER, 0, 0);  /*This parametrs will be sued when realigned*/
-  lv_cont_set_fit(band_2, LV_FIT_TIGHT);
-  lv_cont_set_layout(band_2, LV_LAYOUT_COL_M);
-  lv_obj_align(band_2, NULL, LV_ALIGN_CENTER, -48, 10);
-
-  lv_obj_t *b2m9 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2m9, set_gain);
-  lv_obj_align(b2m9, NULL, LV_ALIGN_CENTER, 0, 120);
-  lv_obj_set_width(b2m9, 44);
-
-  label = lv_label_create(b2m9, NULL);
-  lv_label_set_text(label, "+9dB");
-
-
-  lv_obj_t *b2m6 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2m6, set_gain);
-  lv_obj_align(b2m6, NULL, LV_ALIGN_CENTER, 0, 85);
-  lv_obj_set_width(b2m6, 44);
-
-  label = lv_label_create(b2m6, NULL);
-  lv_label_set_text(label, "+6dB");
-
-  lv_obj_t *b2m3 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2m3, set_gain);
-  lv_obj_align(b2m3, NULL, LV_ALIGN_CENTER, 0, 50);
-  lv_obj_set_width(b2m3, 44);
-
-  label = lv_label_create(b2m3, NULL);
-  lv_label_set_text(label, "+3dB");
-
-  lv_obj_t *b2p0 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2p0, set_gain);
-  lv_obj_align(b2p0, NULL, LV_ALIGN_CENTER, 0, 15);
-  lv_obj_set_width(b2p0, 44);
-  lv_btn_set_state(b2p0, LV_BTN_STATE_TGL_PR);
-
-
-  label = lv_label_create(b2p0, NULL);
-  lv_label_set_text(label, "0dB");
-
-  lv_obj_t *b2p3 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2p3, set_gain);
-  lv_obj_align(b2p3, NULL, LV_ALIGN_CENTER, 0, -20);
-  lv_obj_set_width(b2p3, 44);
-
-
-  label = lv_label_create(b2p3, NULL);
-  lv_label_set_text(label, "-3dB");
-
-  lv_obj_t *b2p6 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2p6, set_gain);
-  lv_obj_align(b2p6, NULL, LV_ALIGN_CENTER, 0, -55);
-  lv_obj_set_width(b2p6, 44);
-
-  label = lv_label_create(b2p6, NULL);
-  lv_label_set_text(label, "-6dB");
-
-  lv_obj_t *b2p9 = lv_btn_create(band_2, NULL);
-  lv_obj_set_event_cb(b2p9, set_gain);
-  lv_obj_align(b2p9, NULL, LV_ALIGN_CENTER, 0, -90);
-  lv_obj_set_width(b2p9, 44);
-
-  label = lv_label_create(b2p9, NULL);
-  lv_label_set_text(label, "-9dB");
-
-
-
-
-
-  lv_obj_t * band_3;
-
-  band_3 = lv_cont_create(lv_scr_act(), NULL);
-  lv_obj_set_auto_realign(band_3, true);                    /*Auto realign when the size changes*/
-  lv_obj_align_origo(band_3, NULL, LV_ALIGN_CENTER, 0, 0);  /*This parametrs will be sued when realigned*/
-  lv_cont_set_fit(band_3, LV_FIT_TIGHT);
-  lv_cont_set_layout(band_3, LV_LAYOUT_COL_M);
-  lv_obj_align(band_3, NULL, LV_ALIGN_CENTER, 0, 10);
-
-
-  lv_obj_t *b3m9 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3m9, set_gain);
-  lv_obj_align(b3m9, NULL, LV_ALIGN_CENTER, 0, 120);
-  lv_obj_set_width(b3m9, 44);
-
-  label = lv_label_create(b3m9, NULL);
-  lv_label_set_text(label, "+9dB");
-
-
-  lv_obj_t *b3m6 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3m6, set_gain);
-  lv_obj_align(b3m6, NULL, LV_ALIGN_CENTER, 0, 85);
-  lv_obj_set_width(b3m6, 44);
-
-  label = lv_label_create(b3m6, NULL);
-  lv_label_set_text(label, "+6dB");
-
-  lv_obj_t *b3m3 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3m3, set_gain);
-  lv_obj_align(b3m3, NULL, LV_ALIGN_CENTER, 0, 50);
-  lv_obj_set_width(b3m3, 44);
-
-  label = lv_label_create(b3m3, NULL);
-  lv_label_set_text(label, "+3dB");
-
-  lv_obj_t *b3p0 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3p0, set_gain);
-  lv_obj_align(b3p0, NULL, LV_ALIGN_CENTER, 0, 15);
-  lv_obj_set_width(b3p0, 44);
-  lv_btn_set_state(b3p0, LV_BTN_STATE_TGL_PR);
-
-
-  label = lv_label_create(b3p0, NULL);
-  lv_label_set_text(label, "0dB");
-
-  lv_obj_t *b3p3 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3p3, set_gain);
-  lv_obj_align(b3p3, NULL, LV_ALIGN_CENTER, 0, -20);
-  lv_obj_set_width(b3p3, 44);
-
-  label = lv_label_create(b3p3, NULL);
-  lv_label_set_text(label, "-3dB");
-
-  lv_obj_t *b3p6 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3p6, set_gain);
-  lv_obj_align(b3p6, NULL, LV_ALIGN_CENTER, 0, -55);
-  lv_obj_set_width(b3p6, 44);
-
-  label = lv_label_create(b3p6, NULL);
-  lv_label_set_text(label, "-6dB");
-
-  lv_obj_t *b3p9 = lv_btn_create(band_3, NULL);
-  lv_obj_set_event_cb(b3p9, set_gain);
-  lv_obj_align(b3p9, NULL, LV_ALIGN_CENTER, 0, -90);
-  lv_obj_set_width(b3p9, 44);
-
-  label = lv_label_create(b3p9, NULL);
-  lv_label_set_text(label, "-9dB");
-
-
-
-  lv_obj_t * band_4;
-
-  band_4 = lv_cont_create(lv_scr_act(), NULL);
-  lv_obj_set_auto_realign(band_4, true);                    /*Auto realign when the size changes*/
-  lv_obj_align_origo(band_4, NULL, LV_ALIGN_CENTER, 0, 0);  /*This parametrs will be sued when realigned*/
-  lv_cont_set_fit(band_4, LV_FIT_TIGHT);
-  lv_cont_set_layout(band_4, LV_LAYOUT_COL_M);
-  lv_obj_align(band_4, NULL, LV_ALIGN_CENTER, 48, 10);
-
-
-  lv_obj_t *b4m9 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4m9, set_gain);
-  lv_obj_align(b4m9, NULL, LV_ALIGN_CENTER, 0, 120);
-  lv_obj_set_width(b4m9, 44);
-
-  label = lv_label_create(b4m9, NULL);
-  lv_label_set_text(label, "+9dB");
-
-
-  lv_obj_t *b4m6 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4m6, set_gain);
-  lv_obj_align(b4m6, NULL, LV_ALIGN_CENTER, 0, 85);
-  lv_obj_set_width(b4m6, 44);
-
-  label = lv_label_create(b4m6, NULL);
-  lv_label_set_text(label, "+6dB");
-
-  lv_obj_t *b4m3 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4m3, set_gain);
-  lv_obj_align(b4m3, NULL, LV_ALIGN_CENTER, 0, 50);
-  lv_obj_set_width(b4m3, 44);
-
-  label = lv_label_create(b4m3, NULL);
-  lv_label_set_text(label, "+3dB");
-
-  lv_obj_t *b4p0 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4p0, set_gain);
-  lv_obj_align(b4p0, NULL, LV_ALIGN_CENTER, 0, 15);
-  lv_obj_set_width(b4p0, 44);
-  lv_btn_set_state(b4p0, LV_BTN_STATE_TGL_PR);
-
-
-  label = lv_label_create(b4p0, NULL);
-  lv_label_set_text(label, "0dB");
-
-  lv_obj_t *b4p3 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4p3, set_gain);
-  lv_obj_align(b4p3, NULL, LV_ALIGN_CENTER, 0, -20);
-  lv_obj_set_width(b4p3, 44);
-
-  label = lv_label_create(b4p3, NULL);
-  lv_label_set_text(label, "-3dB");
-
-  lv_obj_t *b4p6 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4p6, set_gain);
-  lv_obj_align(b4p6, NULL, LV_ALIGN_CENTER, 0, -55);
-  lv_obj_set_width(b4p6, 44);
-
-  label = lv_label_create(b4p6, NULL);
-  lv_label_set_text(label, "-6dB");
-
-  lv_obj_t *b4p9 = lv_btn_create(band_4, NULL);
-  lv_obj_set_event_cb(b4p9, set_gain);
-  lv_obj_align(b4p9, NULL, LV_ALIGN_CENTER, 0, -90);
-  lv_obj_set_width(b4p9, 44);
-
-  label = lv_label_create(b4p9, NULL);
-  lv_label_set_text(label, "-9dB");
-
-
-
-
-
-  lv_obj_t * band_5;
-
-  band_5 = lv_cont_create(lv_scr_act(), NULL);
-  lv_obj_set_auto_realign(band_5, true);                    /*Auto realign when the size changes*/
-  lv_obj_align_origo(band_5, NULL, LV_ALIGN_CENTER, 0, 0);  /*This parametrs will be sued when realigned*/
-  lv_cont_set_fit(band_5, LV_FIT_TIGHT);
-  lv_cont_set_layout(band_5, LV_LAYOUT_COL_M);
-  lv_obj_align(band_5, NULL, LV_ALIGN_CENTER, 96, 10);
-
-  lv_obj_t *b5m9 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5m9, set_gain);
-  lv_obj_align(b5m9, NULL, LV_ALIGN_CENTER,0, 120);
-  lv_obj_set_width(b5m9, 44);
-
-  label = lv_label_create(b5m9, NULL);
-  lv_label_set_text(label, "+9dB");
-
-
-  lv_obj_t *b5m6 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5m6, set_gain);
-  lv_obj_align(b5m6, NULL, LV_ALIGN_CENTER,0, 85);
-  lv_obj_set_width(b5m6, 44);
-
-  label = lv_label_create(b5m6, NULL);
-  lv_label_set_text(label, "+6dB");
-
-  lv_obj_t *b5m3 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5m3, set_gain);
-  lv_obj_align(b5m3, NULL, LV_ALIGN_CENTER,0, 50);
-  lv_obj_set_width(b5m3, 44);
-
-  label = lv_label_create(b5m3, NULL);
-  lv_label_set_text(label, "+3dB");
-
-  lv_obj_t *b5p0 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5p0, set_gain);
-  lv_obj_align(b5p0, NULL, LV_ALIGN_CENTER,0, 15);
-  lv_obj_set_width(b5p0, 44);
-  lv_btn_set_state(b5p0, LV_BTN_STATE_TGL_PR);
-
-  label = lv_label_create(b5p0, NULL);
-  lv_label_set_text(label, "0dB");
-
-  lv_obj_t *b5p3 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5p3, set_gain);
-  lv_obj_align(b5p3, NULL, LV_ALIGN_CENTER,0, -20);
-  lv_obj_set_width(b5p3, 44);
+  eqPowerBtn = lv_win_add_btn(gui_win, LV_SYMBOL_POWER);           /* Add close button and use built-in close action */
+  lv_obj_set_event_cb(eqPowerBtn, switch_btn);
+#if PL_CONFIG_USE_SPECTRUM
+  lv_obj_t *spectrum_btn = lv_win_add_btn(gui_win, LV_SYMBOL_AUDIO); /* opens the spectrum screen */
+  lv_obj_set_event_cb(spectrum_btn, spectrum_btn_event);
+#endif
+#if PL_CONFIG_USE_PRESET
+  Preset_Curve_t preset;
 
-  label = lv_label_create(b5p3, NULL);
-  lv_label_set_text(label, "-3dB");
+  Preset_GetLive(&preset);
+  GUI_EqShowEnabled(preset.enabled!=0); /* as restored at power-up */
+#else
+  GUI_EqShowEnabled(false);
+#endif
 
-  lv_obj_t *b5p6 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5p6, set_gain);
-  lv_obj_align(b5p6, NULL, LV_ALIGN_CENTER,0, -55);
-  lv_obj_set_width(b5p6, 44);
 
-  label = lv_label_create(b5p6, NULL);
-  lv_label_set_text(label, "-6dB");
 
-  lv_obj_t *b5p9 = lv_btn_create(band_5, NULL);
-  lv_obj_set_event_cb(b5p9, set_gain);
-  lv_obj_align(b5p9, NULL, LV_ALIGN_CENTER,0, -90);
-  lv_obj_set_width(b5p9, 44);
 
-  label = lv_label_create(b5p9, NULL);
-  lv_label_set_text(label, "-9dB");
+  GUI_EqCreate(main_screen);
+#if PL_CONFIG_USE_BENCH && configSUPPORT_DYNAMIC_ALLOCATION && configUSE_HEAP_SCHEME!=3
+  mainScreenHeapBytes = freeHeapSize-xPortGetFreeHeapSize();
+#endif
 
   /*
 
@@ -723,6 +528,11 @@ static void ErrMsg(void) {
   }
 }
 
+/* sleep until input arrives, something else wakes us up or the next LVGL task is due */
+static void GuiWaitNextTask(uint32_t msToNextTask) {
+  (void)LV_WaitNotify(msToNextTask==LV_NO_TASK_READY ? portMAX_DELAY : pdMS_TO_TICKS(msToNextTask));
+}
+
 static void GuiTask(void *p) {
   vTaskDelay(pdMS_TO_TICKS(500)); /* give hardware time to power up */
   if (McuILI9341_InitLCD()!=ERR_OK) {
@@ -737,23 +547,30 @@ static void GuiTask(void *p) {
     tpcal_create();
   }
   while(!TouchCalib_IsCalibrated()) {
-    LV_Task(); /* call this every 1-20 ms */
-    vTaskDelay(pdMS_TO_TICKS(10));
+    GuiWaitNextTask(LV_Task());
   }
 #endif
   GUI_MainMenuCreate();
   for(;;) {
-    LV_Task(); /* call this every 1-20 ms */
-    vTaskDelay(pdMS_TO_TICKS(10));
+    uint32_t msToNextTask = LV_Task();
+#if PL_CONFIG_USE_PRESET
+    GUI_EqProcessPreset(); /* preset selected with the shell */
+#endif
+#if PL_CONFIG_USE_BENCH
+    BENCH_Process(); /* runs a requested benchmark in the context of the GUI task */
+#endif
+    GuiWaitNextTask(msToNextTask);
   }
 }
 
+#if !LV_TICK_CUSTOM /* otherwise lv_tick_get() uses the RTOS tick count */
 #define APP_PERIODIC_TIMER_PERIOD_MS   10
 static TimerHandle_t timerHndl;
 
 static void vTimerGuiTickCallbackExpired(TimerHandle_t pxTimer) {
   lv_tick_inc(APP_PERIODIC_TIMER_PERIOD_MS);
 }
+#endif
 
 void GUI_Init(void) {
   LV_Init(); /* initialize GUI library */
@@ -774,6 +591,8 @@ void GUI_Init(void) {
   if (xTaskCreate(GuiTask, "Gui", 4000/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, &GUI_TaskHndl) != pdPASS) {
     for(;;){} /* error */
   }
+  LV_SetNotifyTask(GUI_TaskHndl); /* flush done and input events wake up the task */
+#if !LV_TICK_CUSTOM
   timerHndl = xTimerCreate(  /* timer to handle periodic things */
         "guiTick", /* name */
         pdMS_TO_TICKS(APP_PERIODIC_TIMER_PERIOD_MS), /* period/time */
@@ -786,6 +605,7 @@ void GUI_Init(void) {
   if (xTimerStart(timerHndl, 0)!=pdPASS) { /* start the timer */
     for(;;); /* failure!?! */
   }
+#endif
 #if PL_CONFIG_USE_GUI_KEY_NAV
   groups.sp = 0;
 #endif
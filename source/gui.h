@@ -24,12 +24,19 @@
 
 void GUI_SwitchToMainScreen(void);
 
-void GUI_ChangeOrientation(McuGDisplaySSD1306_DisplayOrientation orientation);
+void GUI_MainMenuCreate(void);
 
-void GUI_Init(void);
+#if PL_CONFIG_USE_BENCH
+typedef struct {
+  uint16_t nofObjects; /* number of LVGL objects, including the screen */
+  size_t heapBytes; /* heap used to create the screen, 0 if not available */
+} GUI_ScreenStats_t;
+
+void GUI_GetMainScreenStats(GUI_ScreenStats_t *stats);
+#endif
 
-static void btn_band_1(lv_obj_t *obj, lv_event_t event);
+void GUI_ChangeOrientation(McuGDisplaySSD1306_DisplayOrientation orientation);
 
-int gain_value(lv_obj_t *obj);
+void GUI_Init(void);
 
 #endif /* GUI_H_ */
@@ -13,6 +13,11 @@
 #include "McuGPIO.h"
 //#include "McuFXOS8700.h"
 #include "McuWait.h"
+#include "McuArmTools.h"
+#include <string.h>
+#if I2CLIB_CONFIG_USE_INTERRUPT
+  #include "McuRTOS.h"
+#endif
 #if McuLib_CONFIG_CPU_IS_KINETIS
   #include "fsl_port.h"
 #elif McuLib_CONFIG_CPU_IS_LPC
@@ -46,105 +51,114 @@
   #define I2C_MASTER_CLK_FREQ     CLOCK_GetFreq(I2C0_CLK_SRC)
 #elif McuLib_CONFIG_CPU_IS_LPC
   #define I2C_MASTER_BASEADDR     I2C4
-  #define I2C_MASTER_CLK_FREQ     12000000
+  #define I2C_MASTER_IRQ          FLEXCOMM4_IRQn
+  #define I2C_MASTER_CLK_FREQ     12000000 /* divides into exact 100 kHz, 400 kHz and 1 MHz SCL clocks */
 #endif
-#define I2C_BAUDRATE            400000U
-
-#define I2C_ADD_DELAY     (1)  /* needed for FXOS sensor? */
-#define I2C_ADD_DELAY_US  (10)
 
 static uint8_t i2cSlaveDeviceAddr;
+static bool stopPending = false; /* a transfer has left the bus without a stop condition */
 
-#if 0 /* not used */
-uint8_t I2CLIB_ReadAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize) {
-  i2c_master_transfer_t masterXfer;
-  status_t res;
-
-  memset(&masterXfer, 0, sizeof(masterXfer));
-  /* subAddress = memory address on device, data = data pointer.
-    start + slaveaddress(w) + subAddress + repeated start + slaveaddress(r) + rx data buffer + stop */
-  masterXfer.slaveAddress = i2cAddr;
-  masterXfer.direction = kI2C_Read;
-  masterXfer.subaddress = *memAddr;
-  masterXfer.subaddressSize = memAddrSize; /* assuming 1! */
-  masterXfer.data = data;
-  masterXfer.dataSize = dataSize;
-  masterXfer.flags = kI2C_TransferDefaultFlag;
-
-  res = I2C_MasterTransferBlocking(I2C_MASTER_BASEADDR, &masterXfer);
-  if (res!=kStatus_Success) {
-    return ERR_FAILED;
-  }
-  return ERR_OK;
+#if I2CLIB_CONFIG_USE_INTERRUPT
+static i2c_master_handle_t i2cHandle;
+static SemaphoreHandle_t transferDone; /* given by the transfer callback */
+static volatile status_t transferStatus;
+static I2CLIB_Stats_t stats;
+
+void I2CLIB_GetStats(I2CLIB_Stats_t *statistics) {
+  *statistics = stats;
 }
 
-uint8_t I2CLIB_WriteAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize) {
-  i2c_master_transfer_t masterXfer;
-  status_t res;
-
-  memset(&masterXfer, 0, sizeof(masterXfer));
-  /* subAddress = memory address in device, data = data pointer.
-    start + slaveaddress(w) + subAddress + length of data buffer + data buffer + stop*/
-  masterXfer.slaveAddress = i2cAddr;
-  masterXfer.direction = kI2C_Write;
-  masterXfer.subaddress = *memAddr;
-  masterXfer.subaddressSize = memAddrSize;
-  masterXfer.data = data;
-  masterXfer.dataSize = dataSize;
-  masterXfer.flags = kI2C_TransferDefaultFlag;
-
-  res = I2C_MasterTransferBlocking(I2C_MASTER_BASEADDR, &masterXfer);
-  if (res!=kStatus_Success) {
-    return ERR_FAILED;
-  }
-  return ERR_OK;
+void I2CLIB_ResetStats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+static void I2CLIB_TransferCallback(I2C_Type *base, i2c_master_handle_t *handle, status_t status, void *userData) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  (void)base; /* not used */
+  (void)handle; /* not used */
+  (void)userData; /* not used */
+  transferStatus = status;
+  (void)xSemaphoreGiveFromISR(transferDone, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 #endif
 
-uint8_t I2CLIB_SendBlock(void *Ptr, uint16_t Siz, uint16_t *Snt) {
+/* Runs a transfer: with the scheduler running, the calling task blocks until the transfer interrupt reports completion.
+ * Before the scheduler is started (device initialization in PL_Init()) the transfer is polled. */
+static uint8_t I2CLIB_Transfer(i2c_master_transfer_t *xfer) {
   status_t status;
 
-#if McuLib_CONFIG_CPU_IS_KINETIS
-  I2C_MasterClearStatusFlags(I2C_MASTER_BASEADDR, kI2C_ArbitrationLostFlag | kI2C_IntPendingFlag | kI2C_StartDetectFlag | kI2C_StopDetectFlag);
-#elif McuLib_CONFIG_CPU_IS_LPC
-  I2C_MasterClearStatusFlags(I2C_MASTER_BASEADDR,  kI2C_MasterPendingFlag | kI2C_MasterArbitrationLostFlag | kI2C_MasterStartStopErrorFlag);
-#endif
-  status = I2C_MasterStart(I2C_MASTER_BASEADDR, i2cSlaveDeviceAddr, kI2C_Write);
-  if (status!=kStatus_Success) {
-    return ERR_FAILED;
-  }
-#if I2C_ADD_DELAY
-  McuWait_Waitus(I2C_ADD_DELAY_US);
+#if I2CLIB_CONFIG_USE_INTERRUPT
+  if (xTaskGetSchedulerState()==taskSCHEDULER_RUNNING) {
+    uint32_t start = McuArmTools_GetCycleCounter();
+
+    status = I2C_MasterTransferNonBlocking(I2C_MASTER_BASEADDR, &i2cHandle, xfer);
+    if (status!=kStatus_Success) {
+      stats.nofErrors++;
+      return ERR_FAILED;
+    }
+    if (xSemaphoreTake(transferDone, pdMS_TO_TICKS(I2CLIB_CONFIG_TIMEOUT_MS))!=pdTRUE) {
+      I2C_MasterTransferAbort(I2C_MASTER_BASEADDR, &i2cHandle);
+      (void)xSemaphoreTake(transferDone, 0); /* in case it has completed in the meantime */
+      stats.nofErrors++;
+      return ERR_FAILED;
+    }
+    stats.nofTransfers++;
+    stats.blockedCycles += McuArmTools_GetCycleCounter()-start;
+    status = transferStatus;
+    if (status!=kStatus_Success) {
+      stats.nofErrors++;
+    }
+  } else
 #endif
-  status = I2C_MasterWriteBlocking(I2C_MASTER_BASEADDR, Ptr, Siz, kI2C_TransferNoStartFlag|kI2C_TransferNoStopFlag);
-  if (status!=kStatus_Success) {
-    return ERR_FAILED;
+  {
+    status = I2C_MasterTransferBlocking(I2C_MASTER_BASEADDR, xfer);
   }
-  *Snt = Siz;
-  return ERR_OK;
+  return status==kStatus_Success ? ERR_OK : ERR_FAILED;
 }
 
-uint8_t I2CLIB_RecvBlock(void *Ptr, uint16_t Siz, uint16_t *Rcv) {
-  status_t status;
+uint8_t I2CLIB_SendBlock(void *Ptr, uint16_t Siz, uint16_t *Snt) {
+  i2c_master_transfer_t xfer;
+  uint8_t res;
+
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.slaveAddress = i2cSlaveDeviceAddr;
+  xfer.direction = kI2C_Write;
+  xfer.data = Ptr;
+  xfer.dataSize = Siz;
+  /* no stop: McuGenericI2C either reads with a repeated start or calls I2CLIB_SendStop() */
+  xfer.flags = kI2C_TransferNoStopFlag|(stopPending ? kI2C_TransferRepeatedStartFlag : 0);
+  res = I2CLIB_Transfer(&xfer);
+  stopPending = res==ERR_OK; /* on a NAK the driver has already sent the stop */
+  *Snt = res==ERR_OK ? Siz : 0;
+  return res;
+}
 
-  status = I2C_MasterRepeatedStart(I2C_MASTER_BASEADDR, i2cSlaveDeviceAddr, kI2C_Read);
-  if (status!=kStatus_Success) {
-    return ERR_FAILED;
-  }
-#if I2C_ADD_DELAY
-  McuWait_Waitus(I2C_ADD_DELAY_US);
-#endif
-  status = I2C_MasterReadBlocking(I2C_MASTER_BASEADDR, Ptr, Siz, kI2C_TransferDefaultFlag);
-  if (status!=kStatus_Success) {
-    return ERR_FAILED;
-  }
-  *Rcv = Siz;
-  return ERR_OK;
+uint8_t I2CLIB_RecvBlock(void *Ptr, uint16_t Siz, uint16_t *Rcv) {
+  i2c_master_transfer_t xfer;
+  uint8_t res;
+
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.slaveAddress = i2cSlaveDeviceAddr;
+  xfer.direction = kI2C_Read;
+  xfer.data = Ptr;
+  xfer.dataSize = Siz;
+  /* ends with the stop condition: it NACKs the last byte, the following I2CLIB_SendStop() has nothing to do */
+  xfer.flags = stopPending ? kI2C_TransferRepeatedStartFlag : kI2C_TransferDefaultFlag;
+  res = I2CLIB_Transfer(&xfer);
+  stopPending = false;
+  *Rcv = res==ERR_OK ? Siz : 0;
+  return res;
 }
 
 uint8_t I2CLIB_SendStop(void) {
   status_t status;
 
+  if (!stopPending) {
+    return ERR_OK; /* already sent with the transfer */
+  }
+  stopPending = false;
   status = I2C_MasterStop(I2C_MASTER_BASEADDR);
   if (status!=kStatus_Success) {
     return ERR_FAILED;
@@ -178,7 +192,7 @@ static void I2CLIB_ReleaseBus(void) {
 
   McuGPIO_GetDefaultConfig(&config);
   config.isInput = false;
-  config.isLowOnInit = false;
+  config.isHighOnInit = true;
   config.hw.gpio = I2CLIB_SDA_GPIO;
   config.hw.pin = I2CLIB_SDA_GPIO_PIN;
   config.hw.port = I2CLIB_SDA_GPIO_PORT;
@@ -303,8 +317,17 @@ void I2CLIB_Init(void) {
    * masterConfig->enableMaster = true;
    */
   I2C_MasterGetDefaultConfig(&masterConfig);
-  masterConfig.baudRate_Bps = I2C_BAUDRATE;
+  masterConfig.baudRate_Bps = I2CLIB_CONFIG_BAUDRATE;
   sourceClock = I2C_MASTER_CLK_FREQ;
   I2C_MasterInit(I2C_MASTER_BASEADDR, &masterConfig, sourceClock);
+#if I2CLIB_CONFIG_USE_INTERRUPT
+  transferDone = xSemaphoreCreateBinary();
+  if (transferDone==NULL) {
+    for(;;) { /* out of memory? */ }
+  }
+  vQueueAddToRegistry(transferDone, "I2cDone");
+  I2C_MasterTransferCreateHandle(I2C_MASTER_BASEADDR, &i2cHandle, I2CLIB_TransferCallback, NULL); /* enables the interrupt */
+  NVIC_SetPriority(I2C_MASTER_IRQ, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY); /* callback uses the RTOS */
+#endif
 }
 #endif /* PL_CONFIG_USE_HW_I2C */
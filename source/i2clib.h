@@ -8,6 +8,22 @@
 #define I2CLIB_H_
 
 #include <stdint.h>
+#include "McuLib.h"
+
+#ifndef I2CLIB_CONFIG_BAUDRATE
+  #define I2CLIB_CONFIG_BAUDRATE        (400000U)
+#endif
+  /*!< SCL clock in Hz: 100000 (standard mode), 400000 (fast mode) or 1000000 (fast mode plus, needs strong pull-ups on the bus) */
+
+#ifndef I2CLIB_CONFIG_USE_INTERRUPT
+  #define I2CLIB_CONFIG_USE_INTERRUPT   (1 && McuLib_CONFIG_SDK_USE_FREERTOS)
+#endif
+  /*!< 1: the calling task blocks on a semaphore while the transfer runs in the interrupt, other tasks can run. 0: transfers are polled */
+
+#ifndef I2CLIB_CONFIG_TIMEOUT_MS
+  #define I2CLIB_CONFIG_TIMEOUT_MS      (20)
+#endif
+  /*!< maximum time for a single transfer, e.g. if a device is stretching the clock */
 
 typedef enum I2CLIB_EnumStartFlags_ {
   I2CLIB_SEND_START,        /* Start is sent */
@@ -30,6 +46,17 @@ uint8_t I2CLIB_SelectSlave(uint8_t Slv);
 uint8_t I2CLIB_ReadAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize);
 uint8_t I2CLIB_WriteAddress(uint8_t i2cAddr, uint8_t *memAddr, uint8_t memAddrSize, uint8_t *data, uint16_t dataSize);
 
+#if I2CLIB_CONFIG_USE_INTERRUPT
+typedef struct {
+  uint32_t nofTransfers; /* completed transfers */
+  uint32_t nofErrors; /* NAK, arbitration lost or timeout */
+  uint32_t blockedCycles; /* CPU cycles the calling tasks were blocked in transfers, available to other tasks */
+} I2CLIB_Stats_t;
+
+void I2CLIB_GetStats(I2CLIB_Stats_t *statistics);
+void I2CLIB_ResetStats(void);
+#endif
+
 void I2CLIB_Init(void);
 
 #endif /* I2CLIB_H_ */
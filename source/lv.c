@@ -9,10 +9,14 @@
 #include "lv.h"
 #include "LittlevGL/lvgl/lvgl.h"
 #include "McuILI9341.h"
+#include "McuSPI.h"
 #include "McuRB.h"
 #include <string.h> /* for memset() */
 #include "McuShell.h"
 #include "McuRTOS.h"
+#include "McuUtility.h"
+#include "McuArmTools.h"
+#include "fsl_device_registers.h" /* __get_IPSR() */
 #include "lcd.h"
 #include "McuShell.h"
 #if PL_CONFIG_USE_GUI_TOUCH_NAV
@@ -21,6 +25,13 @@
 #if PL_CONFIG_USE_TOASTER
   #include "toaster.h"
 #endif
+#if PL_CONFIG_USE_TOUCH_TRACE
+  #include "TouchTrace.h"
+#endif
+
+#if LV_COLOR_16_SWAP==MCUILI9341_CONFIG_PIXEL_FRAME16
+  #error "LVGL buffer byte order does not match the ILI9341 pixel transport, check LV_CONFIG_COLOR_16_SWAP"
+#endif
 
 #if PL_CONFIG_USE_GUI_SCREEN_SAVER
   static TimerHandle_t timerHndlLcdTimeout;
@@ -64,20 +75,297 @@ static void KeyPressForLCD(void) {
 
 static lv_indev_t *inputDevicePtr = NULL;
 
+static TaskHandle_t notifyTask; /* task running LV_Task(), gets woken up with task notifications */
+static uint32_t notifyPending; /* notifications received while waiting for the flushing */
+
+void LV_SetNotifyTask(TaskHandle_t task) {
+  notifyTask = task;
+}
+
+void LV_Notify(uint32_t events) {
+  if (notifyTask==NULL) {
+    return;
+  }
+  if (__get_IPSR()!=0) { /* called from an interrupt */
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    (void)xTaskNotifyFromISR(notifyTask, events, eSetBits, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    return;
+  }
+  (void)xTaskNotify(notifyTask, events, eSetBits);
+}
+
+#if PL_CONFIG_USE_GUI_TOUCH_NAV && TOUCH_CONFIG_USE_INTERRUPT
+/* the input device read task is stopped while the pen is up, see ex_tp_read() */
+static void LV_ResumeInputRead(void) {
+  if (inputDevicePtr!=NULL && inputDevicePtr->driver.read_task->prio==LV_TASK_PRIO_OFF) {
+    lv_task_set_prio(inputDevicePtr->driver.read_task, LV_TASK_PRIO_MID);
+    lv_task_ready(inputDevicePtr->driver.read_task);
+  }
+}
+#endif
+
+uint32_t LV_WaitNotify(TickType_t timeout) {
+  uint32_t events = 0;
+
+  if (notifyPending==0) {
+    /* a flush done notification is only of interest while LVGL waits for it, see ex_wait_cb() */
+    (void)xTaskNotifyWait(LV_NOTIFY_FLUSH_DONE, UINT32_MAX, &events, timeout);
+  }
+  events |= notifyPending;
+  notifyPending = 0;
+#if PL_CONFIG_USE_GUI_TOUCH_NAV && TOUCH_CONFIG_USE_INTERRUPT
+  if (events&LV_NOTIFY_INPUT) {
+    LV_ResumeInputRead(); /* touch controller has new data */
+  }
+#endif
+  return events;
+}
+
 lv_indev_t * LV_GetInputDevice(void) {
   return inputDevicePtr;
 }
 
+#if LV_CONFIG_USE_FRAME_STATS
+uint32_t LV_GetTimestamp(void) {
+  return McuArmTools_GetCycleCounter();
+}
+
+uint32_t LV_TimestampToUs(uint32_t ts) {
+  return ts/(configCPU_CLOCK_HZ/1000000U);
+}
+
+/* Frame timing, in LV_GetTimestamp() units:
+ * render: time spent in the LVGL refresh task, without the time waiting for the flushing
+ * flush:  sum of the time the display transfers have been active for the frame
+ * wait:   time the refresh task was blocked waiting for a transfer to finish
+ * With overlapping render and flush, render+wait is the frame time. */
+static LV_FrameStats_t frameStats;
+static LV_FrameHookCallback frameHook;
+
+#define LV_FLUSH_WINDOW_BYTES  (11) /* CASET, PASET and RAMWR with their arguments */
+
+static struct {
+  uint32_t start; /* start of the refresh task */
+  uint32_t wait; /* time waited for the flushing inside the refresh task */
+  uint16_t nofAreas; /* number of invalidated areas at the start of the refresh */
+  uint32_t flushStart; /* start of the ongoing flush */
+  uint32_t flushPx; /* number of pixels of the ongoing flush */
+  LV_FrameSample_t sample; /* frame being flushed */
+  bool ended; /* frame has been rendered, waiting for the last flush to finish */
+} frameCurr;
+
+#if LV_CONFIG_AREA_JOIN_COST
+/* The invalidated areas get joined based on what a flush costs on the wire: time = flush_cost + px*px_cost.
+ * Both are fitted (least squares) over the measured flushes and handed to LVGL every LV_JOIN_FIT_NOF_FLUSHES flushes. */
+#define LV_JOIN_FIT_NOF_FLUSHES  (64)
+
+static struct {
+  bool enabled; /* use the cost model for joining, otherwise LVGL joins overlapping areas only */
+  uint32_t flushCost, pxCost; /* last fit, in LV_GetTimestamp() units */
+  uint32_t n; /* number of flushes in the sums */
+  uint64_t sumX, sumY, sumXX, sumXY; /* x: pixels, y: flush time */
+} joinCost;
+
+static void LV_JoinCostAdd(uint32_t px, uint32_t time) {
+  /* called from the DMA interrupt at the end of a flush */
+  if (joinCost.n>=LV_JOIN_FIT_NOF_FLUSHES) {
+    return; /* not consumed yet */
+  }
+  joinCost.n++;
+  joinCost.sumX += px;
+  joinCost.sumY += time;
+  joinCost.sumXX += (uint64_t)px*px;
+  joinCost.sumXY += (uint64_t)px*time;
+}
+
+static void LV_JoinCostUpdate(lv_disp_drv_t *disp_drv) {
+  /* called with interrupts masked at the end of a refresh cycle */
+  int64_t n, num, den, slope, intercept;
+
+  if (joinCost.n<LV_JOIN_FIT_NOF_FLUSHES) {
+    return; /* not enough flushes yet */
+  }
+  n = joinCost.n;
+  den = n*(int64_t)joinCost.sumXX-(int64_t)joinCost.sumX*(int64_t)joinCost.sumX;
+  num = n*(int64_t)joinCost.sumXY-(int64_t)joinCost.sumX*(int64_t)joinCost.sumY;
+  if (den>0 && num>0) { /* otherwise all flushes had the same size: keep the previous fit */
+    slope = num/den;
+    intercept = ((int64_t)joinCost.sumY-slope*(int64_t)joinCost.sumX)/n;
+    joinCost.pxCost = (uint32_t)slope;
+    joinCost.flushCost = intercept>0?(uint32_t)intercept:0;
+  }
+  joinCost.n = 0;
+  joinCost.sumX = joinCost.sumY = joinCost.sumXX = joinCost.sumXY = 0;
+  disp_drv->flush_cost = joinCost.enabled?joinCost.flushCost:0;
+  disp_drv->px_cost = joinCost.enabled?joinCost.pxCost:0;
+}
+
+void LV_SetAreaJoinCost(bool enable) {
+  lv_disp_t *disp = lv_disp_get_default();
+
+  taskENTER_CRITICAL();
+  joinCost.enabled = enable;
+  if (disp!=NULL) {
+    disp->driver.flush_cost = enable?joinCost.flushCost:0;
+    disp->driver.px_cost = enable?joinCost.pxCost:0;
+  }
+  taskEXIT_CRITICAL();
+}
+
+bool LV_GetAreaJoinCost(uint32_t *flushCost, uint32_t *pxCost) {
+  taskENTER_CRITICAL();
+  *flushCost = joinCost.flushCost;
+  *pxCost = joinCost.pxCost;
+  taskEXIT_CRITICAL();
+  return joinCost.enabled;
+}
+#endif /* LV_CONFIG_AREA_JOIN_COST */
+
+static void LV_FrameStatsFlushStart(const lv_area_t *area) {
+  frameCurr.sample.nofFlushes++;
+  frameCurr.sample.nofBytes += LV_FLUSH_WINDOW_BYTES+lv_area_get_size(area)*sizeof(lv_color_t);
+  frameCurr.flushPx = lv_area_get_size(area);
+  frameCurr.flushStart = LV_GetTimestamp();
+}
+
+static void LV_FrameStatsFinish(void) {
+  /* called with interrupts masked, after the last flush of the frame has finished */
+  LV_FrameSample_t *sample = &frameCurr.sample;
+
+  frameStats.nofFrames++;
+  frameStats.last = *sample;
+  if (sample->render>frameStats.renderMax) {
+    frameStats.renderMax = sample->render;
+  }
+  if (sample->flush>frameStats.flushMax) {
+    frameStats.flushMax = sample->flush;
+  }
+  if (sample->wait>frameStats.waitMax) {
+    frameStats.waitMax = sample->wait;
+  }
+  frameStats.renderSum += sample->render;
+  frameStats.flushSum += sample->flush;
+  frameStats.waitSum += sample->wait;
+  if (frameHook!=NULL) {
+    frameHook(sample);
+  }
+  memset(sample, 0, sizeof(*sample));
+  frameCurr.ended = false;
+}
+
+static void ex_refr_task(lv_task_t *task) {
+  /* wraps the LVGL display refresh task, to measure the frame */
+  lv_disp_t *disp = (lv_disp_t*)task->user_data;
+
+  frameCurr.nofAreas = disp->inv_p; /* before they get joined */
+  frameCurr.wait = 0;
+  frameCurr.start = LV_GetTimestamp();
+  lv_disp_refr_task(task);
+}
+
+static void ex_monitor_cb(struct _disp_drv_t * disp_drv, uint32_t time, uint32_t px) {
+  /* called by LVGL at the end of a refresh cycle */
+  (void)time; /* only has tick resolution, we use our own time stamps */
+  taskENTER_CRITICAL();
+  frameCurr.sample.render = (LV_GetTimestamp()-frameCurr.start)-frameCurr.wait;
+  frameCurr.sample.wait = frameCurr.wait;
+  frameCurr.sample.px = px;
+  frameCurr.sample.nofAreas = frameCurr.nofAreas;
+  frameCurr.ended = true;
+  if (!disp_drv->buffer->flushing) { /* last flush is already done */
+    LV_FrameStatsFinish();
+  }
+#if LV_CONFIG_AREA_JOIN_COST
+  LV_JoinCostUpdate(disp_drv);
+#endif
+  taskEXIT_CRITICAL();
+}
+
+void LV_SetFrameHook(LV_FrameHookCallback hook) {
+  taskENTER_CRITICAL();
+  frameHook = hook;
+  taskEXIT_CRITICAL();
+}
+
+void LV_GetFrameStats(LV_FrameStats_t *stats) {
+  taskENTER_CRITICAL();
+  *stats = frameStats;
+  taskEXIT_CRITICAL();
+}
+
+void LV_ResetFrameStats(void) {
+  taskENTER_CRITICAL();
+  memset(&frameStats, 0, sizeof(frameStats));
+  taskEXIT_CRITICAL();
+}
+#endif /* LV_CONFIG_USE_FRAME_STATS */
+
+static void ex_disp_flush_done(void *param) {
+#if LV_CONFIG_USE_FRAME_STATS
+  uint32_t time = LV_GetTimestamp()-frameCurr.flushStart;
+
+  frameCurr.sample.flush += time;
+#if LV_CONFIG_AREA_JOIN_COST
+  LV_JoinCostAdd(frameCurr.flushPx, time);
+#endif
+  if (frameCurr.ended) { /* this has been the last flush of the frame */
+    LV_FrameStatsFinish();
+  }
+#endif
+  /* IMPORTANT!!!
+   * Inform the graphics library that you are ready with the flushing. Called from the DMA interrupt */
+  lv_disp_flush_ready((lv_disp_drv_t*)param);
+  LV_Notify(LV_NOTIFY_FLUSH_DONE); /* in case LVGL is waiting for it */
+}
+
+#define LV_FLUSH_WAIT_TIMEOUT_MS  (10) /* only a safety net, the flush done notification ends the wait */
+
+static void ex_wait_cb(struct _disp_drv_t * disp_drv) {
+  /* called by LVGL while waiting for the flushing to be finished: block instead of polling the flag */
+  uint32_t events;
+#if LV_CONFIG_USE_FRAME_STATS
+  uint32_t start = LV_GetTimestamp();
+#endif
+
+  while(disp_drv->buffer->flushing) {
+    if (notifyTask!=NULL && xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(LV_FLUSH_WAIT_TIMEOUT_MS))==pdTRUE) {
+      notifyPending |= events&~LV_NOTIFY_FLUSH_DONE; /* keep the others for LV_WaitNotify() */
+    }
+  }
+#if LV_CONFIG_USE_FRAME_STATS
+  frameCurr.wait += LV_GetTimestamp()-start;
+#endif
+}
+
 /* Flush the content of the internal buffer the specific area on the display
  * You can use DMA or any hardware acceleration to do this operation in the background but
  * 'lv_disp_flush_ready()' has to be called when finished */
 static void ex_disp_flush(struct _disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p) {
-  /*The most simple case (but also the slowest) to put all pixels to the screen one-by-one*/
-  McuILI9341_SetWindow(area->x1, area->y1, area->x2, area->y2);
-  McuILI9341_WritePixelData((uint16_t*)color_p, (area->x2-area->x1+1)*(area->y2-area->y1+1));
-  /* IMPORTANT!!!
-   * Inform the graphics library that you are ready with the flushing*/
-  lv_disp_flush_ready(disp_drv);
+  /* set the window and start the pixel transfer in the background, in one bus transaction. LVGL waits for ex_disp_flush_done() before it reuses the buffer */
+#if LV_CONFIG_USE_FRAME_STATS
+  LV_FrameStatsFlushStart(area);
+#endif
+  if (McuILI9341_WriteWindowPixelDataAsync(area->x1, area->y1, area->x2, area->y2, (uint16_t*)color_p, ex_disp_flush_done, disp_drv)!=ERR_OK) {
+    lv_disp_flush_ready(disp_drv); /* do not block the library */
+  }
+}
+
+/* Fill an area of the display with a single color: used by LVGL instead of ex_disp_flush() if the buffer would contain
+ * only an opaque fill (screen backgrounds, window bodies), so the area is not rendered into the buffer at all */
+static void ex_disp_fill(struct _disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t color) {
+  uint16_t c = color.full;
+
+#if LV_COLOR_16_SWAP
+  c = (c>>8)|(c<<8); /* the display driver wants the RGB565 value, not the byte order in the buffer */
+#endif
+#if LV_CONFIG_USE_FRAME_STATS
+  LV_FrameStatsFlushStart(area);
+#endif
+  if (McuILI9341_FillWindowAsync(area->x1, area->y1, area->x2, area->y2, c, ex_disp_flush_done, disp_drv)!=ERR_OK) {
+    lv_disp_flush_ready(disp_drv); /* do not block the library */
+  }
 }
 
 #if USE_LV_GPU
@@ -109,6 +397,17 @@ static void ex_mem_fill(lv_color_t * dest, uint32_t length, lv_color_t color)
 #endif
 
 #if PL_CONFIG_USE_GUI_TOUCH_NAV
+static LV_TouchSourceCallback touchSource = NULL; /* if set, used instead of the touch controller */
+
+void LV_SetTouchSource(LV_TouchSourceCallback source) {
+  touchSource = source;
+#if TOUCH_CONFIG_USE_INTERRUPT
+  if (source!=NULL) {
+    LV_ResumeInputRead(); /* a touch source has to be polled */
+  }
+#endif
+}
+
 /* Read the touchpad and store it in 'data'
  * Return false if no more data read; true for ready again */
 static bool ex_tp_read(struct _lv_indev_drv_t * indev_drv, lv_indev_data_t * data) {
@@ -123,7 +422,15 @@ static bool ex_tp_read(struct _lv_indev_drv_t * indev_drv, lv_indev_data_t * dat
   data->point.x = last_x;
   data->point.y = last_y;
 
-  if (TOUCH_IsPressed() && TOUCH_Poll(&pressed, &x, &y)==ERR_OK) {
+  pressed = false;
+  if (touchSource!=NULL) {
+    if (!touchSource(&pressed, &x, &y)) {
+      pressed = false;
+    }
+  } else if (TOUCH_IsPressed() && TOUCH_Poll(&pressed, &x, &y)!=ERR_OK) {
+    pressed = false;
+  }
+  if (pressed) {
     data->state = LV_INDEV_STATE_PR;
     last_x = x;
     last_y = y;
@@ -133,15 +440,30 @@ static bool ex_tp_read(struct _lv_indev_drv_t * indev_drv, lv_indev_data_t * dat
     KeyPressForLCD();
   #endif
   }
+#if PL_CONFIG_USE_TOUCH_TRACE
+  if (touchSource==NULL) { /* only the input of the touch controller, not a replay */
+    TouchTrace_Record(data->state==LV_INDEV_STATE_PR, data->point.x, data->point.y);
+  }
+#endif
+#if TOUCH_CONFIG_USE_INTERRUPT
+  if (touchSource==NULL) {
+    if (!pressed && !lv_indev_is_dragging(inputDevicePtr)) {
+      /* pen is up and a drag throw is over: nothing to read until the touch interrupt reports new data */
+      lv_task_set_prio(indev_drv->read_task, LV_TASK_PRIO_OFF);
+      return false; /* no more data */
+    }
+    return TOUCH_HasMoreData(); /* only checks the sample queue */
+  }
+#endif
   //return TOUCH_HasMoreData();
   return false; /* no more data */
 }
 #endif
 
-void LV_Task(void) {
-  /* Periodically call this function.
-   * The timing is not critical but should be between 1..10 ms */
-  lv_task_handler();
+uint32_t LV_Task(void) {
+  /* Call this function again after the returned time or earlier if something has been changed
+   * (input, invalidated object, new animation). The refresh and animation tasks stop while there is nothing to do. */
+  return lv_task_handler();
 }
 
 #if PL_CONFIG_USE_GUI_KEY_NAV
@@ -165,6 +487,7 @@ void LV_ButtonEvent(uint8_t keys, uint16_t eventMask) {
     buttonInfo = LV_BTN_MASK_LEFT | eventMask;
     McuRB_Put(ringBufferHndl, &buttonInfo);
    }
+  LV_Notify(LV_NOTIFY_INPUT);
 }
 #endif
 
@@ -423,18 +746,134 @@ static bool encoder_read(lv_indev_data_t *data){
 }
 #endif
 
+#define LV_DRAW_BUF_SIZE   (LV_HOR_RES_MAX*LV_CONFIG_DRAW_BUF_LINES) /* number of pixels in a draw buffer */
+
+#if PL_CONFIG_USE_SHELL
+#if LV_CONFIG_USE_FRAME_STATS
+static void PrintTime(const unsigned char *name, uint32_t last, uint32_t avg, uint32_t max, const McuShell_StdIOType *io) {
+  uint8_t buf[64];
+
+  McuUtility_Num32uToStr(buf, sizeof(buf), LV_TimestampToUs(last));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, avg ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(avg));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(max));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  McuShell_SendStatusStr(name, buf, io->stdOut);
+}
+#endif
+
+static uint8_t PrintStatus(const McuShell_StdIOType *io) {
+  uint8_t buf[64];
+
+  McuShell_SendStatusStr((unsigned char*)"lv", (unsigned char*)"\r\n", io->stdOut);
+  McuUtility_Num32uToStr(buf, sizeof(buf), LV_CONFIG_DRAW_BUF_LINES);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" lines, ");
+  McuUtility_strcat(buf, sizeof(buf), LV_CONFIG_DRAW_BUF_DOUBLE?(unsigned char*)"double, ":(unsigned char*)"single, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), (LV_CONFIG_DRAW_BUF_DOUBLE?2:1)*LV_DRAW_BUF_SIZE*sizeof(lv_color_t));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" bytes\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  draw buf", buf, io->stdOut);
+#if LV_CONFIG_USE_FRAME_STATS
+  LV_FrameStats_t stats;
+
+  LV_GetFrameStats(&stats);
+  McuUtility_Num32uToStr(buf, sizeof(buf), stats.nofFrames);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", last: ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.last.nofAreas);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" areas, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.last.px);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" px, ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), stats.last.nofBytes);
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" bytes\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  frames", buf, io->stdOut);
+  if (stats.nofFrames>0) {
+    PrintTime((unsigned char*)"  render", stats.last.render, stats.renderSum/stats.nofFrames, stats.renderMax, io);
+    PrintTime((unsigned char*)"  flush", stats.last.flush, stats.flushSum/stats.nofFrames, stats.flushMax, io);
+    PrintTime((unsigned char*)"  wait", stats.last.wait, stats.waitSum/stats.nofFrames, stats.waitMax, io);
+  }
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+  uint32_t flushCost, pxCost;
+
+  McuUtility_strcpy(buf, sizeof(buf), LV_GetAreaJoinCost(&flushCost, &pxCost)?(unsigned char*)"cost":(unsigned char*)"overlap");
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)", flush ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(flushCost));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" us, px ");
+  McuUtility_strcatNum32u(buf, sizeof(buf), LV_TimestampToUs(pxCost*1000U));
+  McuUtility_strcat(buf, sizeof(buf), (unsigned char*)" ns\r\n");
+  McuShell_SendStatusStr((unsigned char*)"  area join", buf, io->stdOut);
+#endif
+  return ERR_OK;
+}
+
+static uint8_t PrintHelp(const McuShell_StdIOType *io) {
+  McuShell_SendHelpStr((unsigned char*)"lv", (unsigned char*)"Group of LittlevGL commands\r\n", io->stdOut);
+  McuShell_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+#if LV_CONFIG_USE_FRAME_STATS
+  McuShell_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Reset the frame statistics\r\n", io->stdOut);
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+  McuShell_SendHelpStr((unsigned char*)"  join cost|overlap", (unsigned char*)"Join invalidated areas by measured flush cost or only if overlapping\r\n", io->stdOut);
+#endif
+  return ERR_OK;
+}
+
+uint8_t LV_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io) {
+  if (McuUtility_strcmp((char*)cmd, McuShell_CMD_HELP)==0 || McuUtility_strcmp((char*)cmd, "lv help")==0) {
+    *handled = TRUE;
+    return PrintHelp(io);
+  } else if ((McuUtility_strcmp((char*)cmd, McuShell_CMD_STATUS)==0) || (McuUtility_strcmp((char*)cmd, "lv status")==0)) {
+    *handled = TRUE;
+    return PrintStatus(io);
+#if LV_CONFIG_USE_FRAME_STATS
+  } else if (McuUtility_strcmp((char*)cmd, "lv reset")==0) {
+    *handled = TRUE;
+    LV_ResetFrameStats();
+    return ERR_OK;
+#endif
+#if LV_CONFIG_AREA_JOIN_COST
+  } else if (McuUtility_strcmp((char*)cmd, "lv join cost")==0) {
+    *handled = TRUE;
+    LV_SetAreaJoinCost(true);
+    return ERR_OK;
+  } else if (McuUtility_strcmp((char*)cmd, "lv join overlap")==0) {
+    *handled = TRUE;
+    LV_SetAreaJoinCost(false);
+    return ERR_OK;
+#endif
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_USE_SHELL */
+
 static lv_disp_buf_t disp_buf;
-static lv_color_t buf[LV_HOR_RES_MAX * 10];                     /*Declare a buffer for 10 lines*/
+static lv_color_t buf[LV_DRAW_BUF_SIZE];  /* buffer for LV_CONFIG_DRAW_BUF_LINES lines */
+#if LV_CONFIG_DRAW_BUF_DOUBLE
+static lv_color_t buf2[LV_DRAW_BUF_SIZE]; /* second buffer: LVGL renders into one while the other gets flushed */
+#endif
 
 void LV_Init(void) {
   lv_disp_drv_t disp_drv;
 
   lv_init();
-  lv_disp_buf_init(&disp_buf, buf, NULL, LV_HOR_RES_MAX * 10);    /*Initialize the display buffer*/
+#if LV_CONFIG_DRAW_BUF_DOUBLE
+  lv_disp_buf_init(&disp_buf, buf, buf2, LV_DRAW_BUF_SIZE);    /*Initialize the display buffers*/
+#else
+  lv_disp_buf_init(&disp_buf, buf, NULL, LV_DRAW_BUF_SIZE);    /*Initialize the display buffer*/
+#endif
   lv_disp_drv_init(&disp_drv);
   /*Set up the functions to access to your display*/
   disp_drv.flush_cb = ex_disp_flush;            /*Used in buffered mode (LV_VDB_SIZE != 0  in lv_conf.h)*/
   disp_drv.buffer = &disp_buf;          /*Assign the buffer to the display*/
+#if LV_CONFIG_USE_HW_FILL
+  disp_drv.fill_cb = ex_disp_fill;      /*Solid areas are filled by the display driver*/
+#endif
+#if LV_CONFIG_USE_FRAME_STATS
+  McuArmTools_InitCycleCounter();
+  McuArmTools_EnableCycleCounter();
+  disp_drv.monitor_cb = ex_monitor_cb;
+#endif
+  disp_drv.wait_cb = ex_wait_cb;
 
 #if USE_LV_GPU
   /*Optionally add functions to access the GPU. (Only in buffered mode, LV_VDB_SIZE != 0)*/
@@ -443,7 +882,15 @@ void LV_Init(void) {
 #endif
 
   /*Finally register the driver*/
+#if LV_CONFIG_USE_FRAME_STATS
+  lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+  lv_task_set_cb(disp->refr_task, ex_refr_task); /* measure the refresh */
+#if LV_CONFIG_AREA_JOIN_COST
+  LV_SetAreaJoinCost(true); /* takes effect with the first fit of the flush times */
+#endif
+#else
   lv_disp_drv_register(&disp_drv);
+#endif
 
   /*************************
    * Input device interface
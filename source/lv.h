@@ -8,6 +8,36 @@
 #define SOURCES_LV_H_
 
 #include "LittlevGL/lvgl/lvgl.h"
+#include "platform.h"
+#include "McuRTOS.h"
+#if PL_CONFIG_USE_SHELL
+  #include "McuShell.h"
+#endif
+
+#ifndef LV_CONFIG_DRAW_BUF_LINES
+  #define LV_CONFIG_DRAW_BUF_LINES   (10)
+#endif
+  /*!< Number of display lines in a draw buffer */
+
+#ifndef LV_CONFIG_DRAW_BUF_DOUBLE
+  #define LV_CONFIG_DRAW_BUF_DOUBLE  (0)
+#endif
+  /*!< 1: use two draw buffers, so rendering the next band overlaps with flushing the previous one. 0: single draw buffer */
+
+#ifndef LV_CONFIG_USE_HW_FILL
+  #define LV_CONFIG_USE_HW_FILL      (1)
+#endif
+  /*!< 1: buffer areas with only an opaque fill are not rendered, the display driver fills them on the panel. 0: all areas are rendered and flushed */
+
+#ifndef LV_CONFIG_USE_FRAME_STATS
+  #define LV_CONFIG_USE_FRAME_STATS  (1)
+#endif
+  /*!< 1: measure render, flush and wait time per frame, reported with 'lv status' */
+
+#ifndef LV_CONFIG_AREA_JOIN_COST
+  #define LV_CONFIG_AREA_JOIN_COST   (1 && LV_CONFIG_USE_FRAME_STATS)
+#endif
+  /*!< 1: join invalidated areas based on the flush and pixel cost measured on the display transfers. 0: LVGL default, only overlapping areas */
 
 /* button masks */
 #define LV_BTN_MASK_CENTER    (1<<0)
@@ -28,7 +58,59 @@ lv_indev_t *LV_GetInputDevice(void);
 
 void LV_ButtonEvent(uint8_t key, uint16_t eventMask);
 
-void LV_Task(void);
+uint32_t LV_Task(void); /* runs the LVGL tasks, returns the ms until the next one is due or LV_NO_TASK_READY */
+
+/* task notification bits for the task running LV_Task() */
+#define LV_NOTIFY_FLUSH_DONE  (1<<8)  /* a display transfer has finished */
+#define LV_NOTIFY_INPUT       (1<<9)  /* touch or button input is available */
+#define LV_NOTIFY_WAKEUP      (1<<10) /* something else needs the task, e.g. a shell request */
+
+void LV_SetNotifyTask(TaskHandle_t task);
+void LV_Notify(uint32_t events); /* can be called from task or interrupt context */
+uint32_t LV_WaitNotify(TickType_t timeout); /* blocks until notified or timeout, returns the LV_NOTIFY_* bits */
+
+#if LV_CONFIG_USE_FRAME_STATS
+/* measurements of a single frame, times in LV_GetTimestamp() units */
+typedef struct {
+  uint32_t px; /* number of rendered pixels */
+  uint16_t nofAreas; /* number of invalidated areas */
+  uint16_t nofFlushes; /* number of flush calls */
+  uint32_t nofBytes; /* bytes sent to the panel */
+  uint32_t render, flush, wait;
+} LV_FrameSample_t;
+
+typedef struct {
+  uint32_t nofFrames;
+  LV_FrameSample_t last;
+  uint32_t renderMax, flushMax, waitMax;
+  uint64_t renderSum, flushSum, waitSum;
+} LV_FrameStats_t;
+
+typedef void (*LV_FrameHookCallback)(const LV_FrameSample_t *sample); /* called for each frame, possibly from interrupt context */
+
+uint32_t LV_GetTimestamp(void); /* DWT cycle counter */
+uint32_t LV_TimestampToUs(uint32_t ts);
+
+void LV_SetFrameHook(LV_FrameHookCallback hook);
+void LV_GetFrameStats(LV_FrameStats_t *stats);
+void LV_ResetFrameStats(void);
+#endif
+
+#if LV_CONFIG_AREA_JOIN_COST
+void LV_SetAreaJoinCost(bool enable); /* true: use the measured cost model, false: join overlapping areas only */
+bool LV_GetAreaJoinCost(uint32_t *flushCost, uint32_t *pxCost); /* returns if enabled, costs in LV_GetTimestamp() units */
+#endif
+
+#if PL_CONFIG_USE_GUI_TOUCH_NAV
+/* returns true and the touch state, or false to report 'released' */
+typedef bool (*LV_TouchSourceCallback)(bool *pressed, uint16_t *x, uint16_t *y);
+
+void LV_SetTouchSource(LV_TouchSourceCallback source); /* replaces the touch controller as input, NULL to restore it */
+#endif
+
+#if PL_CONFIG_USE_SHELL
+  uint8_t LV_ParseCommand(const unsigned char *cmd, bool *handled, const McuShell_StdIOType *io);
+#endif
 
 void LV_Init(void);
 
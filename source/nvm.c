@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Non-volatile blocks in the on-chip flash: each block uses one flash page with a header (magic, size, CRC32).
+ * The flash is erased and programmed with the flash driver in the LPC55S69 boot ROM, as fsl_iap is not part of the project.
+ */
+#include "platform.h"
+#if PL_CONFIG_USE_NVM
+#include "nvm.h"
+#include "McuLib.h"
+#include <string.h>
+#if NVM_CONFIG_USE_FLASH
+  #include "fsl_common.h"
+#endif
+
+#define NVM_MAGIC   (0x4E564D31) /* 'NVM1' */
+
+typedef struct {
+  uint32_t magic;
+  uint16_t size; /* number of data bytes */
+  uint16_t reserved; /* keeps the data 32bit aligned */
+  uint32_t crc; /* CRC32 over the data */
+  uint8_t data[NVM_BLOCK_MAX_DATA_SIZE];
+} NVM_Page_t;
+
+#if NVM_CONFIG_USE_FLASH
+/* flash driver of the LPC55S69 boot ROM, see the 'Flash API' chapter of the user manual */
+typedef struct {
+  uint32_t version;
+  int32_t (*flash_init)(void *config);
+  int32_t (*flash_erase)(void *config, uint32_t start, uint32_t lengthInBytes, uint32_t key);
+  int32_t (*flash_program)(void *config, uint32_t start, uint8_t *src, uint32_t lengthInBytes);
+  int32_t (*flash_verify_erase)(void *config, uint32_t start, uint32_t lengthInBytes);
+  int32_t (*flash_verify_program)(void *config, uint32_t start, uint32_t lengthInBytes, const uint8_t *expectedData, uint32_t *failedAddress, uint32_t *failedData);
+} NVM_RomFlashDriver_t;
+
+typedef struct {
+  void (*runBootloader)(void *arg);
+  uint32_t version;
+  const char *copyright;
+  const uint32_t *reserved;
+  const NVM_RomFlashDriver_t *flashDriver;
+} NVM_RomApiTree_t;
+
+#define NVM_ROM_API_TREE    ((const NVM_RomApiTree_t*)0x130010F0)
+#define NVM_ROM_ERASE_KEY   (0x6B65666C) /* 'kfel' */
+
+static uint32_t flashConfig[32]; /* flash_config_t of the ROM driver, only used by the ROM */
+#else
+static NVM_Page_t pages[NVM_BLOCK_NOF]; /* kept in RAM, lost at reset */
+#endif
+
+_Static_assert(sizeof(NVM_Page_t)==NVM_PAGE_SIZE, "one block has to fill exactly one flash page");
+#if NVM_CONFIG_USE_FLASH
+_Static_assert(NVM_CONFIG_FLASH_START+NVM_BLOCK_NOF*NVM_PAGE_SIZE<=0x9DE00, "blocks overlap with the protected flash region");
+#endif
+
+static uint32_t NVM_Crc32(const uint8_t *data, size_t size) {
+  uint32_t crc = 0xFFFFFFFF;
+
+  while(size>0) {
+    crc ^= *data++;
+    for(int i=0; i<8; i++) {
+      crc = (crc>>1)^(0xEDB88320&(-(crc&1)));
+    }
+    size--;
+  }
+  return ~crc;
+}
+
+static const NVM_Page_t *NVM_GetPage(NVM_Block_e block) {
+#if NVM_CONFIG_USE_FLASH
+  return (const NVM_Page_t*)(NVM_CONFIG_FLASH_START+block*NVM_PAGE_SIZE);
+#else
+  return &pages[block];
+#endif
+}
+
+uint8_t NVM_ReadBlock(NVM_Block_e block, void *data, size_t size) {
+  const NVM_Page_t *page;
+
+  if (block>=NVM_BLOCK_NOF || size>sizeof(page->data)) {
+    return ERR_FAILED;
+  }
+  page = NVM_GetPage(block);
+  /* reading an erased page faults until it has been programmed: check with the ROM driver first */
+#if NVM_CONFIG_USE_FLASH
+  if (NVM_ROM_API_TREE->flashDriver->flash_verify_erase(flashConfig, (uint32_t)page, NVM_PAGE_SIZE)==kStatus_Success) {
+    return ERR_FAILED; /* never written */
+  }
+#endif
+  if (page->magic!=NVM_MAGIC || page->size!=size || page->crc!=NVM_Crc32(page->data, size)) {
+    return ERR_FAILED;
+  }
+  memcpy(data, page->data, size);
+  return ERR_OK;
+}
+
+uint8_t NVM_WriteBlock(NVM_Block_e block, const void *data, size_t size) {
+  static NVM_Page_t page; /* not on the stack: one flash page */
+
+  if (block>=NVM_BLOCK_NOF || size>sizeof(page.data)) {
+    return ERR_FAILED;
+  }
+  memset(&page, 0xFF, sizeof(page));
+  page.magic = NVM_MAGIC;
+  page.size = size;
+  page.reserved = 0xFFFF;
+  page.crc = NVM_Crc32(data, size);
+  memcpy(page.data, data, size);
+#if NVM_CONFIG_USE_FLASH
+  const NVM_RomFlashDriver_t *drv = NVM_ROM_API_TREE->flashDriver;
+  uint32_t addr = (uint32_t)NVM_GetPage(block);
+  uint32_t primask;
+  int32_t status;
+
+  primask = __get_PRIMASK();
+  __disable_irq(); /* no code or vector fetches from the flash while it is erased or programmed */
+  status = drv->flash_erase(flashConfig, addr, NVM_PAGE_SIZE, NVM_ROM_ERASE_KEY);
+  if (status==kStatus_Success) {
+    status = drv->flash_program(flashConfig, addr, (uint8_t*)&page, NVM_PAGE_SIZE);
+  }
+  __set_PRIMASK(primask);
+  if (status!=kStatus_Success) {
+    return ERR_FAILED;
+  }
+#else
+  pages[block] = page;
+#endif
+  return ERR_OK;
+}
+
+void NVM_Deinit(void) {
+}
+
+void NVM_Init(void) {
+#if NVM_CONFIG_USE_FLASH
+  (void)NVM_ROM_API_TREE->flashDriver->flash_init(flashConfig);
+#else
+  memset(pages, 0xFF, sizeof(pages)); /* erased */
+#endif
+}
+
+#endif /* PL_CONFIG_USE_NVM */
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2019, Erich Styger
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef NVM_H_
+#define NVM_H_
+
+#include "platform.h"
+#if PL_CONFIG_USE_NVM
+#include <stdint.h>
+#include <stddef.h>
+#include "McuSPIconfig.h"
+
+#ifndef NVM_CONFIG_USE_FLASH
+  #define NVM_CONFIG_USE_FLASH    (1)
+#endif
+  /*!< 1: blocks are stored in the on-chip flash. 0: blocks are kept in RAM */
+
+#ifndef NVM_CONFIG_FLASH_START
+  #define NVM_CONFIG_FLASH_START  (0x98000) /* end of PROGRAM_FLASH in the linker settings, below the protected flash region at 0x9DE00 */
+#endif
+  /*!< start address of the flash pages used for the blocks, must not overlap with the application */
+
+#ifndef NVM_CONFIG_NOF_PRESET_PAGES
+  #define NVM_CONFIG_NOF_PRESET_PAGES  (8)
+#endif
+  /*!< number of flash pages the EQ presets rotate through, each save erases and programs the next one */
+
+#define NVM_PAGE_SIZE   (512) /* flash page: smallest unit to erase and program */
+
+/* one flash page per block */
+typedef enum {
+  NVM_BLOCK_TOUCH_CALIB,
+  NVM_BLOCK_PRESET_FIRST, /* EQ presets, see Preset.c */
+  NVM_BLOCK_PRESET_LAST = NVM_BLOCK_PRESET_FIRST+NVM_CONFIG_NOF_PRESET_PAGES-1,
+  NVM_BLOCK_NOF /* sentinel, must be last */
+} NVM_Block_e;
+
+#define NVM_BLOCK_MAX_DATA_SIZE  (NVM_PAGE_SIZE-12) /* page minus header */
+
+/* reads a block: returns ERR_OK if it has been written with the same size and the CRC matches, ERR_FAILED otherwise */
+uint8_t NVM_ReadBlock(NVM_Block_e block, void *data, size_t size);
+
+/* erases the page of the block and programs the data with size and CRC. Interrupts are disabled for a few ms */
+uint8_t NVM_WriteBlock(NVM_Block_e block, const void *data, size_t size);
+
+void NVM_Deinit(void);
+void NVM_Init(void);
+
+#endif /* PL_CONFIG_USE_NVM */
+
+#endif /* NVM_H_ */
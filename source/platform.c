@@ -42,6 +42,27 @@
 #include "lcd.h"
 #include "McuILI9341.h"
 #include "touch.h"
+#if PL_CONFIG_USE_NVM
+  #include "nvm.h"
+#endif
+#if PL_CONFIG_USE_STMPE610
+  #include "TouchCalibrate.h"
+#endif
+#if PL_CONFIG_USE_TOUCH_TRACE
+  #include "TouchTrace.h"
+#endif
+#if PL_CONFIG_USE_CODEC
+  #include "codec.h"
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  #include "EqDsp.h"
+#endif
+#if PL_CONFIG_USE_SPECTRUM
+  #include "Spectrum.h"
+#endif
+#if PL_CONFIG_USE_PRESET
+  #include "Preset.h"
+#endif
 
 void PL_Init(void) {
 //  InitPins(); /* do all the pin muxing */
@@ -75,6 +96,9 @@ void PL_Init(void) {
 
   /* initialize my own modules */
   McuWait_Waitms(500); /* give hardware time to power-up */
+#if PL_CONFIG_USE_NVM
+  NVM_Init();
+#endif
   McuSPI_Init();
   McuILI9341_Init();
 #if PL_CONFIG_USE_SHELL
@@ -87,10 +111,26 @@ void PL_Init(void) {
 #endif
 #if PL_CONFIG_USE_STMPE610
   McuSTMPE610_Init();
+  TouchCalib_Init(); /* loads the calibration from NVM */
 #endif
 #if PL_CONFIG_USE_GUI_TOUCH_NAV
   TOUCH_Init();
 #endif
+#if PL_CONFIG_USE_TOUCH_TRACE
+  TouchTrace_Init();
+#endif
+#if PL_CONFIG_USE_CODEC
+  CODEC_Init();
+#endif
+#if PL_CONFIG_USE_EQ_DSP
+  EqDsp_Init();
+#endif
+#if PL_CONFIG_USE_SPECTRUM
+  Spectrum_Init();
+#endif
+#if PL_CONFIG_USE_PRESET
+  Preset_Init(); /* after the codec and the EQ, before the GUI */
+#endif
 #if PL_CONFIG_USE_GUI
   GUI_Init();
 #endif
@@ -8,7 +8,7 @@
 #define PLATFORM_H_
 
 #define PL_CONFIG_USE_I2C               (1)
-#define PL_CONFIG_USE_HW_I2C            (0 && PL_CONFIG_USE_I2C) /* otherwise uses bit-banging */
+#define PL_CONFIG_USE_HW_I2C            (CONFIG_USE_HW_I2C && PL_CONFIG_USE_I2C) /* set in IncludeMcuLibConfig.h, otherwise uses bit-banging */
 #define PL_CONFIG_USE_FT6206            (0 && PL_CONFIG_USE_I2C) /* capacitive touch controller */
 #define PL_CONFIG_USE_STMPE610          (1) /* resistive touch controller */
 #define PL_CONFIG_USE_GUI               (1)
@@ -20,6 +20,14 @@
 #define PL_CONFIG_USE_GUI_SCREEN_SAVER  (0) /* By default, it turns off the display */
 #define PL_CONFIG_USE_TOASTER           (0 && PL_CONFIG_USE_GUI_SCREEN_SAVER) /* Not yet implemented! */
 #define PL_CONFIG_USE_GUI_SYSMON        (1)
+#define PL_CONFIG_USE_NVM               (1) /* non-volatile settings in the on-chip flash */
+#define PL_CONFIG_USE_CODEC             (1 && PL_CONFIG_USE_I2C) /* WM8904 register writer task with 'codec' shell command */
+#define PL_CONFIG_USE_EQ_DSP            (1) /* coefficients of the 5-band EQ for the response curve, follow the EQ screen */
+#define PL_CONFIG_USE_SPECTRUM          (1) /* FFT spectrum analyser of the audio stream with 'spectrum' shell command */
+#define PL_CONFIG_USE_EQ_CURVE          (1 && PL_CONFIG_USE_EQ_DSP && PL_CONFIG_USE_GUI) /* frequency response of the EQ above the gain columns */
+#define PL_CONFIG_USE_PRESET            (1 && PL_CONFIG_USE_NVM) /* named EQ presets in flash, last used one restored at power-up, 'preset' shell command */
+#define PL_CONFIG_USE_TOUCH_TRACE       (1 && PL_CONFIG_USE_GUI && PL_CONFIG_USE_GUI_TOUCH_NAV) /* touch input record and replay with 'touchtrace' shell command */
+#define PL_CONFIG_USE_BENCH             (1 && PL_CONFIG_USE_GUI && PL_CONFIG_USE_GUI_TOUCH_NAV && PL_CONFIG_USE_GUI_SYSMON) /* frame time benchmark with 'bench' shell command */
 
 #if PL_CONFIG_USE_FT6206 && PL_CONFIG_USE_STMPE610
   #error "only one touch controller can be active"
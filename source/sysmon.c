@@ -35,9 +35,19 @@ static lv_task_t * refr_task;
  */
 static void win_close_action(lv_obj_t *btn, lv_event_t event) {
   if (event==LV_EVENT_RELEASED) {
+    GUI_SysMon_Close();
+  }
+}
+
+/**
+ * Closes the system monitor window, if open
+ */
+void GUI_SysMon_Close(void) {
+  if (win!=NULL) {
     lv_obj_del(win);
     win = NULL;
-
+  }
+  if (refr_task!=NULL) {
     lv_task_del(refr_task);
     refr_task = NULL;
   }
@@ -14,6 +14,7 @@ extern "C" {
  * Initialize the system monitor
  */
 void GUI_SysMon_Create(void);
+void GUI_SysMon_Close(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -17,6 +17,17 @@
   #include "McuSTMPE610.h"
   #include "TouchCalibrate.h"
 #endif
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  #include "fsl_device_registers.h" /* __DMB() */
+#endif
+#if TOUCH_CONFIG_USE_FILTER
+  #include "TouchFilter.h"
+#endif
+#if TOUCH_CONFIG_USE_INTERRUPT || TOUCH_CONFIG_USE_GESTURES
+  #include "McuRTOS.h"
+  #include "McuSPI.h"
+  #include "lv.h"
+#endif
 
 #if PL_CONFIG_USE_FT6206
 static void TOUCH_OrientationRotate(McuFT6206_TouchPoint *point) {
@@ -26,32 +37,199 @@ static void TOUCH_OrientationRotate(McuFT6206_TouchPoint *point) {
 }
 #endif
 
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+#define TOUCH_QUEUE_SIZE   (16) /* number of samples, must be a power of two */
+
+/* single producer (TOUCH_ReadController()), single consumer (TOUCH_Poll()) ring buffer: each side only writes its own index */
+static struct {
+  McuSTMPE610_TouchPoint points[TOUCH_QUEUE_SIZE];
+  volatile uint8_t head; /* next write position, free running */
+  volatile uint8_t tail; /* next read position, free running */
+} queue;
+static volatile bool penDown = false; /* state of the pen after the last controller read */
+static TaskHandle_t touchTaskHndl = NULL; /* reads the controller after an interrupt */
+
+static bool TOUCH_QueuePut(const McuSTMPE610_TouchPoint *point) {
+  uint8_t head = queue.head;
+
+  if ((uint8_t)(head-queue.tail)>=TOUCH_QUEUE_SIZE) {
+    return false; /* full */
+  }
+  queue.points[head&(TOUCH_QUEUE_SIZE-1)] = *point;
+  __DMB(); /* sample is stored before it gets published */
+  queue.head = head+1;
+  return true;
+}
+
+static bool TOUCH_QueueGet(McuSTMPE610_TouchPoint *point) {
+  uint8_t tail = queue.tail;
+
+  if (tail==queue.head) {
+    return false; /* empty */
+  }
+  __DMB(); /* read the sample after it has been published */
+  *point = queue.points[tail&(TOUCH_QUEUE_SIZE-1)];
+  __DMB(); /* sample is read before the slot gets released */
+  queue.tail = tail+1;
+  return true;
+}
+
+static bool TOUCH_QueueIsEmpty(void) {
+  return queue.tail==queue.head;
+}
+
+/* deferred interrupt handler: drains the controller FIFO into the queue, runs in the touch task */
+static void TOUCH_ReadController(void) {
+  McuSTMPE610_TouchPoint points[8];
+  uint8_t nof = 0;
+  bool touched;
+
+  McuSPI_RequestBus(McuSPI_ClientTouch); /* keep the display out until all controller transfers are done */
+  (void)McuSTMPE610_AckInterrupt(); /* first, so samples arriving while draining raise a new interrupt */
+  if (McuSTMPE610_IsTouched(&touched)!=ERR_OK) {
+    touched = false;
+  }
+  do {
+    if (McuSTMPE610_ReadFIFO(points, sizeof(points)/sizeof(points[0]), &nof)!=ERR_OK) {
+      break;
+    }
+    for(uint8_t i=0; i<nof; i++) {
+      (void)TOUCH_QueuePut(&points[i]); /* if full, the sample is dropped: the reader is behind anyway */
+    }
+  } while(nof==sizeof(points)/sizeof(points[0]));
+  McuSPI_ReleaseBus(McuSPI_ClientTouch);
+  penDown = touched;
+  LV_Notify(LV_NOTIFY_INPUT); /* resumes the LVGL input device */
+}
+
+/* the read waits for the SPI bus while the display gets flushed, so it has its own task and does not block the RTOS timer task */
+static void TouchTask(void *pv) {
+  (void)pv; /* not used */
+  for(;;) {
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    TOUCH_ReadController();
+  }
+}
+
+static void TOUCH_OnInterrupt(void) {
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+  vTaskNotifyGiveFromISR(touchTaskHndl, &xHigherPriorityTaskWoken); /* pin interrupt stays masked until the controller is acknowledged */
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+#endif /* TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610 */
+
+#if PL_CONFIG_USE_FT6206
+static McuFT6206_TouchData ftData; /* last report of the controller */
+static bool ftDataFresh = false; /* ftData has been read by TOUCH_IsPressed() and not yet used by TOUCH_Poll() */
+#if TOUCH_CONFIG_USE_GESTURES
+static TouchGesture_t gesture;
+static TOUCH_GestureCallback gestureCallback = NULL;
+
+void TOUCH_SetGestureCallback(TOUCH_GestureCallback callback) {
+  gestureCallback = callback;
+}
+#endif
+
+#if TOUCH_CONFIG_USE_INTERRUPT
+static void TOUCH_OnInterrupt(void) {
+  LV_Notify(LV_NOTIFY_INPUT); /* resumes the LVGL input device, the controller gets read in task context */
+}
+#endif
+
+/* Reads both touch points in one transaction. TOUCH_IsPressed() and TOUCH_Poll() share the report. */
+static uint8_t TOUCH_ReadFT6206(void) {
+  uint8_t res;
+
+  res = McuFT6206_ReadTouchData(&ftData);
+  ftDataFresh = res==ERR_OK;
+#if TOUCH_CONFIG_USE_INTERRUPT
+  McuFT6206_EnableInterrupt(); /* fires again while a finger is down, so the input device keeps reading */
+#endif
+#if TOUCH_CONFIG_USE_GESTURES
+  if (res==ERR_OK) {
+    TouchGesture_Input_t input;
+    TouchGesture_Event_t event;
+
+    input.nofTouches = ftData.nofTouches;
+    for(uint8_t i=0; i<ftData.nofTouches; i++) {
+      McuFT6206_TouchPoint point = {.x=ftData.point[i].x, .y=ftData.point[i].y, .z=1};
+
+      TOUCH_OrientationRotate(&point);
+      input.point[i].x = point.x;
+      input.point[i].y = point.y;
+    }
+    if (TouchGesture_Process(&gesture, &input, xTaskGetTickCount()*portTICK_PERIOD_MS, &event) && gestureCallback!=NULL) {
+      gestureCallback(&event);
+    }
+  }
+#endif
+  return res;
+}
+#endif /* PL_CONFIG_USE_FT6206 */
+
+#if TOUCH_CONFIG_USE_FILTER
+static TouchFilter_t filter; /* reset for each pen down */
+#endif
+
 uint8_t TOUCH_Poll(bool *pressed, uint16_t *x, uint16_t *y) {
   /* defaults */
   *pressed = false;
   *x = 0;
   *y = 0;
 #if PL_CONFIG_USE_FT6206
-  uint8_t val, res;
-  McuFT6206_TouchPoint point;
-
-  if (McuFT6206_ReadNofTouches(&val)==ERR_OK) {
-    if (val>0) { /* there are touches */
-      res = McuFT6206_ReadPoint(0, &point);
-      if (point.z>0) { /* z indicates how strong it was pressed */
-        val = 0;
-      }
-      if (res==ERR_OK && point.z>0) {
-        TOUCH_OrientationRotate(&point);
-        *pressed = true;
-        *x = point.x;
-        *y = point.y;
-        return ERR_OK; /* touched */
-      }
-    }
+  if (!ftDataFresh && TOUCH_ReadFT6206()!=ERR_OK) { /* not read by TOUCH_IsPressed() */
+    return ERR_FAILED;
+  }
+  ftDataFresh = false;
+#if TOUCH_CONFIG_USE_GESTURES
+  if (TouchGesture_IsMultiTouch(&gesture)) {
+    return ERR_IDLE; /* two finger gesture: not a press for the GUI */
   }
 #endif
-#if PL_CONFIG_USE_STMPE610
+  if (ftData.nofTouches>0) {
+    McuFT6206_TouchPoint point = {.x=ftData.point[0].x, .y=ftData.point[0].y, .z=1};
+
+    TOUCH_OrientationRotate(&point);
+    *pressed = true;
+    *x = point.x;
+    *y = point.y;
+    return ERR_OK; /* touched */
+  }
+#endif
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  static uint16_t lastX, lastY;
+  static bool lastValid = false; /* lastX/lastY belong to the current pen down */
+  McuSTMPE610_TouchPoint point;
+
+  if (TOUCH_QueueGet(&point)) {
+    if (TouchCalib_IsCalibrated()) {
+      TouchCalib_Calibrate(&point.x, &point.y);
+    }
+#if TOUCH_CONFIG_USE_FILTER
+    TouchFilter_Sample_t sample = {.x=point.x, .y=point.y, .z=point.z};
+
+    if (TouchFilter_Process(&filter, &sample, &lastX, &lastY)) {
+      lastValid = true;
+    }
+#else
+    lastX = point.x;
+    lastY = point.y;
+    lastValid = true;
+#endif
+  } else if (!penDown) {
+    lastValid = false;
+#if TOUCH_CONFIG_USE_FILTER
+    TouchFilter_Reset(&filter);
+#endif
+  }
+  if (lastValid) { /* no new sample while the pen is still down: report the last position */
+    *x = lastX;
+    *y = lastY;
+    *pressed = true;
+    return ERR_OK; /* touched */
+  }
+#elif PL_CONFIG_USE_STMPE610
   /* test only */
   bool empty;
   uint8_t res, zd;
@@ -65,33 +243,52 @@ uint8_t TOUCH_Poll(bool *pressed, uint16_t *x, uint16_t *y) {
       res = McuSTMPE610_GetRawCoordinates(&xd, &yd, &zd);
     }
     if (res==ERR_OK) {
+#if TOUCH_CONFIG_USE_FILTER
+      TouchFilter_Sample_t sample = {.x=xd, .y=yd, .z=zd};
+
+      if (!TouchFilter_Process(&filter, &sample, &xd, &yd)) {
+        return ERR_IDLE; /* no accepted sample yet */
+      }
+#endif
       *x = xd;
       *y = yd;
       *pressed = true;
       return ERR_OK; /* touched */
     }
   }
+#if TOUCH_CONFIG_USE_FILTER
+  TouchFilter_Reset(&filter); /* pen up */
+#endif
 #endif
   return ERR_IDLE; /* not touched */
 }
 
 bool TOUCH_IsPressed(void) {
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  return penDown || !TOUCH_QueueIsEmpty();
+#else
   uint8_t res;
 #if PL_CONFIG_USE_STMPE610
   bool touched;
 
   res = McuSTMPE610_IsTouched(&touched);
+#if TOUCH_CONFIG_USE_FILTER
+  if (res!=ERR_OK || !touched) {
+    TouchFilter_Reset(&filter); /* pen up: TOUCH_Poll() is not called until the next pen down */
+  }
+#endif
   return res==ERR_OK && touched;
 #elif PL_CONFIG_USE_FT6206
-  uint8_t val;
-
-  res = McuFT6206_ReadNofTouches(&val);
-  return res==ERR_OK && val>0;
+  res = TOUCH_ReadFT6206();
+  return res==ERR_OK && ftData.nofTouches>0;
 #endif
+#endif /* TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610 */
 }
 
 bool TOUCH_HasMoreData(void) {
-#if PL_CONFIG_USE_STMPE610
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  return !TOUCH_QueueIsEmpty();
+#elif PL_CONFIG_USE_STMPE610
   uint8_t res;
   bool empty;
 
@@ -103,9 +300,26 @@ bool TOUCH_HasMoreData(void) {
 }
 
 void TOUCH_Init(void) {
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  /* above the GUI task, so the queue is filled before the input device reads it */
+  if (xTaskCreate(TouchTask, "Touch", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, &touchTaskHndl) != pdPASS) {
+    for(;;){} /* error */
+  }
+  McuSTMPE610_SetIntCallback(TOUCH_OnInterrupt); /* pin interrupt gets unmasked in McuSTMPE610_InitController() */
+#elif TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_FT6206
+  McuFT6206_SetIntCallback(TOUCH_OnInterrupt);
+#endif
+#if TOUCH_CONFIG_USE_GESTURES
+  TouchGesture_Reset(&gesture);
+#endif
 }
 
 void TOUCH_Deinit(void) {
+#if TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_STMPE610
+  McuSTMPE610_SetIntCallback(NULL);
+#elif TOUCH_CONFIG_USE_INTERRUPT && PL_CONFIG_USE_FT6206
+  McuFT6206_SetIntCallback(NULL);
+#endif
 }
 
 #endif /* PL_CONFIG_USE_TOUCH */
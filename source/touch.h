@@ -10,6 +10,37 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "platform.h"
+#if PL_CONFIG_USE_STMPE610
+  #include "McuSTMPE610config.h"
+#endif
+#if PL_CONFIG_USE_FT6206
+  #include "McuFT6206config.h"
+#endif
+
+#ifndef TOUCH_CONFIG_USE_INTERRUPT
+  #define TOUCH_CONFIG_USE_INTERRUPT  (((PL_CONFIG_USE_STMPE610 && MCUSTMPE610_CONFIG_USE_INT) || (PL_CONFIG_USE_FT6206 && MCUFT6206_CONFIG_USE_INT)))
+#endif
+  /*!< 1: the controller interrupt wakes up the input device. STMPE610: the samples are read into a queue and TOUCH_Poll() only dequeues. 0: TOUCH_Poll() reads the controller */
+
+#ifndef TOUCH_CONFIG_USE_FILTER
+  #define TOUCH_CONFIG_USE_FILTER     (1 && PL_CONFIG_USE_STMPE610)
+#endif
+  /*!< 1: resistive touch samples pass through the filter in TouchFilter.c. 0: samples are used as read */
+
+#ifndef TOUCH_CONFIG_USE_GESTURES
+  #define TOUCH_CONFIG_USE_GESTURES   (1 && PL_CONFIG_USE_FT6206)
+#endif
+  /*!< 1: the two point reports of the capacitive controller pass through the gesture recogniser in TouchGesture.c. 0: no gestures */
+
+#if TOUCH_CONFIG_USE_GESTURES
+  #include "TouchGesture.h"
+
+  /* called from the LVGL input device read, in the context of the GUI task */
+  typedef void (*TOUCH_GestureCallback)(const TouchGesture_Event_t *event);
+
+  void TOUCH_SetGestureCallback(TOUCH_GestureCallback callback);
+#endif
 
 bool TOUCH_HasMoreData(void);
 uint8_t TOUCH_Poll(bool *pressed, uint16_t *x, uint16_t *y);